@@ -0,0 +1,17 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BakedDecorations.h"
+
+ABakedDecorations::ABakedDecorations()
+{
+	PrimaryActorTick.bCanEverTick = false;
+    
+    Decorations = CreateDefaultSubobject<UPaperGroupedSpriteComponent>(TEXT("Decorations"));
+    SetRootComponent(Decorations);
+    
+    // The decorations are only drawn
+    Decorations->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    Decorations->SetGenerateOverlapEvents(false);
+    Decorations->SetCastShadow(false);
+}
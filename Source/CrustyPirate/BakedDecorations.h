@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+
+#include "PaperGroupedSpriteComponent.h"
+
+#include "BakedDecorations.generated.h"
+
+/**
+ * Draws the decorations of a level that do not animate with a single grouped sprite component (spawned by UTileBakeSubsystem)
+ */
+UCLASS(NotPlaceable)
+class CRUSTYPIRATE_API ABakedDecorations : public AActor
+{
+	GENERATED_BODY()
+	
+public:
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    UPaperGroupedSpriteComponent* Decorations;
+    
+	ABakedDecorations();
+};
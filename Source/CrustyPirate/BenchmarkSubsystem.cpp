@@ -0,0 +1,414 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BenchmarkSubsystem.h"
+
+#include "EngineUtils.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformMemory.h"
+#include "InputActionValue.h"
+
+#include "CrustyPirate.h"
+#include "InputLatencySubsystem.h"
+#include "MemoryReport.h"
+#include "PlayerCharacter.h"
+
+// Keeps the player alive so every level runs for the whole duration
+static const int BenchmarkPlayerHP = 1000000;
+
+// Runs to the right, jumping and attacking along the way
+static const TCHAR* DefaultBenchmarkScript = TEXT(
+    "0.0 Move 1\n"
+    "1.0 Jump\n"
+    "1.4 StopJump\n"
+    "2.0 Attack\n"
+    "3.0 Jump\n"
+    "3.2 Jump\n"
+    "3.6 StopJump\n"
+    "4.5 Move -1\n"
+    "5.0 Attack\n"
+    "5.5 Move 1\n"
+    "6.0 Jump\n"
+    "6.5 StopJump\n"
+    "7.0 Attack\n");
+
+// The script repeats every this many seconds
+static const float DefaultBenchmarkScriptLength = 8.0f;
+
+bool UBenchmarkSubsystem::IsBenchmarkRun()
+{
+    return FParse::Param(FCommandLine::Get(), TEXT("Benchmark"));
+}
+
+bool UBenchmarkSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+    return IsBenchmarkRun() && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UBenchmarkSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    const TCHAR* CommandLine = FCommandLine::Get();
+
+    FString Levels = TEXT("1,2,3");
+    FParse::Value(CommandLine, TEXT("BenchmarkLevels="), Levels);
+    TArray<FString> LevelNames;
+    Levels.ParseIntoArray(LevelNames, TEXT(","));
+    for (const FString& LevelName : LevelNames)
+    {
+        const int LevelIndex = FCString::Atoi(*LevelName);
+        if (LevelIndex > 0)
+        {
+            LevelIndices.Add(LevelIndex);
+        }
+    }
+
+    FParse::Value(CommandLine, TEXT("BenchmarkDuration="), Duration);
+
+    FString ScriptPath;
+    FParse::Value(CommandLine, TEXT("BenchmarkScript="), ScriptPath);
+    LoadScript(ScriptPath);
+
+    FCoreUObjectDelegates::PreLoadMap.AddUObject(this, &UBenchmarkSubsystem::OnPreLoadMap);
+    FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UBenchmarkSubsystem::OnPostLoadMap);
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Benchmark: %d levels, %.0f seconds each, %d script events"), LevelIndices.Num(), Duration, Script.Num());
+}
+
+void UBenchmarkSubsystem::Deinitialize()
+{
+    FCoreUObjectDelegates::PreLoadMap.RemoveAll(this);
+    FCoreUObjectDelegates::PostLoadMapWithWorld.RemoveAll(this);
+
+    Super::Deinitialize();
+}
+
+void UBenchmarkSubsystem::LoadScript(const FString& ScriptPath)
+{
+    FString ScriptText;
+    const bool HasScriptFile = !ScriptPath.IsEmpty() && FFileHelper::LoadFileToString(ScriptText, *ScriptPath);
+    if (!ScriptPath.IsEmpty() && !HasScriptFile)
+    {
+        UE_LOG(LogCrustyPirate, Warning, TEXT("Benchmark: could not read the script %s, using the default one"), *ScriptPath);
+    }
+
+    TArray<FString> Lines;
+    (HasScriptFile ? ScriptText : FString(DefaultBenchmarkScript)).ParseIntoArrayLines(Lines);
+
+    for (const FString& Line : Lines)
+    {
+        if (Line.StartsWith(TEXT("#"))) continue;
+
+        TArray<FString> Fields;
+        Line.ParseIntoArrayWS(Fields);
+        if (Fields.Num() < 2) continue;
+
+        Script.Add(FScriptEvent{ FCString::Atof(*Fields[0]), FName(*Fields[1]), Fields.Num() > 2 ? FCString::Atof(*Fields[2]) : 0.0f });
+    }
+
+    // Repeat the default script for the whole duration
+    if (!HasScriptFile)
+    {
+        const int NumEvents = Script.Num();
+        for (float Offset = DefaultBenchmarkScriptLength; Offset < Duration; Offset += DefaultBenchmarkScriptLength)
+        {
+            for (int Index = 0; Index < NumEvents; Index++)
+            {
+                FScriptEvent Event = Script[Index];
+                Event.Time += Offset;
+                Script.Add(Event);
+            }
+        }
+    }
+
+    Script.StableSort([](const FScriptEvent& A, const FScriptEvent& B) { return A.Time < B.Time; });
+}
+
+void UBenchmarkSubsystem::Tick(float DeltaTime)
+{
+    if (IsFinished || IsLoading) return;
+
+    UWorld* World = GetTickableGameObjectWorld();
+    if (!World || !World->IsGameWorld()) return;
+
+    if (!IsStarted)
+    {
+        IsStarted = true;
+        OpenNextLevel();
+        return;
+    }
+
+    if (!IsRunning)
+    {
+        OpenNextLevel();
+        return;
+    }
+
+    APlayerCharacter* Player = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerCharacter(World, 0));
+    if (!Player) return;
+
+    if (RunTime == 0.0f)
+    {
+        Player->UpdateHP(BenchmarkPlayerHP);
+    }
+
+    RunTime += DeltaTime;
+    DriveInput(Player);
+
+    // GGameThreadTime is only measured when stats are available, the frame time is used otherwise
+    const float GameThreadTime = FPlatformTime::ToMilliseconds(GGameThreadTime);
+    FrameTimes.Add(GameThreadTime > 0.0f ? GameThreadTime : DeltaTime * 1000.0f);
+
+    if (RunTime >= Duration)
+    {
+        RecordLevelMetrics(World);
+        IsRunning = false;
+    }
+}
+
+void UBenchmarkSubsystem::DriveInput(APlayerCharacter* Player)
+{
+    while (NextScriptEvent < Script.Num() && Script[NextScriptEvent].Time <= RunTime)
+    {
+        const FScriptEvent& Event = Script[NextScriptEvent++];
+
+        if (Event.Action == FName("Move"))
+        {
+            MoveValue = Event.Value;
+        }
+        else if (Event.Action == FName("Jump"))
+        {
+            Player->JumpStarted(FInputActionValue(true));
+        }
+        else if (Event.Action == FName("StopJump"))
+        {
+            Player->JumpEnded(FInputActionValue(false));
+        }
+        else if (Event.Action == FName("Attack"))
+        {
+            Player->Attack(FInputActionValue(true));
+        }
+    }
+
+    // The move action triggers every frame while it is held
+    if (MoveValue != 0.0f)
+    {
+        Player->Move(FInputActionValue(MoveValue));
+    }
+}
+
+void UBenchmarkSubsystem::OpenNextLevel()
+{
+    if (NextLevelSlot >= LevelIndices.Num())
+    {
+        Finish();
+        return;
+    }
+
+    CurrentLevelName = FString::Printf(TEXT("Level_%d"), LevelIndices[NextLevelSlot++]);
+    IsLoading = true;
+    LoadStartTime = FPlatformTime::Seconds();
+
+    UGameplayStatics::OpenLevel(GetTickableGameObjectWorld(), FName(CurrentLevelName));
+}
+
+void UBenchmarkSubsystem::OnPreLoadMap(const FString& MapName)
+{
+    // The script took the player through a level exit, keep what was measured so far while the level is still there
+    if (IsRunning && !IsLoading)
+    {
+        UE_LOG(LogCrustyPirate, Warning, TEXT("Benchmark: left %s after %.1f seconds"), *CurrentLevelName, RunTime);
+        RecordLevelMetrics(GetTickableGameObjectWorld());
+        IsRunning = false;
+    }
+}
+
+void UBenchmarkSubsystem::OnPostLoadMap(UWorld* LoadedWorld)
+{
+    if (IsLoading)
+    {
+        IsLoading = false;
+        Metrics.Add(FMetric{ CurrentLevelName, TEXT("LoadTimeMs"), (FPlatformTime::Seconds() - LoadStartTime) * 1000.0 });
+
+        IsRunning = true;
+        RunTime = 0.0f;
+        NextScriptEvent = 0;
+        MoveValue = 0.0f;
+        FrameTimes.Reset();
+    }
+}
+
+void UBenchmarkSubsystem::RecordLevelMetrics(UWorld* World)
+{
+    if (!World) return;
+
+    if (FrameTimes.Num() > 0)
+    {
+        FrameTimes.Sort();
+        const auto Percentile = [this](float Fraction) { return FrameTimes[FMath::Min(FMath::FloorToInt(Fraction * FrameTimes.Num()), FrameTimes.Num() - 1)]; };
+
+        Metrics.Add(FMetric{ CurrentLevelName, TEXT("FrameTimeP50Ms"), Percentile(0.5f) });
+        Metrics.Add(FMetric{ CurrentLevelName, TEXT("FrameTimeP90Ms"), Percentile(0.9f) });
+        Metrics.Add(FMetric{ CurrentLevelName, TEXT("FrameTimeP99Ms"), Percentile(0.99f) });
+        Metrics.Add(FMetric{ CurrentLevelName, TEXT("FrameTimeMaxMs"), FrameTimes.Last() });
+        Metrics.Add(FMetric{ CurrentLevelName, TEXT("Frames"), (double)FrameTimes.Num(), true });
+    }
+
+    // Tick functions left enabled per class (actors and their components)
+    TMap<FName, int> TickCounts;
+    for (TActorIterator<AActor> It(World); It; ++It)
+    {
+        if (It->PrimaryActorTick.IsTickFunctionEnabled())
+        {
+            TickCounts.FindOrAdd(It->GetClass()->GetFName())++;
+        }
+
+        for (const UActorComponent* Component : It->GetComponents())
+        {
+            if (Component && Component->PrimaryComponentTick.IsTickFunctionEnabled())
+            {
+                TickCounts.FindOrAdd(Component->GetClass()->GetFName())++;
+            }
+        }
+    }
+    TickCounts.KeySort(FNameLexicalLess());
+    for (const TPair<FName, int>& Pair : TickCounts)
+    {
+        Metrics.Add(FMetric{ CurrentLevelName, FString::Printf(TEXT("Ticks.%s"), *Pair.Key.ToString()), (double)Pair.Value });
+    }
+
+    const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+    Metrics.Add(FMetric{ CurrentLevelName, TEXT("PeakUsedPhysicalMB"), MemoryStats.PeakUsedPhysical / (1024.0 * 1024.0) });
+
+    // Latency of the scripted input, the run fails when an action is over the budget
+    if (const UInputLatencySubsystem* InputLatency = World->GetSubsystem<UInputLatencySubsystem>())
+    {
+        for (int Action = 0; Action < (int)EInputLatencyAction::Count; Action++)
+        {
+            const UInputLatencySubsystem::FHistogram& Histogram = InputLatency->GetHistogram((EInputLatencyAction)Action);
+            if (Histogram.NumSamples == 0) continue;
+
+            const TCHAR* ActionName = UInputLatencySubsystem::GetActionName((EInputLatencyAction)Action);
+            const int P95Frames = Histogram.GetFramesPercentile(0.95f);
+            Metrics.Add(FMetric{ CurrentLevelName, FString::Printf(TEXT("InputLatency.%s.P95Frames"), ActionName), (double)P95Frames });
+            Metrics.Add(FMetric{ CurrentLevelName, FString::Printf(TEXT("InputLatency.%s.MeanUs"), ActionName), Histogram.GetMeanMicroseconds() });
+            Metrics.Add(FMetric{ CurrentLevelName, FString::Printf(TEXT("InputLatency.%s.Timeouts"), ActionName), (double)Histogram.NumTimeouts });
+
+            if (P95Frames > UInputLatencySubsystem::GetBudgetFrames())
+            {
+                UE_LOG(LogCrustyPirate, Warning, TEXT("Benchmark: %s input latency on %s is %d frames (p95), the budget is %d frames"),
+                       ActionName,
+                       *CurrentLevelName,
+                       P95Frames,
+                       UInputLatencySubsystem::GetBudgetFrames());
+                NumBudgetFailures++;
+            }
+        }
+    }
+
+    // Memory of the gameplay classes per category, the budget warnings end up in the log of the run
+    FMemoryReport::PrintReport(World);
+    TArray<FMemoryReport::FCategory> MemoryCategories;
+    FMemoryReport::Gather(World, MemoryCategories);
+    for (const FMemoryReport::FCategory& Category : MemoryCategories)
+    {
+        Metrics.Add(FMetric{ CurrentLevelName, FString::Printf(TEXT("Memory.%sKB"), *Category.Name.ToString()), Category.Bytes / 1024.0 });
+    }
+}
+
+void UBenchmarkSubsystem::Finish()
+{
+    IsFinished = true;
+
+    FString Csv = TEXT("Level,Metric,Value\n");
+    for (const FMetric& Metric : Metrics)
+    {
+        Csv += FString::Printf(TEXT("%s,%s,%.3f\n"), *Metric.Level, *Metric.Name, Metric.Value);
+    }
+
+    FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmark/Benchmark.csv");
+    FParse::Value(FCommandLine::Get(), TEXT("BenchmarkOutput="), OutputPath);
+    if (!FFileHelper::SaveStringToFile(Csv, *OutputPath))
+    {
+        UE_LOG(LogCrustyPirate, Error, TEXT("Benchmark: could not write %s"), *OutputPath);
+    }
+    else
+    {
+        UE_LOG(LogCrustyPirate, Display, TEXT("Benchmark: %d metrics written to %s"), Metrics.Num(), *OutputPath);
+    }
+
+    int NumRegressions = 0;
+    FString BaselinePath;
+    if (FParse::Value(FCommandLine::Get(), TEXT("BenchmarkBaseline="), BaselinePath))
+    {
+        float Threshold = 0.1f;
+        FParse::Value(FCommandLine::Get(), TEXT("BenchmarkThreshold="), Threshold);
+        NumRegressions = CompareWithBaseline(BaselinePath, Threshold);
+    }
+
+    FPlatformMisc::RequestExitWithStatus(false, NumRegressions > 0 || NumBudgetFailures > 0 ? 1 : 0);
+}
+
+int UBenchmarkSubsystem::CompareWithBaseline(const FString& BaselinePath, float Threshold) const
+{
+    TArray<FString> Lines;
+    if (!FFileHelper::LoadFileToStringArray(Lines, *BaselinePath))
+    {
+        UE_LOG(LogCrustyPirate, Error, TEXT("Benchmark: could not read the baseline %s"), *BaselinePath);
+        return 1;
+    }
+
+    TMap<FString, double> Baseline;
+    for (const FString& Line : Lines)
+    {
+        TArray<FString> Fields;
+        Line.ParseIntoArray(Fields, TEXT(","));
+        if (Fields.Num() == 3 && Fields[0] != TEXT("Level"))
+        {
+            Baseline.Add(Fields[0] + TEXT(",") + Fields[1], FCString::Atod(*Fields[2]));
+        }
+    }
+
+    int NumRegressions = 0;
+    for (const FMetric& Metric : Metrics)
+    {
+        const double* BaselineValue = Baseline.Find(Metric.Level + TEXT(",") + Metric.Name);
+        if (!BaselineValue || *BaselineValue <= 0.0) continue;
+
+        const bool IsRegression = Metric.IsHigherBetter
+            ? Metric.Value < *BaselineValue * (1.0 - Threshold)
+            : Metric.Value > *BaselineValue * (1.0 + Threshold);
+        if (IsRegression)
+        {
+            NumRegressions++;
+            UE_LOG(LogCrustyPirate, Error, TEXT("Benchmark: %s %s regressed from %.3f to %.3f (%+.0f%%)"),
+                   *Metric.Level,
+                   *Metric.Name,
+                   *BaselineValue,
+                   Metric.Value,
+                   100.0 * (Metric.Value / *BaselineValue - 1.0));
+        }
+    }
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Benchmark: %d of %d metrics regressed by more than %.0f%% against %s"), NumRegressions, Metrics.Num(), Threshold * 100.0f, *BaselinePath);
+    return NumRegressions;
+}
+
+TStatId UBenchmarkSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UBenchmarkSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UBenchmarkSubsystem::GetTickableTickType() const
+{
+    // The class default object of the subsystem must not tick
+    return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Always;
+}
+
+UWorld* UBenchmarkSubsystem::GetTickableGameObjectWorld() const
+{
+    return GetGameInstance() ? GetGameInstance()->GetWorld() : nullptr;
+}
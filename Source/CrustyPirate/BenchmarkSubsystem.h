@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+
+#include "BenchmarkSubsystem.generated.h"
+
+class APlayerCharacter;
+
+/**
+ * Scripted playthrough benchmark, only created when the game is started with -Benchmark:
+ *   CrustyPirate -nullrhi -unattended -Benchmark [-BenchmarkLevels=1,2,3] [-BenchmarkDuration=30]
+ *       [-BenchmarkScript=Path] [-BenchmarkOutput=Path] [-BenchmarkBaseline=Path] [-BenchmarkThreshold=0.1]
+ * Every level is opened in turn and the player is driven by the input script for BenchmarkDuration seconds
+ * (lines of "<seconds> <Move|Jump|StopJump|Attack> [move value]", a default script runs to the right jumping
+ * and attacking). The load time, the game thread frame time percentiles, the enabled tick functions per class,
+ * the memory high water mark and the memory of the gameplay classes (see FMemoryReport) of every level are
+ * written to a CSV file (Level,Metric,Value).
+ * The latency of the scripted input is recorded too (see UInputLatencySubsystem).
+ * With a baseline CSV, every metric more than BenchmarkThreshold worse than its baseline is reported. The game exits
+ * with code 1 when a metric regressed or an input action went over its latency budget (0 otherwise).
+ */
+UCLASS()
+class CRUSTYPIRATE_API UBenchmarkSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+    virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    static bool IsBenchmarkRun();
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+    virtual ETickableTickType GetTickableTickType() const override;
+    virtual UWorld* GetTickableGameObjectWorld() const override;
+
+private:
+    struct FScriptEvent
+    {
+        float Time;
+        FName Action;
+        float Value;
+    };
+
+    struct FMetric
+    {
+        FString Level;
+        FString Name;
+        double Value;
+
+        // Most metrics are better when lower, the baseline comparison flips the others
+        bool IsHigherBetter = false;
+    };
+
+    void LoadScript(const FString& ScriptPath);
+
+    void OpenNextLevel();
+    void OnPreLoadMap(const FString& MapName);
+    void OnPostLoadMap(UWorld* LoadedWorld);
+
+    // Run the script events that are due and feed the held move input
+    void DriveInput(APlayerCharacter* Player);
+
+    // Add the metrics of the level that just ran
+    void RecordLevelMetrics(UWorld* World);
+
+    // Write the CSV, compare it with the baseline and exit
+    void Finish();
+
+    // Returns the number of metrics that regressed
+    int CompareWithBaseline(const FString& BaselinePath, float Threshold) const;
+
+    TArray<int> LevelIndices;
+    int NextLevelSlot = 0;
+    FString CurrentLevelName;
+
+    TArray<FScriptEvent> Script;
+    int NextScriptEvent = 0;
+    float MoveValue = 0.0f;
+
+    float Duration = 30.0f;
+    float RunTime = 0.0f;
+
+    bool IsStarted = false;
+    bool IsLoading = false;
+    bool IsRunning = false;
+    bool IsFinished = false;
+    double LoadStartTime = 0.0;
+
+    TArray<float> FrameTimes;
+    TArray<FMetric> Metrics;
+
+    // Levels whose input latency was over the budget (see UInputLatencySubsystem)
+    int NumBudgetFailures = 0;
+};
@@ -0,0 +1,37 @@
+
+#include "Checkpoint.h"
+
+#include "PlayerCharacter.h"
+#include "CheckpointSubsystem.h"
+
+ACheckpoint::ACheckpoint()
+{
+	PrimaryActorTick.bCanEverTick = false;
+    
+    BoxComp = CreateDefaultSubobject<UBoxComponent>(TEXT("BoxComp"));
+    SetRootComponent(BoxComp);
+
+}
+
+void ACheckpoint::BeginPlay()
+{
+	Super::BeginPlay();
+	
+    BoxComp->OnComponentBeginOverlap.AddDynamic(this, &ACheckpoint::OverlapBegin);
+}
+
+void ACheckpoint::OverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+    // Check if the actor that overlaps is the player
+    APlayerCharacter* Player = Cast<APlayerCharacter>(OtherActor);
+    if (Player && Player->IsAlive && Player->IsActive && !IsReached)
+    {
+        IsReached = true;
+        
+        // Respawn where the player entered the checkpoint, that location is known to fit the capsule
+        if (UCheckpointSubsystem* Checkpoints = GetWorld()->GetSubsystem<UCheckpointSubsystem>())
+        {
+            Checkpoints->SaveSnapshot(Player, Player->GetActorLocation());
+        }
+    }
+}
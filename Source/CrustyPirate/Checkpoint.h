@@ -0,0 +1,35 @@
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+
+#include "Components/BoxComponent.h"
+
+#include "Checkpoint.generated.h"
+
+/**
+ * Saves a snapshot of the level (see UCheckpointSubsystem) the first time the player walks through it.
+ * When the player dies afterwards the level is put back in that state and the player respawns here
+ * instead of restarting the game.
+ */
+UCLASS()
+class CRUSTYPIRATE_API ACheckpoint : public AActor
+{
+	GENERATED_BODY()
+	
+public:
+    UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
+    UBoxComponent* BoxComp;
+    
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    bool IsReached = false;
+    
+	ACheckpoint();
+
+	virtual void BeginPlay() override;
+    
+    UFUNCTION()
+    void OverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+};
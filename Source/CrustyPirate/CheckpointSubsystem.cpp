@@ -0,0 +1,213 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CheckpointSubsystem.h"
+
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+#include "CrustyPirate.h"
+#include "PlayerCharacter.h"
+#include "Enemy.h"
+#include "EnemyPoolSubsystem.h"
+#include "CollectableItem.h"
+#include "CollectableField.h"
+#include "LevelExit.h"
+
+// Bump when the layout of the snapshot changes
+static const int32 CheckpointSnapshotVersion = 1;
+
+static FAutoConsoleCommandWithWorld CheckpointStatsCommand(
+    TEXT("CrustyPirate.Checkpoint.Stats"),
+    TEXT("Print the size of the checkpoint snapshot and how long saving and restoring it took."),
+    FConsoleCommandWithWorldDelegate::CreateStatic(&UCheckpointSubsystem::PrintStats));
+
+void UCheckpointSubsystem::RegisterItem(ACollectableItem* Item)
+{
+    Items.Add(Item);
+}
+
+void UCheckpointSubsystem::RegisterField(ACollectableField* Field)
+{
+    Fields.Add(Field);
+}
+
+void UCheckpointSubsystem::RegisterExit(ALevelExit* Exit)
+{
+    Exits.Add(Exit);
+}
+
+void UCheckpointSubsystem::SaveSnapshot(APlayerCharacter* Player, const FVector& RespawnLocation)
+{
+    if (!Player || !Player->MyGameInstance) return;
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    Snapshot.Reset();
+    FMemoryWriter Writer(Snapshot);
+
+    int32 Version = CheckpointSnapshotVersion;
+    Writer << Version;
+
+    // Player
+    FVector3f Location(RespawnLocation);
+    int32 HitPoints = Player->HitPoints;
+    int32 DiamondCount = Player->MyGameInstance->CollectedDiamondCount;
+    uint8 IsDoubleJumpUnlocked = Player->MyGameInstance->IsDoubleJumpUnlocked ? 1 : 0;
+    Writer << Location << HitPoints << DiamondCount << IsDoubleJumpUnlocked;
+
+    // Enemies placed in the level, a dead enemy is stored with 0 HP
+    UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+    int32 NumSpawnPoints = EnemyPool ? EnemyPool->GetNumSpawnPoints() : 0;
+    Writer << NumSpawnPoints;
+    for (int Index = 0; Index < NumSpawnPoints; Index++)
+    {
+        const AEnemy* Enemy = EnemyPool->GetSpawnPointEnemy(Index);
+        const bool IsEnemyAlive = Enemy && Enemy->IsAlive;
+
+        int32 EnemyHitPoints = IsEnemyAlive ? Enemy->HitPoints : 0;
+        FVector3f EnemyLocation = IsEnemyAlive ? FVector3f(Enemy->GetActorLocation()) : FVector3f::ZeroVector;
+        Writer << EnemyHitPoints << EnemyLocation;
+    }
+
+    // Collectables, one bit per item
+    TBitArray<> IsItemCollected(false, Items.Num());
+    for (int Index = 0; Index < Items.Num(); Index++)
+    {
+        IsItemCollected[Index] = !Items[Index] || Items[Index]->IsCollected;
+    }
+    Writer << IsItemCollected;
+
+    int32 NumFields = Fields.Num();
+    Writer << NumFields;
+    for (ACollectableField* Field : Fields)
+    {
+        TBitArray<> IsFieldItemCollected = Field ? Field->GetCollectedItems() : TBitArray<>();
+        Writer << IsFieldItemCollected;
+    }
+
+    // Level exits
+    TBitArray<> IsExitActive(false, Exits.Num());
+    for (int Index = 0; Index < Exits.Num(); Index++)
+    {
+        IsExitActive[Index] = Exits[Index] && Exits[Index]->IsActive;
+    }
+    Writer << IsExitActive;
+
+    SaveCount++;
+    LastSaveTime = FPlatformTime::Seconds() - StartTime;
+}
+
+bool UCheckpointSubsystem::RestoreSnapshot(APlayerCharacter* Player)
+{
+    if (!Player || !Player->MyGameInstance || !HasSnapshot()) return false;
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    FMemoryReader Reader(Snapshot);
+
+    int32 Version = 0;
+    Reader << Version;
+    if (Version != CheckpointSnapshotVersion)
+    {
+        UE_LOG(LogCrustyPirate, Warning, TEXT("Checkpoint snapshot has version %d instead of %d, it is ignored"), Version, CheckpointSnapshotVersion);
+        return false;
+    }
+
+    FVector3f Location;
+    int32 HitPoints = 0;
+    int32 DiamondCount = 0;
+    uint8 IsDoubleJumpUnlocked = 0;
+    Reader << Location << HitPoints << DiamondCount << IsDoubleJumpUnlocked;
+
+    UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+    int32 NumSpawnPoints = 0;
+    Reader << NumSpawnPoints;
+    for (int Index = 0; Index < NumSpawnPoints; Index++)
+    {
+        int32 EnemyHitPoints = 0;
+        FVector3f EnemyLocation;
+        Reader << EnemyHitPoints << EnemyLocation;
+
+        if (EnemyPool)
+        {
+            EnemyPool->RestoreSpawnPoint(Index, EnemyHitPoints > 0, EnemyHitPoints, FVector(EnemyLocation));
+        }
+    }
+
+    TBitArray<> IsItemCollected;
+    Reader << IsItemCollected;
+    for (int Index = 0; Index < Items.Num() && Index < IsItemCollected.Num(); Index++)
+    {
+        ACollectableItem* Item = Items[Index];
+        if (!Item || Item->IsCollected == IsItemCollected[Index]) continue;
+
+        if (IsItemCollected[Index])
+        {
+            Item->DeactivateCollected();
+        }
+        else
+        {
+            Item->ReactivateCollected();
+        }
+    }
+
+    int32 NumFields = 0;
+    Reader << NumFields;
+    for (int Index = 0; Index < NumFields; Index++)
+    {
+        TBitArray<> IsFieldItemCollected;
+        Reader << IsFieldItemCollected;
+
+        if (Fields.IsValidIndex(Index) && Fields[Index])
+        {
+            Fields[Index]->RestoreCollectedItems(IsFieldItemCollected);
+        }
+    }
+
+    TBitArray<> IsExitActive;
+    Reader << IsExitActive;
+    for (int Index = 0; Index < Exits.Num() && Index < IsExitActive.Num(); Index++)
+    {
+        if (Exits[Index])
+        {
+            Exits[Index]->RestoreState(IsExitActive[Index]);
+        }
+    }
+
+    if (Reader.IsError())
+    {
+        UE_LOG(LogCrustyPirate, Warning, TEXT("Checkpoint snapshot of %d bytes could not be read"), Snapshot.Num());
+        return false;
+    }
+
+    // The game instance keeps the player state between levels, restore it before the player reads it back
+    Player->MyGameInstance->CollectedDiamondCount = DiamondCount;
+    Player->MyGameInstance->IsDoubleJumpUnlocked = IsDoubleJumpUnlocked != 0;
+    Player->Respawn(FVector(Location), HitPoints);
+
+    RestoreCount++;
+    LastRestoreTime = FPlatformTime::Seconds() - StartTime;
+    return true;
+}
+
+void UCheckpointSubsystem::PrintStats(UWorld* World)
+{
+    const UCheckpointSubsystem* Checkpoints = World ? World->GetSubsystem<UCheckpointSubsystem>() : nullptr;
+    if (!Checkpoints) return;
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Checkpoint: snapshot of %d bytes (%d items, %d fields, %d exits), saved %d times (last %.3f ms), restored %d times (last %.3f ms)"),
+           Checkpoints->Snapshot.Num(),
+           Checkpoints->Items.Num(),
+           Checkpoints->Fields.Num(),
+           Checkpoints->Exits.Num(),
+           Checkpoints->SaveCount,
+           Checkpoints->LastSaveTime * 1000.0,
+           Checkpoints->RestoreCount,
+           Checkpoints->LastRestoreTime * 1000.0);
+}
+
+bool UCheckpointSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
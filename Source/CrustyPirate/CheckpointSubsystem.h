@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "CheckpointSubsystem.generated.h"
+
+class APlayerCharacter;
+class ACollectableItem;
+class ACollectableField;
+class ALevelExit;
+
+/**
+ * Keeps a snapshot of the dynamic state of the level in a small byte buffer: the player location, HP,
+ * diamonds and double jump, the HP and location of the enemies placed in the level (see UEnemyPoolSubsystem),
+ * the collected items and the state of the level exits. A checkpoint saves the snapshot when the player
+ * reaches it, and when the player dies the snapshot is restored in place instead of reloading the map.
+ * Collectables and level exits register themselves when they begin play.
+ * The crab crowd is not part of the snapshot.
+ * "CrustyPirate.Checkpoint.Stats" prints the snapshot size and how long saving and restoring took.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UCheckpointSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    // Snapshot the level, the player comes back at RespawnLocation when the snapshot is restored
+    void SaveSnapshot(APlayerCharacter* Player, const FVector& RespawnLocation);
+
+    // Put the level back in the state of the last snapshot and respawn the player. Returns false when there is no snapshot
+    bool RestoreSnapshot(APlayerCharacter* Player);
+
+    bool HasSnapshot() const { return Snapshot.Num() > 0; }
+
+    int GetSnapshotSize() const { return Snapshot.Num(); }
+
+    // Called by the actors whose state is part of the snapshot when they begin play
+    void RegisterItem(ACollectableItem* Item);
+    void RegisterField(ACollectableField* Field);
+    void RegisterExit(ALevelExit* Exit);
+
+    static void PrintStats(UWorld* World);
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+    UPROPERTY()
+    TArray<TObjectPtr<ACollectableItem>> Items;
+
+    UPROPERTY()
+    TArray<TObjectPtr<ACollectableField>> Fields;
+
+    UPROPERTY()
+    TArray<TObjectPtr<ALevelExit>> Exits;
+
+    TArray<uint8> Snapshot;
+
+    int SaveCount = 0;
+    int RestoreCount = 0;
+    double LastSaveTime = 0.0;
+    double LastRestoreTime = 0.0;
+};
@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CollectableField.h"
+
+#include "Kismet/GameplayStatics.h"
+#include "Components/CapsuleComponent.h"
+
+#include "CheckpointSubsystem.h"
+#include "PlayerCharacter.h"
+#include "CrustyPirate.h"
+
+DECLARE_CYCLE_STAT(TEXT("Collectable Field Tick"), STAT_CollectableFieldTick, STATGROUP_CrustyPirate);
+
+ACollectableField::ACollectableField()
+{
+    LLM_SCOPE_BYTAG(CrustyPirate_Collectables);
+    
+	PrimaryActorTick.bCanEverTick = true;
+    
+    ItemSprites = CreateDefaultSubobject<UPaperGroupedSpriteComponent>(TEXT("ItemSprites"));
+    SetRootComponent(ItemSprites);
+    
+    // Pickups are found with the item grid, the sprites never collide
+    ItemSprites->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    ItemSprites->SetGenerateOverlapEvents(false);
+}
+
+void ACollectableField::OnConstruction(const FTransform& Transform)
+{
+    Super::OnConstruction(Transform);
+    
+    BuildInstances();
+}
+
+void ACollectableField::BuildInstances()
+{
+    ItemSprites->ClearInstances();
+    
+    if (!ItemSprite) return;
+    
+    for (const FVector& Location : ItemLocations)
+    {
+        ItemSprites->AddInstance(FTransform(Location), ItemSprite);
+    }
+}
+
+void ACollectableField::BeginPlay()
+{
+	Super::BeginPlay();
+    
+    LLM_SCOPE_BYTAG(CrustyPirate_Collectables);
+    
+    if (ItemSprites->GetInstanceCount() != ItemLocations.Num())
+    {
+        BuildInstances();
+    }
+    
+    const FTransform& FieldTransform = GetActorTransform();
+    
+    // Cells of about the size of the player so a query only looks at a few cells
+    ItemGrid.Reset(FMath::Max(PickupRadius * 8.0f, 1.0f));
+    ItemPositions.Reset(ItemLocations.Num());
+    IsCollected.Init(false, ItemLocations.Num());
+    NumCollected = 0;
+    FieldBounds.Init();
+    
+    for (int Index = 0; Index < ItemLocations.Num(); Index++)
+    {
+        const FVector Location = FieldTransform.TransformPosition(ItemLocations[Index]);
+        const FVector2D Position(Location.X, Location.Z);
+        
+        ItemPositions.Add(Position);
+        ItemGrid.Add(Index, Position);
+        FieldBounds += Position;
+    }
+    
+    FieldBounds = FieldBounds.ExpandBy(PickupRadius);
+    
+    if (UCheckpointSubsystem* Checkpoints = GetWorld()->GetSubsystem<UCheckpointSubsystem>())
+    {
+        Checkpoints->RegisterField(this);
+    }
+}
+
+void ACollectableField::RestoreCollectedItems(const TBitArray<>& Collected)
+{
+    bool AnyChanged = false;
+    for (int Index = 0; Index < IsCollected.Num(); Index++)
+    {
+        const bool ShouldBeCollected = Collected.IsValidIndex(Index) && Collected[Index];
+        if (IsCollected[Index] == ShouldBeCollected) continue;
+        
+        IsCollected[Index] = ShouldBeCollected;
+        AnyChanged = true;
+        
+        if (ShouldBeCollected)
+        {
+            NumCollected++;
+            ItemGrid.Remove(Index);
+            ItemSprites->UpdateInstanceTransform(Index, FTransform(FQuat::Identity, ItemLocations[Index], FVector::ZeroVector), false, false);
+        }
+        else
+        {
+            NumCollected--;
+            ItemGrid.Add(Index, ItemPositions[Index]);
+            ItemSprites->UpdateInstanceTransform(Index, FTransform(ItemLocations[Index]), false, false);
+        }
+    }
+    
+    if (AnyChanged)
+    {
+        ItemSprites->MarkRenderStateDirty();
+    }
+}
+
+void ACollectableField::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+    
+    SCOPE_CYCLE_COUNTER(STAT_CollectableFieldTick);
+    
+    if (NumCollected >= ItemLocations.Num()) return;
+    
+    APlayerCharacter* Player = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerCharacter(GetWorld(), 0));
+    if (!Player || !Player->IsAlive) return;
+    
+    const FBoxSphereBounds& PlayerBounds = Player->GetCapsuleComponent()->Bounds;
+    const FVector2D PlayerCenter(PlayerBounds.Origin.X, PlayerBounds.Origin.Z);
+    const FVector2D PlayerExtent(PlayerBounds.BoxExtent.X, PlayerBounds.BoxExtent.Z);
+    
+    // Nothing to do while the player is away from the field
+    if (!FieldBounds.Intersect(FBox2D(PlayerCenter - PlayerExtent, PlayerCenter + PlayerExtent))) return;
+    
+    Candidates.Reset();
+    ItemGrid.Query(PlayerCenter, PlayerExtent.GetMax() + PickupRadius, Candidates);
+    
+    bool AnyCollected = false;
+    for (int Index : Candidates)
+    {
+        const FVector2D Offset = ItemPositions[Index] - PlayerCenter;
+        if (FMath::Abs(Offset.X) > PlayerExtent.X + PickupRadius || FMath::Abs(Offset.Y) > PlayerExtent.Y + PickupRadius) continue;
+        
+        IsCollected[Index] = true;
+        NumCollected++;
+        ItemGrid.Remove(Index);
+        
+        // Hide the instance (the render state is updated once below)
+        ItemSprites->UpdateInstanceTransform(Index, FTransform(FQuat::Identity, ItemLocations[Index], FVector::ZeroVector), false, false);
+        AnyCollected = true;
+        
+        Player->CollectItem(Type);
+    }
+    
+    if (AnyCollected)
+    {
+        ItemSprites->MarkRenderStateDirty();
+    }
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+
+#include "PaperGroupedSpriteComponent.h"
+#include "PaperSprite.h"
+
+#include "CollectableItem.h"
+#include "SpatialGrid2D.h"
+
+#include "CollectableField.generated.h"
+
+/**
+ * Many collectables of the same type drawn by one grouped sprite component, without any physics body.
+ * Every frame the items near the player are looked up in a spatial grid and the ones overlapping the
+ * bounds of its capsule are collected and hidden.
+ * Use it for trails of diamonds instead of placing one ACollectableItem per diamond (the items do not animate).
+ */
+UCLASS()
+class CRUSTYPIRATE_API ACollectableField : public AActor
+{
+	GENERATED_BODY()
+	
+public:
+    UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
+    UPaperGroupedSpriteComponent* ItemSprites;
+    
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    CollectableType Type;
+    
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    UPaperSprite* ItemSprite;
+    
+    // Location of every item relative to the field
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (MakeEditWidget = true))
+    TArray<FVector> ItemLocations;
+    
+    // Half size of an item, the player collects it when its capsule bounds get this close
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float PickupRadius = 16.0f;
+    
+	ACollectableField();
+    
+    virtual void OnConstruction(const FTransform& Transform) override;
+
+	virtual void BeginPlay() override;
+    
+	virtual void Tick(float DeltaTime) override;
+    
+    int GetNumItemsLeft() const { return ItemLocations.Num() - NumCollected; }
+    
+    bool IsItemCollected(int Index) const { return IsCollected.IsValidIndex(Index) && IsCollected[Index]; }
+    
+    const TBitArray<>& GetCollectedItems() const { return IsCollected; }
+    
+    // Show or hide the items so that exactly the given ones are collected (used when a checkpoint is restored)
+    void RestoreCollectedItems(const TBitArray<>& Collected);
+    
+private:
+    // Create one sprite instance per item location
+    void BuildInstances();
+    
+    FSpatialGrid2D ItemGrid;
+    
+    // World position (X/Z) of every item
+    TArray<FVector2D> ItemPositions;
+    
+    TBitArray<> IsCollected;
+    
+    int NumCollected = 0;
+    
+    // Area covered by the items (X/Z), grown by the pickup radius
+    FBox2D FieldBounds;
+    
+    TArray<int> Candidates;
+};
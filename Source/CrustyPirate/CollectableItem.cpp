@@ -1,11 +1,18 @@
 
 #include "CollectableItem.h"
 
+#include "CheckpointSubsystem.h"
 #include "PlayerCharacter.h"
+#include "TickLODSubsystem.h"
+#include "CrustyPirate.h"
+
+DECLARE_CYCLE_STAT(TEXT("Collectable Overlap"), STAT_CollectableOverlap, STATGROUP_CrustyPirate);
 
 ACollectableItem::ACollectableItem()
 {
-	PrimaryActorTick.bCanEverTick = true;
+    LLM_SCOPE_BYTAG(CrustyPirate_Collectables);
+    
+	PrimaryActorTick.bCanEverTick = false;
     
     CapsuleComp = CreateDefaultSubobject<UCapsuleComponent>(TEXT("CapsuleComp"));
     SetRootComponent(CapsuleComp);
@@ -18,26 +25,74 @@ ACollectableItem::ACollectableItem()
 void ACollectableItem::BeginPlay()
 {
 	Super::BeginPlay();
+    
+    LLM_SCOPE_BYTAG(CrustyPirate_Collectables);
 	
     CapsuleComp->OnComponentBeginOverlap.AddDynamic(this, &ACollectableItem::OverlapBegin);
+    
+    // Stop animating the item while it is away from the camera
+    if (UTickLODSubsystem* TickLOD = GetWorld()->GetSubsystem<UTickLODSubsystem>())
+    {
+        TickLOD->RegisterActor(this);
+    }
+    
+    if (UCheckpointSubsystem* Checkpoints = GetWorld()->GetSubsystem<UCheckpointSubsystem>())
+    {
+        Checkpoints->RegisterItem(this);
+    }
 }
 
-void ACollectableItem::Tick(float DeltaTime)
+void ACollectableItem::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
-
+    if (UTickLODSubsystem* TickLOD = GetWorld()->GetSubsystem<UTickLODSubsystem>())
+    {
+        TickLOD->UnregisterActor(this);
+    }
+    
+    Super::EndPlay(EndPlayReason);
 }
 
 void ACollectableItem::OverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+    SCOPE_CYCLE_COUNTER(STAT_CollectableOverlap);
+    
     // Check if the actor that overlaps is the player
     APlayerCharacter* Player = Cast<APlayerCharacter>(OtherActor);
-    if (Player && Player->IsAlive)
+    if (Player && Player->IsAlive && !IsCollected)
     {
         Player->CollectItem(Type);
-        // After the item is collected destroy it
-        Destroy();
+        // After the item is collected hide it (destroying it would cost an actor teardown and garbage to collect)
+        DeactivateCollected();
     }
     
 }
 
+void ACollectableItem::DeactivateCollected()
+{
+    IsCollected = true;
+    
+    // Leave the tick LOD first, it gives the components their tick back when unregistering
+    if (UTickLODSubsystem* TickLOD = GetWorld()->GetSubsystem<UTickLODSubsystem>())
+    {
+        TickLOD->UnregisterActor(this);
+    }
+    
+    SetActorHiddenInGame(true);
+    SetActorEnableCollision(false);
+    ItemFlipbook->Deactivate();
+}
+
+void ACollectableItem::ReactivateCollected()
+{
+    IsCollected = false;
+    
+    SetActorHiddenInGame(false);
+    SetActorEnableCollision(true);
+    ItemFlipbook->Activate(true);
+    
+    if (UTickLODSubsystem* TickLOD = GetWorld()->GetSubsystem<UTickLODSubsystem>())
+    {
+        TickLOD->RegisterActor(this);
+    }
+}
+
@@ -31,13 +31,23 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     CollectableType Type;
     
+    // Collected items stay in the level, hidden and without collision, instead of being destroyed
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    bool IsCollected = false;
+    
 	ACollectableItem();
 
 	virtual void BeginPlay() override;
-
-	virtual void Tick(float DeltaTime) override;
+    
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
     
     UFUNCTION()
     void OverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+    
+    // Hide the item and stop its components
+    void DeactivateCollected();
+    
+    // Show the item again so it can be collected (used when a checkpoint is restored)
+    void ReactivateCollected();
 
 };
@@ -0,0 +1,251 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CombatSubsystem.h"
+
+#include "Components/BoxComponent.h"
+
+#include "CrustyPirate.h"
+#include "Enemy.h"
+#include "FixedStepSubsystem.h"
+#include "PlayerCharacter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Combat Resolve"), STAT_CombatResolve, STATGROUP_CrustyPirate);
+DECLARE_CYCLE_STAT(TEXT("Combat Attack Sweeps"), STAT_CombatAttackSweeps, STATGROUP_CrustyPirate);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hits Queued"), STAT_HitsQueued, STATGROUP_CrustyPirate);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Victims Hit"), STAT_VictimsHit, STATGROUP_CrustyPirate);
+
+static FAutoConsoleCommandWithWorld CombatStatsCommand(
+    TEXT("CrustyPirate.Combat.Stats"),
+    TEXT("Print the hit counters of the combat resolver."),
+    FConsoleCommandWithWorldDelegate::CreateStatic(&UCombatSubsystem::PrintStats));
+
+int UCombatSubsystem::BeginSwing(AActor* Attacker)
+{
+    const int SwingId = NewSwingId();
+    ActiveSwings.Add(Attacker, SwingId);
+    return SwingId;
+}
+
+void UCombatSubsystem::QueueHit(AActor* Attacker, AActor* Victim, int SwingId, int DamageAmount, float StunDuration)
+{
+    if (!Victim) return;
+
+    HitsQueuedThisFrame++;
+
+    // The attack box can overlap the same victim several times during one swing
+    bool AlreadyHit = false;
+    ResolvedHits.Add(FCombatHitKey{ Attacker, Victim, SwingId }, &AlreadyHit);
+    if (AlreadyHit)
+    {
+        HitsDroppedThisFrame++;
+        return;
+    }
+
+    QueuedHits.Add(FQueuedHit{ Victim, DamageAmount, StunDuration });
+}
+
+void UCombatSubsystem::OpenAttackWindow(AActor* Attacker, UBoxComponent* AttackBox, TSubclassOf<AActor> VictimClass, int SwingId, int DamageAmount, float StunDuration)
+{
+    if (!Attacker || !AttackBox) return;
+
+    FAttackWindow* Window = AttackWindows.FindByPredicate([Attacker](const FAttackWindow& Other) { return Other.Attacker == Attacker; });
+    if (!Window)
+    {
+        Window = &AttackWindows.AddDefaulted_GetRef();
+        Window->Attacker = Attacker;
+    }
+
+    Window->AttackBox = AttackBox;
+    Window->VictimClass = VictimClass;
+    Window->SwingId = SwingId;
+    Window->DamageAmount = DamageAmount;
+    Window->StunDuration = StunDuration;
+    Window->PreviousLocation = AttackBox->GetComponentLocation();
+}
+
+void UCombatSubsystem::CloseAttackWindow(AActor* Attacker)
+{
+    const int Index = AttackWindows.IndexOfByPredicate([Attacker](const FAttackWindow& Window) { return Window.Attacker == Attacker; });
+    if (Index != INDEX_NONE)
+    {
+        AttackWindows.RemoveAtSwap(Index);
+    }
+}
+
+void UCombatSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    // The fixed step subsystem resolves the hits in its steps
+    const UFixedStepSubsystem* FixedStep = GetWorld()->GetSubsystem<UFixedStepSubsystem>();
+    if (FixedStep && FixedStep->IsEnabled()) return;
+
+    ResolveHits();
+}
+
+void UCombatSubsystem::ResolveHits()
+{
+    SCOPE_CYCLE_COUNTER(STAT_CombatResolve);
+
+    SweepAttackWindows();
+
+    // Sum the hits up per victim, keeping the order in which the victims were first hit
+    VictimHits.Reset();
+    VictimIndices.Reset();
+    for (const FQueuedHit& Hit : QueuedHits)
+    {
+        AActor* Victim = Hit.Victim.Get();
+        if (!Victim) continue;
+
+        if (const int* Index = VictimIndices.Find(Victim))
+        {
+            FQueuedHit& Total = VictimHits[*Index];
+            Total.DamageAmount += Hit.DamageAmount;
+            Total.StunDuration = FMath::Max(Total.StunDuration, Hit.StunDuration);
+        }
+        else
+        {
+            VictimIndices.Add(Victim, VictimHits.Add(Hit));
+        }
+    }
+    QueuedHits.Reset();
+
+    for (const FQueuedHit& Total : VictimHits)
+    {
+        if (AActor* Victim = Total.Victim.Get())
+        {
+            ApplyHits(Victim, Total.DamageAmount, Total.StunDuration);
+        }
+    }
+
+    SET_DWORD_STAT(STAT_HitsQueued, HitsQueuedThisFrame);
+    SET_DWORD_STAT(STAT_VictimsHit, VictimHits.Num());
+
+    HitsQueuedLastFrame = HitsQueuedThisFrame;
+    HitsDroppedLastFrame = HitsDroppedThisFrame;
+    VictimsHitLastFrame = VictimHits.Num();
+    AttackQueriesLastFrame = AttackQueriesThisFrame;
+    TotalHitsQueued += HitsQueuedThisFrame;
+    TotalVictimsHit += VictimHits.Num();
+    HitsQueuedThisFrame = 0;
+    HitsDroppedThisFrame = 0;
+    AttackQueriesThisFrame = 0;
+
+    PruneResolvedHits();
+}
+
+void UCombatSubsystem::SweepAttackWindows()
+{
+    SCOPE_CYCLE_COUNTER(STAT_CombatAttackSweeps);
+
+    UWorld* World = GetWorld();
+
+    // Go backwards since windows of destroyed attackers are removed
+    for (int Index = AttackWindows.Num() - 1; Index >= 0; Index--)
+    {
+        FAttackWindow& Window = AttackWindows[Index];
+        AActor* Attacker = Window.Attacker.Get();
+        const UBoxComponent* AttackBox = Window.AttackBox.Get();
+        if (!Attacker || !AttackBox)
+        {
+            AttackWindows.RemoveAtSwap(Index);
+            continue;
+        }
+
+        const FVector Location = AttackBox->GetComponentLocation();
+        const FQuat Rotation = AttackBox->GetComponentQuat();
+        const FCollisionShape Shape = FCollisionShape::MakeBox(AttackBox->GetScaledBoxExtent());
+
+        FCollisionQueryParams Params(SCENE_QUERY_STAT(AttackSweep), false, Attacker);
+        AttackQueriesThisFrame++;
+
+        // Sweep the path of the box since the last frame so fast swings cannot skip over a victim.
+        // A box that did not move only needs an overlap test
+        if (Location.Equals(Window.PreviousLocation))
+        {
+            OverlapHits.Reset();
+            World->OverlapMultiByChannel(OverlapHits, Location, Rotation, ECC_AttackHit, Shape, Params);
+            for (const FOverlapResult& Overlap : OverlapHits)
+            {
+                AActor* Victim = Overlap.GetActor();
+                if (Victim && Victim->IsA(Window.VictimClass))
+                {
+                    QueueHit(Attacker, Victim, Window.SwingId, Window.DamageAmount, Window.StunDuration);
+                }
+            }
+        }
+        else
+        {
+            SweepHits.Reset();
+            World->SweepMultiByChannel(SweepHits, Window.PreviousLocation, Location, Rotation, ECC_AttackHit, Shape, Params);
+            for (const FHitResult& Hit : SweepHits)
+            {
+                AActor* Victim = Hit.GetActor();
+                if (Victim && Victim->IsA(Window.VictimClass))
+                {
+                    QueueHit(Attacker, Victim, Window.SwingId, Window.DamageAmount, Window.StunDuration);
+                }
+            }
+        }
+
+        Window.PreviousLocation = Location;
+    }
+}
+
+void UCombatSubsystem::ApplyHits(AActor* Victim, int DamageAmount, float StunDuration)
+{
+    if (AEnemy* Enemy = Cast<AEnemy>(Victim))
+    {
+        Enemy->TakeHit(DamageAmount, StunDuration);
+    }
+    else if (APlayerCharacter* Player = Cast<APlayerCharacter>(Victim))
+    {
+        Player->TakeHit(DamageAmount, StunDuration);
+    }
+}
+
+void UCombatSubsystem::PruneResolvedHits()
+{
+    for (auto It = ActiveSwings.CreateIterator(); It; ++It)
+    {
+        if (!It.Key().ResolveObjectPtr())
+        {
+            It.RemoveCurrent();
+        }
+    }
+
+    for (auto It = ResolvedHits.CreateIterator(); It; ++It)
+    {
+        const int* ActiveSwing = ActiveSwings.Find(It->Attacker);
+        if (!ActiveSwing || *ActiveSwing != It->SwingId)
+        {
+            It.RemoveCurrent();
+        }
+    }
+}
+
+void UCombatSubsystem::PrintStats(UWorld* World)
+{
+    const UCombatSubsystem* Combat = World ? World->GetSubsystem<UCombatSubsystem>() : nullptr;
+    if (!Combat) return;
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Combat: last frame %d hits queued, %d dropped as duplicates, %d victims hit, %d attack queries (%d windows open). Total %lld hits queued, %lld victims hit"),
+           Combat->HitsQueuedLastFrame,
+           Combat->HitsDroppedLastFrame,
+           Combat->VictimsHitLastFrame,
+           Combat->AttackQueriesLastFrame,
+           Combat->AttackWindows.Num(),
+           Combat->TotalHitsQueued,
+           Combat->TotalVictimsHit);
+}
+
+TStatId UCombatSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatSubsystem, STATGROUP_Tickables);
+}
+
+bool UCombatSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "Engine/HitResult.h"
+#include "Engine/OverlapResult.h"
+
+#include "CombatSubsystem.generated.h"
+
+class UBoxComponent;
+
+/**
+ * Identifies one hit: the same attack swing of an attacker can only hit a victim once
+ */
+struct FCombatHitKey
+{
+    TObjectKey<AActor> Attacker;
+    TObjectKey<AActor> Victim;
+    int SwingId = 0;
+
+    bool operator==(const FCombatHitKey& Other) const
+    {
+        return Attacker == Other.Attacker && Victim == Other.Victim && SwingId == Other.SwingId;
+    }
+
+    friend uint32 GetTypeHash(const FCombatHitKey& Key)
+    {
+        return HashCombine(HashCombine(GetTypeHash(Key.Attacker), GetTypeHash(Key.Victim)), ::GetTypeHash(Key.SwingId));
+    }
+};
+
+/**
+ * Resolves the hits of the player, the enemies and the crab crowd in one pass per frame.
+ * The attack boxes only queue hits from their overlap events. Duplicate hits of the same swing on the
+ * same victim are dropped, and every victim then takes a single TakeHit with the summed damage and the
+ * longest stun, so the stun, HP text, HUD and animation updates happen once per victim and frame.
+ * Attackers using attack sweeps open an attack window instead of enabling the collision of their attack box.
+ * While the window is open the box is swept every frame from where it was on the previous frame to where
+ * it is now against the AttackHit channel, so no collision state is changed during a swing.
+ * "CrustyPirate.Combat.Stats" prints the hit counters.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UCombatSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    // Start a new attack swing of the attacker and return its id (hits of older swings are forgotten)
+    int BeginSwing(AActor* Attacker);
+
+    // A swing id for hits without an attacker actor (such as the crab crowd)
+    int NewSwingId() { return ++LastSwingId; }
+
+    // Queue a hit, it is applied when the subsystem ticks
+    void QueueHit(AActor* Attacker, AActor* Victim, int SwingId, int DamageAmount, float StunDuration);
+
+    // Sweep the attack box every frame and hit the actors of VictimClass it touches, until the window is closed
+    void OpenAttackWindow(AActor* Attacker, UBoxComponent* AttackBox, TSubclassOf<AActor> VictimClass, int SwingId, int DamageAmount, float StunDuration);
+    void CloseAttackWindow(AActor* Attacker);
+
+    // Counters of the last resolved frame
+    int GetHitsQueuedLastFrame() const { return HitsQueuedLastFrame; }
+    int GetHitsDroppedLastFrame() const { return HitsDroppedLastFrame; }
+    int GetVictimsHitLastFrame() const { return VictimsHitLastFrame; }
+    int GetAttackQueriesLastFrame() const { return AttackQueriesLastFrame; }
+
+    // Counters since the world started
+    int64 GetTotalHitsQueued() const { return TotalHitsQueued; }
+    int64 GetTotalVictimsHit() const { return TotalVictimsHit; }
+
+    // Sweep the attack windows and apply the queued hits (every frame, or every step of UFixedStepSubsystem)
+    void ResolveHits();
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    static void PrintStats(UWorld* World);
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+    struct FQueuedHit
+    {
+        TWeakObjectPtr<AActor> Victim;
+        int DamageAmount;
+        float StunDuration;
+    };
+
+    struct FAttackWindow
+    {
+        TWeakObjectPtr<AActor> Attacker;
+        TWeakObjectPtr<UBoxComponent> AttackBox;
+        TSubclassOf<AActor> VictimClass;
+        int SwingId;
+        int DamageAmount;
+        float StunDuration;
+
+        // Where the box was when it was last queried
+        FVector PreviousLocation;
+    };
+
+    // Query the open attack windows and queue the hits they find
+    void SweepAttackWindows();
+
+    void ApplyHits(AActor* Victim, int DamageAmount, float StunDuration);
+
+    // Forget the hits of swings that are over
+    void PruneResolvedHits();
+
+    TArray<FQueuedHit> QueuedHits;
+
+    // Hits already queued during the current swing of their attacker
+    TSet<FCombatHitKey> ResolvedHits;
+
+    // The current swing of every attacker
+    TMap<TObjectKey<AActor>, int> ActiveSwings;
+
+    // The damage and stun summed up per victim (reused every frame)
+    TArray<FQueuedHit> VictimHits;
+    TMap<TObjectKey<AActor>, int> VictimIndices;
+
+    TArray<FAttackWindow> AttackWindows;
+
+    // Scratch arrays of the attack queries
+    TArray<FHitResult> SweepHits;
+    TArray<FOverlapResult> OverlapHits;
+
+    int LastSwingId = 0;
+
+    int HitsQueuedThisFrame = 0;
+    int HitsDroppedThisFrame = 0;
+    int AttackQueriesThisFrame = 0;
+
+    int HitsQueuedLastFrame = 0;
+    int HitsDroppedLastFrame = 0;
+    int VictimsHitLastFrame = 0;
+    int AttackQueriesLastFrame = 0;
+
+    int64 TotalHitsQueued = 0;
+    int64 TotalVictimsHit = 0;
+};
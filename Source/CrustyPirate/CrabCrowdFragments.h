@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+
+#include "CrabCrowdFragments.generated.h"
+
+/**
+ * Mass fragments of the crabs simulated by the crab crowd (see UCrabCrowdSubsystem).
+ * The position of a crab is kept in the standard FTransformFragment.
+ */
+
+USTRUCT()
+struct CRUSTYPIRATE_API FCrabHealthFragment : public FMassFragment
+{
+    GENERATED_BODY()
+
+    // Carried over to the AEnemy when the crab is promoted. Only actors take hits, so a crab dies as an actor
+    int HitPoints = 100;
+};
+
+USTRUCT()
+struct CRUSTYPIRATE_API FCrabTimerFragment : public FMassFragment
+{
+    GENERATED_BODY()
+
+    float StunTimeLeft = 0.0f;
+    float AttackCoolDownLeft = 0.0f;
+};
+
+USTRUCT()
+struct CRUSTYPIRATE_API FCrabFacingFragment : public FMassFragment
+{
+    GENERATED_BODY()
+
+    // -1 when facing left, +1 when facing right
+    float Direction = 1.0f;
+};
+
+USTRUCT()
+struct CRUSTYPIRATE_API FCrabTargetFragment : public FMassFragment
+{
+    GENERATED_BODY()
+
+    // True when the player is within the detection radius of the crab
+    bool HasTarget = false;
+
+    // Signed distance along X from the crab to the player
+    float OffsetToTarget = 0.0f;
+};
+
+/** Settings copied from the AEnemy class the crab promotes to */
+USTRUCT()
+struct CRUSTYPIRATE_API FCrabSettingsFragment : public FMassFragment
+{
+    GENERATED_BODY()
+
+    // Index of the enemy class in UCrabCrowdSubsystem::CrabClasses
+    int ClassIndex = 0;
+
+    float MoveSpeed = 300.0f;
+    float DetectionRadius = 300.0f;
+    float StopDistanceToTarget = 70.0f;
+    float AttackCoolDownInSeconds = 3.0f;
+    int AttackDamage = 25;
+    float AttackStunDuration = 0.3f;
+};
+
+// The crab is currently represented by an AEnemy actor, the processors leave it alone
+USTRUCT()
+struct CRUSTYPIRATE_API FCrabPromotedTag : public FMassTag
+{
+    GENERATED_BODY()
+};
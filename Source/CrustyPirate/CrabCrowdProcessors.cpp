@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CrabCrowdProcessors.h"
+
+#include "MassCommonFragments.h"
+#include "MassExecutionContext.h"
+
+#include "CrabCrowdFragments.h"
+#include "CrabCrowdSubsystem.h"
+
+UCrabChaseProcessor::UCrabChaseProcessor()
+    : EntityQuery(*this)
+{
+    ExecutionFlags = (int32)EProcessorExecutionFlags::All;
+    ProcessingPhase = EMassProcessingPhase::PrePhysics;
+}
+
+void UCrabChaseProcessor::ConfigureQueries()
+{
+    EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite);
+    EntityQuery.AddRequirement<FCrabTargetFragment>(EMassFragmentAccess::ReadWrite);
+    EntityQuery.AddRequirement<FCrabFacingFragment>(EMassFragmentAccess::ReadWrite);
+    EntityQuery.AddRequirement<FCrabTimerFragment>(EMassFragmentAccess::ReadOnly);
+    EntityQuery.AddRequirement<FCrabSettingsFragment>(EMassFragmentAccess::ReadOnly);
+    EntityQuery.AddTagRequirement<FCrabPromotedTag>(EMassFragmentPresence::None);
+}
+
+void UCrabChaseProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+    const UWorld* World = EntityManager.GetWorld();
+    const UCrabCrowdSubsystem* Crowd = World ? World->GetSubsystem<UCrabCrowdSubsystem>() : nullptr;
+    if (!Crowd) return;
+
+    const bool HasPlayer = Crowd->HasPlayer;
+    const float PlayerX = Crowd->PlayerX;
+
+    EntityQuery.ForEachEntityChunk(EntityManager, Context, [HasPlayer, PlayerX](FMassExecutionContext& Context)
+    {
+        const int32 NumEntities = Context.GetNumEntities();
+        const float DeltaTime = Context.GetDeltaTimeSeconds();
+
+        const TArrayView<FTransformFragment> Transforms = Context.GetMutableFragmentView<FTransformFragment>();
+        const TArrayView<FCrabTargetFragment> Targets = Context.GetMutableFragmentView<FCrabTargetFragment>();
+        const TArrayView<FCrabFacingFragment> Facings = Context.GetMutableFragmentView<FCrabFacingFragment>();
+        const TConstArrayView<FCrabTimerFragment> Timers = Context.GetFragmentView<FCrabTimerFragment>();
+        const TConstArrayView<FCrabSettingsFragment> Settings = Context.GetFragmentView<FCrabSettingsFragment>();
+
+        for (int32 Index = 0; Index < NumEntities; Index++)
+        {
+            FTransform& Transform = Transforms[Index].GetMutableTransform();
+            FVector Location = Transform.GetLocation();
+
+            // The player is detected when it is within the detection radius of the crab
+            FCrabTargetFragment& Target = Targets[Index];
+            Target.OffsetToTarget = PlayerX - Location.X;
+            Target.HasTarget = HasPlayer && FMath::Abs(Target.OffsetToTarget) <= Settings[Index].DetectionRadius;
+
+            if (!Target.HasTarget || Timers[Index].StunTimeLeft > 0.0f) continue;
+
+            const float MoveDirection = Target.OffsetToTarget > 0.0f ? 1.0f : -1.0f;
+            Facings[Index].Direction = MoveDirection;
+
+            // Move to target if not close enough
+            if (FMath::Abs(Target.OffsetToTarget) > Settings[Index].StopDistanceToTarget)
+            {
+                Location.X += MoveDirection * Settings[Index].MoveSpeed * DeltaTime;
+                Transform.SetLocation(Location);
+            }
+        }
+    });
+}
+
+UCrabAttackProcessor::UCrabAttackProcessor()
+    : EntityQuery(*this)
+{
+    ExecutionFlags = (int32)EProcessorExecutionFlags::All;
+    ProcessingPhase = EMassProcessingPhase::PrePhysics;
+    ExecutionOrder.ExecuteAfter.Add(UCrabChaseProcessor::StaticClass()->GetFName());
+
+    // Hits are handed to the crab crowd subsystem
+    bRequiresGameThreadExecution = true;
+}
+
+void UCrabAttackProcessor::ConfigureQueries()
+{
+    EntityQuery.AddRequirement<FCrabTimerFragment>(EMassFragmentAccess::ReadWrite);
+    EntityQuery.AddRequirement<FCrabTargetFragment>(EMassFragmentAccess::ReadOnly);
+    EntityQuery.AddRequirement<FCrabSettingsFragment>(EMassFragmentAccess::ReadOnly);
+    EntityQuery.AddTagRequirement<FCrabPromotedTag>(EMassFragmentPresence::None);
+}
+
+void UCrabAttackProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+    UWorld* World = EntityManager.GetWorld();
+    UCrabCrowdSubsystem* Crowd = World ? World->GetSubsystem<UCrabCrowdSubsystem>() : nullptr;
+    if (!Crowd) return;
+
+    EntityQuery.ForEachEntityChunk(EntityManager, Context, [Crowd](FMassExecutionContext& Context)
+    {
+        const int32 NumEntities = Context.GetNumEntities();
+        const float DeltaTime = Context.GetDeltaTimeSeconds();
+
+        const TArrayView<FCrabTimerFragment> Timers = Context.GetMutableFragmentView<FCrabTimerFragment>();
+        const TConstArrayView<FCrabTargetFragment> Targets = Context.GetFragmentView<FCrabTargetFragment>();
+        const TConstArrayView<FCrabSettingsFragment> Settings = Context.GetFragmentView<FCrabSettingsFragment>();
+
+        for (int32 Index = 0; Index < NumEntities; Index++)
+        {
+            FCrabTimerFragment& Timer = Timers[Index];
+            Timer.StunTimeLeft = FMath::Max(Timer.StunTimeLeft - DeltaTime, 0.0f);
+            Timer.AttackCoolDownLeft = FMath::Max(Timer.AttackCoolDownLeft - DeltaTime, 0.0f);
+
+            // Attack when close enough to the player and the cool down is over
+            const FCrabTargetFragment& Target = Targets[Index];
+            if (Target.HasTarget && Crowd->IsPlayerAlive && Timer.StunTimeLeft <= 0.0f && Timer.AttackCoolDownLeft <= 0.0f
+                && FMath::Abs(Target.OffsetToTarget) <= Settings[Index].StopDistanceToTarget)
+            {
+                Timer.AttackCoolDownLeft = Settings[Index].AttackCoolDownInSeconds;
+                Crowd->AddPlayerHit(Settings[Index].AttackDamage, Settings[Index].AttackStunDuration);
+            }
+        }
+    });
+}
+
+UCrabPromotionProcessor::UCrabPromotionProcessor()
+    : EntityQuery(*this)
+{
+    ExecutionFlags = (int32)EProcessorExecutionFlags::All;
+    ProcessingPhase = EMassProcessingPhase::PrePhysics;
+    ExecutionOrder.ExecuteAfter.Add(UCrabChaseProcessor::StaticClass()->GetFName());
+
+    // Candidates are handed to the crab crowd subsystem
+    bRequiresGameThreadExecution = true;
+}
+
+void UCrabPromotionProcessor::ConfigureQueries()
+{
+    EntityQuery.AddRequirement<FCrabTargetFragment>(EMassFragmentAccess::ReadOnly);
+    EntityQuery.AddTagRequirement<FCrabPromotedTag>(EMassFragmentPresence::None);
+}
+
+void UCrabPromotionProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+    UWorld* World = EntityManager.GetWorld();
+    UCrabCrowdSubsystem* Crowd = World ? World->GetSubsystem<UCrabCrowdSubsystem>() : nullptr;
+    if (!Crowd || !Crowd->HasPlayer) return;
+
+    const float PromoteDistance = Crowd->GetPromoteDistance();
+
+    EntityQuery.ForEachEntityChunk(EntityManager, Context, [Crowd, PromoteDistance](FMassExecutionContext& Context)
+    {
+        const int32 NumEntities = Context.GetNumEntities();
+        const TConstArrayView<FCrabTargetFragment> Targets = Context.GetFragmentView<FCrabTargetFragment>();
+
+        for (int32 Index = 0; Index < NumEntities; Index++)
+        {
+            if (FMath::Abs(Targets[Index].OffsetToTarget) <= PromoteDistance)
+            {
+                Crowd->AddPromotionCandidate(Context.GetEntity(Index));
+            }
+        }
+    });
+}
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "MassEntityQuery.h"
+
+#include "CrabCrowdProcessors.generated.h"
+
+/**
+ * Moves the crowd crabs that have detected the player towards it (same rules as the enemy subsystem uses for AEnemy)
+ */
+UCLASS()
+class CRUSTYPIRATE_API UCrabChaseProcessor : public UMassProcessor
+{
+    GENERATED_BODY()
+
+public:
+    UCrabChaseProcessor();
+
+protected:
+    virtual void ConfigureQueries() override;
+    virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+    FMassEntityQuery EntityQuery;
+};
+
+/**
+ * Counts down the stun/cool down timers and lets crowd crabs in range attack the player
+ */
+UCLASS()
+class CRUSTYPIRATE_API UCrabAttackProcessor : public UMassProcessor
+{
+    GENERATED_BODY()
+
+public:
+    UCrabAttackProcessor();
+
+protected:
+    virtual void ConfigureQueries() override;
+    virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+    FMassEntityQuery EntityQuery;
+};
+
+/**
+ * Hands the crowd crabs that got close to the player over to the crab crowd subsystem, which promotes them to AEnemy actors
+ */
+UCLASS()
+class CRUSTYPIRATE_API UCrabPromotionProcessor : public UMassProcessor
+{
+    GENERATED_BODY()
+
+public:
+    UCrabPromotionProcessor();
+
+protected:
+    virtual void ConfigureQueries() override;
+    virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+    FMassEntityQuery EntityQuery;
+};
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CrabCrowdSpawner.h"
+
+#include "CrabCrowdSubsystem.h"
+
+ACrabCrowdSpawner::ACrabCrowdSpawner()
+{
+	PrimaryActorTick.bCanEverTick = false;
+    
+    Billboard = CreateDefaultSubobject<UBillboardComponent>(TEXT("Billboard"));
+    SetRootComponent(Billboard);
+}
+
+void ACrabCrowdSpawner::BeginPlay()
+{
+	Super::BeginPlay();
+    
+    UCrabCrowdSubsystem* CrabCrowd = GetWorld()->GetSubsystem<UCrabCrowdSubsystem>();
+    if (!CrabCrowd || !EnemyClass) return;
+    
+    FRandomStream RandomStream(RandomSeed);
+    const FVector SpawnerLocation = GetActorLocation();
+    
+    TArray<FVector> Locations;
+    Locations.Reserve(CrabCount);
+    for (int Index = 0; Index < CrabCount; Index++)
+    {
+        Locations.Add(SpawnerLocation + FVector(RandomStream.FRandRange(0.0f, SpawnWidth), 0.0f, 0.0f));
+    }
+    
+    CrabCrowd->SpawnCrabs(EnemyClass, Locations);
+}
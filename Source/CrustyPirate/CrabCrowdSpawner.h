@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+
+#include "Components/BillboardComponent.h"
+
+#include "Enemy.h"
+
+#include "CrabCrowdSpawner.generated.h"
+
+/**
+ * Spawns a crowd of crabs (Mass entities, see UCrabCrowdSubsystem) spread along X starting at the spawner.
+ * Place it at the height of the floor the crabs should walk on.
+ */
+UCLASS()
+class CRUSTYPIRATE_API ACrabCrowdSpawner : public AActor
+{
+	GENERATED_BODY()
+	
+public:
+    UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
+    UBillboardComponent* Billboard;
+    
+    // The enemy the crabs are promoted to when they get close to the player
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    TSubclassOf<AEnemy> EnemyClass;
+    
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    int CrabCount = 100;
+    
+    // The crabs are spread over this distance to the right of the spawner
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float SpawnWidth = 5000.0f;
+    
+    // Seed used to place the crabs, so the same level always gets the same crowd
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    int RandomSeed = 0;
+    
+	ACrabCrowdSpawner();
+
+	virtual void BeginPlay() override;
+};
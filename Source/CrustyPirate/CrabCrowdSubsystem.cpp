@@ -0,0 +1,232 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CrabCrowdSubsystem.h"
+
+#include "MassEntitySubsystem.h"
+#include "MassCommonFragments.h"
+
+#include "Kismet/GameplayStatics.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+#include "CrustyPirate.h"
+#include "CombatSubsystem.h"
+#include "CrabCrowdFragments.h"
+#include "Enemy.h"
+#include "EnemyPoolSubsystem.h"
+#include "PlayerCharacter.h"
+
+static TAutoConsoleVariable<float> CVarCrowdPromoteDistance(
+    TEXT("CrustyPirate.Crowd.PromoteDistance"),
+    1200.0f,
+    TEXT("Crowd crabs closer than this to the player (along X) are promoted to AEnemy actors."));
+
+static TAutoConsoleVariable<float> CVarCrowdDemoteDistance(
+    TEXT("CrustyPirate.Crowd.DemoteDistance"),
+    1600.0f,
+    TEXT("Promoted crabs further than this from the player (along X) are turned back into crowd entities."));
+
+static TAutoConsoleVariable<int32> CVarCrowdMaxPromoted(
+    TEXT("CrustyPirate.Crowd.MaxPromoted"),
+    64,
+    TEXT("Maximum number of crowd crabs promoted to AEnemy actors at the same time."));
+
+void UCrabCrowdSubsystem::SpawnCrabs(TSubclassOf<AEnemy> EnemyClass, const TArray<FVector>& Locations)
+{
+    LLM_SCOPE_BYTAG(CrustyPirate_Enemies);
+
+    FMassEntityManager* EntityManager = GetEntityManager();
+    if (!EntityManager || !EnemyClass) return;
+
+    if (!CrabArchetype.IsValid())
+    {
+        TArray<const UScriptStruct*> Fragments;
+        Fragments.Add(FTransformFragment::StaticStruct());
+        Fragments.Add(FCrabHealthFragment::StaticStruct());
+        Fragments.Add(FCrabTimerFragment::StaticStruct());
+        Fragments.Add(FCrabFacingFragment::StaticStruct());
+        Fragments.Add(FCrabTargetFragment::StaticStruct());
+        Fragments.Add(FCrabSettingsFragment::StaticStruct());
+        CrabArchetype = EntityManager->CreateArchetype(Fragments, FName("Crab"));
+    }
+
+    // The crowd crabs use the settings of the enemy class they promote to
+    const AEnemy* EnemyDefaults = GetDefault<AEnemy>(EnemyClass);
+
+    FCrabSettingsFragment Settings;
+    Settings.ClassIndex = CrabClasses.AddUnique(EnemyClass);
+    Settings.MoveSpeed = EnemyDefaults->GetCharacterMovement()->MaxWalkSpeed;
+    Settings.DetectionRadius = EnemyDefaults->PlayerDetectorSphere->GetScaledSphereRadius();
+    Settings.StopDistanceToTarget = EnemyDefaults->StopDistanceToTarget;
+    Settings.AttackCoolDownInSeconds = EnemyDefaults->AttackCoolDownInSeconds;
+    Settings.AttackDamage = EnemyDefaults->AttackDamage;
+    Settings.AttackStunDuration = EnemyDefaults->AttackStunDuration;
+
+    for (const FVector& Location : Locations)
+    {
+        const FMassEntityHandle Entity = EntityManager->CreateEntity(CrabArchetype);
+
+        EntityManager->GetFragmentDataChecked<FTransformFragment>(Entity).GetMutableTransform().SetLocation(Location);
+        EntityManager->GetFragmentDataChecked<FCrabHealthFragment>(Entity).HitPoints = EnemyDefaults->HitPoints;
+        EntityManager->GetFragmentDataChecked<FCrabSettingsFragment>(Entity) = Settings;
+    }
+}
+
+float UCrabCrowdSubsystem::GetPromoteDistance() const
+{
+    return CVarCrowdPromoteDistance.GetValueOnGameThread();
+}
+
+void UCrabCrowdSubsystem::AddPromotionCandidate(FMassEntityHandle Entity)
+{
+    PromotionCandidates.Add(Entity);
+}
+
+void UCrabCrowdSubsystem::AddPlayerHit(int DamageAmount, float StunDuration)
+{
+    PendingPlayerHits.Add(TPair<int, float>(DamageAmount, StunDuration));
+}
+
+void UCrabCrowdSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    FMassEntityManager* EntityManager = GetEntityManager();
+    if (!EntityManager) return;
+
+    // Remember where the player is for the crowd processors
+    Player = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerCharacter(GetWorld(), 0));
+    HasPlayer = Player != nullptr;
+    if (Player)
+    {
+        PlayerX = Player->GetActorLocation().X;
+        IsPlayerAlive = Player->IsAlive;
+    }
+
+    // Hand the hits landed by the crowd crabs to the combat subsystem (every crab attack is its own swing)
+    UCombatSubsystem* Combat = GetWorld()->GetSubsystem<UCombatSubsystem>();
+    for (const TPair<int, float>& Hit : PendingPlayerHits)
+    {
+        if (Player && Combat)
+        {
+            Combat->QueueHit(nullptr, Player, Combat->NewSwingId(), Hit.Key, Hit.Value);
+        }
+    }
+    PendingPlayerHits.Reset();
+
+    const float DemoteDistance = CVarCrowdDemoteDistance.GetValueOnGameThread();
+
+    // Go backwards since crabs are removed from the promoted list
+    for (int Index = PromotedEntities.Num() - 1; Index >= 0; Index--)
+    {
+        AEnemy* Enemy = PromotedEnemies[Index];
+        const FMassEntityHandle Entity = PromotedEntities[Index];
+
+        if (!IsValid(Enemy) || !EntityManager->IsEntityValid(Entity))
+        {
+            if (EntityManager->IsEntityValid(Entity))
+            {
+                EntityManager->DestroyEntity(Entity);
+            }
+            ReleasePromotedCrab(Index);
+        }
+        else if (!Enemy->IsAlive)
+        {
+            // The crab died as an actor, the actor is all that is left of it
+            EntityManager->DestroyEntity(Entity);
+            Enemy->CrowdEntity.Reset();
+            ReleasePromotedCrab(Index);
+        }
+        else if (HasPlayer && FMath::Abs(Enemy->GetActorLocation().X - PlayerX) > DemoteDistance)
+        {
+            DemoteCrab(*EntityManager, Index);
+        }
+    }
+
+    const int MaxPromoted = CVarCrowdMaxPromoted.GetValueOnGameThread();
+    for (const FMassEntityHandle& Entity : PromotionCandidates)
+    {
+        if (PromotedEntities.Num() >= MaxPromoted) break;
+
+        if (EntityManager->IsEntityValid(Entity))
+        {
+            PromoteCrab(*EntityManager, Entity);
+        }
+    }
+    PromotionCandidates.Reset();
+}
+
+void UCrabCrowdSubsystem::PromoteCrab(FMassEntityManager& EntityManager, FMassEntityHandle Entity)
+{
+    const FCrabSettingsFragment& Settings = EntityManager.GetFragmentDataChecked<FCrabSettingsFragment>(Entity);
+    const FCrabHealthFragment& Health = EntityManager.GetFragmentDataChecked<FCrabHealthFragment>(Entity);
+    const FCrabTimerFragment& Timer = EntityManager.GetFragmentDataChecked<FCrabTimerFragment>(Entity);
+    const FCrabFacingFragment& Facing = EntityManager.GetFragmentDataChecked<FCrabFacingFragment>(Entity);
+    const FVector Location = EntityManager.GetFragmentDataChecked<FTransformFragment>(Entity).GetTransform().GetLocation();
+
+    // Enemies facing left are rotated by 180 degrees (see AEnemy::UpdateDirection)
+    const FTransform SpawnTransform(FRotator(0.0f, Facing.Direction < 0.0f ? 180.0f : 0.0f, 0.0f), Location);
+
+    UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+    AEnemy* Enemy = EnemyPool ? EnemyPool->AcquireEnemy(CrabClasses[Settings.ClassIndex], SpawnTransform) : nullptr;
+    if (!Enemy) return;
+
+    Enemy->UpdateHP(Health.HitPoints);
+    Enemy->CrowdEntity = Entity;
+    Enemy->RestoreCrowdState(Timer.StunTimeLeft, Timer.AttackCoolDownLeft);
+
+    EntityManager.AddTagToEntity(Entity, FCrabPromotedTag::StaticStruct());
+
+    PromotedEntities.Add(Entity);
+    PromotedEnemies.Add(Enemy);
+}
+
+void UCrabCrowdSubsystem::DemoteCrab(FMassEntityManager& EntityManager, int PromotedIndex)
+{
+    AEnemy* Enemy = PromotedEnemies[PromotedIndex];
+    const FMassEntityHandle Entity = PromotedEntities[PromotedIndex];
+
+    // Copy the state of the actor back into the entity
+    EntityManager.GetFragmentDataChecked<FTransformFragment>(Entity).GetMutableTransform().SetLocation(Enemy->GetActorLocation());
+    EntityManager.GetFragmentDataChecked<FCrabHealthFragment>(Entity).HitPoints = Enemy->HitPoints;
+    EntityManager.GetFragmentDataChecked<FCrabFacingFragment>(Entity).Direction = Enemy->GetActorRotation().Yaw == 180.0f ? -1.0f : 1.0f;
+
+    FCrabTimerFragment& Timer = EntityManager.GetFragmentDataChecked<FCrabTimerFragment>(Entity);
+    Enemy->GetCrowdState(Timer.StunTimeLeft, Timer.AttackCoolDownLeft);
+
+    EntityManager.RemoveTagFromEntity(Entity, FCrabPromotedTag::StaticStruct());
+
+    Enemy->CrowdEntity.Reset();
+    if (UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>())
+    {
+        EnemyPool->ReleaseEnemy(Enemy);
+    }
+    else
+    {
+        Enemy->Destroy();
+    }
+
+    ReleasePromotedCrab(PromotedIndex);
+}
+
+void UCrabCrowdSubsystem::ReleasePromotedCrab(int PromotedIndex)
+{
+    PromotedEntities.RemoveAtSwap(PromotedIndex);
+    PromotedEnemies.RemoveAtSwap(PromotedIndex);
+}
+
+FMassEntityManager* UCrabCrowdSubsystem::GetEntityManager() const
+{
+    UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+    return EntitySubsystem ? &EntitySubsystem->GetMutableEntityManager() : nullptr;
+}
+
+TStatId UCrabCrowdSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UCrabCrowdSubsystem, STATGROUP_Tickables);
+}
+
+bool UCrabCrowdSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "MassEntityTypes.h"
+
+#include "CrabCrowdSubsystem.generated.h"
+
+class AEnemy;
+class APlayerCharacter;
+struct FMassEntityManager;
+
+/**
+ * Owns the crabs of the large encounter levels as lightweight Mass entities (see CrabCrowdFragments.h).
+ * The crowd processors make the entities chase and attack the player, and once a crab gets within PromoteDistance of
+ * the player it is promoted to a full AEnemy actor so the fight uses the usual TakeHit/Attack behaviour.
+ * Only actors take hits, so crabs always die as promoted actors.
+ * Promoted crabs that end up further than DemoteDistance from the player are turned back into entities.
+ * The actors are taken from and given back to the enemy pool (see UEnemyPoolSubsystem).
+ * The promote distance should cover the camera view since entities are not rendered.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UCrabCrowdSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    // Create one crowd crab of the given enemy class at each location
+    void SpawnCrabs(TSubclassOf<AEnemy> EnemyClass, const TArray<FVector>& Locations);
+
+    int GetNumPromotedCrabs() const { return PromotedEntities.Num(); }
+
+    // Player state read by the crowd processors (refreshed every frame)
+    bool HasPlayer = false;
+    bool IsPlayerAlive = false;
+    float PlayerX = 0.0f;
+
+    float GetPromoteDistance() const;
+
+    // Called by the crowd processors
+    void AddPromotionCandidate(FMassEntityHandle Entity);
+    void AddPlayerHit(int DamageAmount, float StunDuration);
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+    FMassEntityManager* GetEntityManager() const;
+
+    void PromoteCrab(FMassEntityManager& EntityManager, FMassEntityHandle Entity);
+    void DemoteCrab(FMassEntityManager& EntityManager, int PromotedIndex);
+    void ReleasePromotedCrab(int PromotedIndex);
+
+    // The enemy classes used by the crowd crabs (FCrabSettingsFragment::ClassIndex)
+    UPROPERTY()
+    TArray<TSubclassOf<AEnemy>> CrabClasses;
+
+    FMassArchetypeHandle CrabArchetype;
+
+    TArray<FMassEntityHandle> PromotionCandidates;
+
+    // The promoted entities and the actors representing them (same index in both arrays)
+    TArray<FMassEntityHandle> PromotedEntities;
+
+    UPROPERTY()
+    TArray<TObjectPtr<AEnemy>> PromotedEnemies;
+
+    UPROPERTY()
+    TObjectPtr<APlayerCharacter> Player;
+
+    // Hits landed on the player by the crowd since the last tick
+    TArray<TPair<int, float>> PendingPlayerHits;
+};
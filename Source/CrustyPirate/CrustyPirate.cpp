@@ -4,3 +4,12 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, CrustyPirate, "CrustyPirate" );
+
+DEFINE_LOG_CATEGORY(LogCrustyPirate);
+
+LLM_DEFINE_TAG(CrustyPirate);
+LLM_DEFINE_TAG(CrustyPirate_Enemies, TEXT("Enemies"), TEXT("CrustyPirate"));
+LLM_DEFINE_TAG(CrustyPirate_Player, TEXT("Player"), TEXT("CrustyPirate"));
+LLM_DEFINE_TAG(CrustyPirate_Collectables, TEXT("Collectables"), TEXT("CrustyPirate"));
+LLM_DEFINE_TAG(CrustyPirate_HUD, TEXT("HUD"), TEXT("CrustyPirate"));
+LLM_DEFINE_TAG(CrustyPirate_TileMaps, TEXT("TileMaps"), TEXT("CrustyPirate"));
@@ -3,4 +3,23 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogCrustyPirate, Log, All);
+
+// "stat CrustyPirate" shows the gameplay cycle stats and counters. They are also recorded by "-trace=cpu,stats"
+// so they can be looked at in Unreal Insights
+DECLARE_STATS_GROUP(TEXT("CrustyPirate"), STATGROUP_CrustyPirate, STATCAT_Advanced);
+
+// Low-Level Memory Tracker tags of the gameplay classes, shown as CrustyPirate/... when running with -llm.
+// FMemoryReport accounts the same categories by object
+LLM_DECLARE_TAG(CrustyPirate);
+LLM_DECLARE_TAG(CrustyPirate_Enemies);
+LLM_DECLARE_TAG(CrustyPirate_Player);
+LLM_DECLARE_TAG(CrustyPirate_Collectables);
+LLM_DECLARE_TAG(CrustyPirate_HUD);
+LLM_DECLARE_TAG(CrustyPirate_TileMaps);
+
+// Trace channel used by the attack sweeps (see UCombatSubsystem). Set up in DefaultEngine.ini, only pawns overlap it
+#define ECC_AttackHit ECC_GameTraceChannel1
 
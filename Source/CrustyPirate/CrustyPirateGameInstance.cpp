@@ -1,6 +1,48 @@
 #include "CrustyPirateGameInstance.h"
 
 #include "Kismet/GameplayStatics.h"
+#include "Misc/PackageName.h"
+#include "ProfilingDebugging/MiscTrace.h"
+
+#include "CrustyPirate.h"
+#include "ProgressSaveSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Level Preload Request"), STAT_LevelPreloadRequest, STATGROUP_CrustyPirate);
+DECLARE_CYCLE_STAT(TEXT("Level Open"), STAT_LevelOpen, STATGROUP_CrustyPirate);
+
+FString UCrustyPirateGameInstance::GetLevelPackageName(int LevelIndex)
+{
+    return FString::Printf(TEXT("/Game/Levels/Level_%d"), LevelIndex);
+}
+
+bool UCrustyPirateGameInstance::DoesLevelExist(int LevelIndex)
+{
+    return LevelIndex > 0 && FPackageName::DoesPackageExist(GetLevelPackageName(LevelIndex));
+}
+
+void UCrustyPirateGameInstance::Init()
+{
+    Super::Init();
+    
+    FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UCrustyPirateGameInstance::OnPostLoadMap);
+    
+    // The progress save was read by its subsystem during Super::Init(). Go on from the saved level once the
+    // startup map is loaded, and start loading that level right away. The editor keeps playing the map it has
+    // open, so PIE starts from the default progress instead
+    UProgressSaveSubsystem* ProgressSave = GetSubsystem<UProgressSaveSubsystem>();
+    if (!GIsEditor && ProgressSave && ProgressSave->ApplyLoadedProgress() && CurrentLevelIndex > 1)
+    {
+        IsResumePending = true;
+        PreloadLevel(CurrentLevelIndex);
+    }
+}
+
+void UCrustyPirateGameInstance::Shutdown()
+{
+    FCoreUObjectDelegates::PostLoadMapWithWorld.RemoveAll(this);
+    
+    Super::Shutdown();
+}
 
 void UCrustyPirateGameInstance::SetPlayerHP(int NewHP)
 {
@@ -13,17 +55,103 @@ void UCrustyPirateGameInstance::AddDiamond(int Amount)
     CollectedDiamondCount += Amount;
 }
 
+void UCrustyPirateGameInstance::PreloadLevel(int LevelIndex)
+{
+    SCOPE_CYCLE_COUNTER(STAT_LevelPreloadRequest);
+    
+    if (LevelIndex <= 0 || LevelIndex == PreloadLevelIndex) return;
+    
+    PreloadLevelIndex = LevelIndex;
+    IsPreloadDone = false;
+    PreloadedLevelPackage = nullptr;
+    
+    LoadPackageAsync(GetLevelPackageName(LevelIndex), FLoadPackageAsyncDelegate::CreateUObject(this, &UCrustyPirateGameInstance::OnLevelPreloaded));
+}
+
+void UCrustyPirateGameInstance::OnLevelPreloaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result)
+{
+    // Ignore the preloads of levels we are no longer going to
+    if (PackageName != FName(GetLevelPackageName(PreloadLevelIndex))) return;
+    
+    IsPreloadDone = true;
+    PreloadedLevelPackage = Result == EAsyncLoadingResult::Succeeded ? LoadedPackage : nullptr;
+    
+    if (PendingLevelIndex == PreloadLevelIndex)
+    {
+        PendingLevelIndex = 0;
+        OpenLevel(PreloadLevelIndex);
+    }
+}
+
 void UCrustyPirateGameInstance::ChangeLevel(int LevelIndex)
 {
     if (LevelIndex <= 0) return;
     
     CurrentLevelIndex = LevelIndex;
     
+    // Save the progress the player starts the level with (written in the background)
+    if (UProgressSaveSubsystem* ProgressSave = GetSubsystem<UProgressSaveSubsystem>())
+    {
+        ProgressSave->SaveProgress();
+    }
+    
+    TransitionStartTime = FPlatformTime::Seconds();
+    TransitionUsedPreload = LevelIndex == PreloadLevelIndex;
+    
+    // Wait for the preload to finish rather than loading the map a second time
+    if (LevelIndex == PreloadLevelIndex && !IsPreloadDone)
+    {
+        PendingLevelIndex = LevelIndex;
+        return;
+    }
+    
+    OpenLevel(LevelIndex);
+}
+
+void UCrustyPirateGameInstance::OpenLevel(int LevelIndex)
+{
+    SCOPE_CYCLE_COUNTER(STAT_LevelOpen);
+    
+    // Marks the transition in the timeline of Unreal Insights
+    TRACE_BOOKMARK(TEXT("Open Level_%d"), LevelIndex);
+    
     FString LevelNameString = FString::Printf(TEXT("Level_%d"), LevelIndex);
     
+    // The map package is already in memory when it was preloaded, so the load does not have to wait for the disk
     UGameplayStatics::OpenLevel(GetWorld(), FName(LevelNameString));
 }
 
+void UCrustyPirateGameInstance::OnPostLoadMap(UWorld* LoadedWorld)
+{
+    if (IsResumePending)
+    {
+        IsResumePending = false;
+        
+        // Keep the preload of the saved level going, ChangeLevel waits for it
+        if (LoadedWorld && LoadedWorld->GetMapName() != FString::Printf(TEXT("Level_%d"), CurrentLevelIndex))
+        {
+            ChangeLevel(CurrentLevelIndex);
+            return;
+        }
+    }
+    
+    if (TransitionStartTime > 0.0)
+    {
+        TRACE_BOOKMARK(TEXT("Level_%d loaded"), CurrentLevelIndex);
+        UE_LOG(LogCrustyPirate, Display, TEXT("Level transition to Level_%d took %.1f ms (%s)"),
+               CurrentLevelIndex,
+               (FPlatformTime::Seconds() - TransitionStartTime) * 1000.0,
+               TransitionUsedPreload ? TEXT("preloaded") : TEXT("not preloaded"));
+        TransitionStartTime = 0.0;
+    }
+    
+    // The new world references everything it needs now
+    PreloadedLevelPackage = nullptr;
+    PreloadLevelIndex = 0;
+    IsPreloadDone = false;
+    PendingLevelIndex = 0;
+}
+
 void UCrustyPirateGameInstance::RestartGame()
 {
     // Reset all the variables
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Engine/GameInstance.h"
+#include "UObject/UObjectGlobals.h"
 #include "CrustyPirateGameInstance.generated.h"
 
 /**
@@ -28,13 +29,46 @@ public:
     UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
     int CurrentLevelIndex = 1;
     
+    virtual void Init() override;
+    virtual void Shutdown() override;
+    
     void SetPlayerHP(int NewHP);
     void AddDiamond(int Amount);
     
+    // Start loading the map package of the level in the background (called as soon as the player reaches a level exit)
+    void PreloadLevel(int LevelIndex);
+    
+    // Open the level. If it is being preloaded the level is opened once the package is loaded
     void ChangeLevel(int LevelIndex);
     
     UFUNCTION(BlueprintCallable)
     void RestartGame();
     
-	
+    // The levels are named Level_1, Level_2...
+    static FString GetLevelPackageName(int LevelIndex);
+    static bool DoesLevelExist(int LevelIndex);
+    
+private:
+    void OpenLevel(int LevelIndex);
+    
+    void OnLevelPreloaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result);
+    void OnPostLoadMap(UWorld* LoadedWorld);
+    
+    // Keeps the preloaded map package in memory until the level is opened
+    UPROPERTY()
+    UPackage* PreloadedLevelPackage;
+    
+    // The level being preloaded (0 when none)
+    int PreloadLevelIndex = 0;
+    bool IsPreloadDone = false;
+    
+    // The level ChangeLevel is waiting to open once its preload is done (0 when none)
+    int PendingLevelIndex = 0;
+    
+    // Go to the saved level once the startup map is loaded
+    bool IsResumePending = false;
+    
+    // When ChangeLevel was called, used to log how long the transition took
+    double TransitionStartTime = 0.0;
+    bool TransitionUsedPreload = false;
 };
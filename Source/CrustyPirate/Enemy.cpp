@@ -3,10 +3,31 @@
 
 #include "Enemy.h"
 
+#include "PaperFlipbookComponent.h"
+#include "PaperZDAnimationComponent.h"
 
-AEnemy::AEnemy()
+#include "CombatSubsystem.h"
+#include "EnemyPoolSubsystem.h"
+#include "FixedStepSubsystem.h"
+#include "HealthBarSubsystem.h"
+#include "PlatformerWalkerMovement.h"
+#include "TickLODSubsystem.h"
+#include "CrustyPirate.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Detector Overlap"), STAT_EnemyDetectorOverlap, STATGROUP_CrustyPirate);
+DECLARE_CYCLE_STAT(TEXT("Enemy Attack Overlap"), STAT_EnemyAttackOverlap, STATGROUP_CrustyPirate);
+DECLARE_CYCLE_STAT(TEXT("Enemy TakeHit"), STAT_EnemyTakeHit, STATGROUP_CrustyPirate);
+DECLARE_CYCLE_STAT(TEXT("Enemy Stun"), STAT_EnemyStun, STATGROUP_CrustyPirate);
+DECLARE_CYCLE_STAT(TEXT("Enemy HP Update"), STAT_EnemyUpdateHP, STATGROUP_CrustyPirate);
+
+// Enemies use the platformer walker movement (a character movement component that can switch to lightweight walking)
+AEnemy::AEnemy(const FObjectInitializer& ObjectInitializer)
+    : Super(ObjectInitializer.SetDefaultSubobjectClass<UPlatformerWalkerMovement>(ACharacter::CharacterMovementComponentName))
 {
-    PrimaryActorTick.bCanEverTick = true;
+    LLM_SCOPE_BYTAG(CrustyPirate_Enemies);
+    
+    // The enemy subsystem runs the chase/attack logic of all the enemies in one pass, so the enemy does not need to tick
+    PrimaryActorTick.bCanEverTick = false;
     
     PlayerDetectorSphere = CreateDefaultSubobject<USphereComponent>(TEXT("PlayerDetectorSphere"));
     // Note that the RootComponent is already set up for us since we inherit from APaperZDCharacter
@@ -23,52 +44,164 @@ void AEnemy::BeginPlay()
 {
     Super::BeginPlay();
     
-    // Bind the delegates to the Sphere's events
-    PlayerDetectorSphere->OnComponentBeginOverlap.AddDynamic(this, &AEnemy::DetectorOverlapBegin);
-    PlayerDetectorSphere->OnComponentEndOverlap.AddDynamic(this, &AEnemy::DetectorOverlapEnd);
+    LLM_SCOPE_BYTAG(CrustyPirate_Enemies);
+    
+    if (UseGridPlayerDetection)
+    {
+        // The enemy subsystem detects the player, so the sphere does not need to generate any overlaps
+        PlayerDetectorSphere->SetGenerateOverlapEvents(false);
+        PlayerDetectorSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    }
+    else
+    {
+        // Bind the delegates to the Sphere's events
+        PlayerDetectorSphere->OnComponentBeginOverlap.AddDynamic(this, &AEnemy::DetectorOverlapBegin);
+        PlayerDetectorSphere->OnComponentEndOverlap.AddDynamic(this, &AEnemy::DetectorOverlapEnd);
+    }
     
+    MaxHitPoints = HitPoints;
+    ShowHP(true);
     UpdateHP(HitPoints);
     
     // Binding the attack animation end delegate (signal) to OnAttackOverrideAnimEnd()
     OnAttackOverrideEndDelegate.BindUObject(this, &AEnemy::OnAttackOverrideAnimEnd);
     
-    // Binding the collision box's OnComponentBeginOverlap event to AttackBoxOverlapBegin()
-    AttackCollisionBox->OnComponentBeginOverlap.AddDynamic(this, &AEnemy::AttackBoxOverlapBegin);
+    if (!UseAttackSweep)
+    {
+        // Binding the collision box's OnComponentBeginOverlap event to AttackBoxOverlapBegin()
+        AttackCollisionBox->OnComponentBeginOverlap.AddDynamic(this, &AEnemy::AttackBoxOverlapBegin);
+    }
+    else
+    {
+        // The box is only used as the shape of the attack sweeps and never collides itself
+        AttackCollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    }
     
     // Disable the collision box at first
     EnableAttackCollisionBox(false);
+    
+    EnemySubsystem = GetWorld()->GetSubsystem<UEnemySubsystem>();
+    RegisterSimulation();
+    
+    // Enemies placed in the level are brought back by the enemy pool when the level is reset
+    if (!IsFromPool)
+    {
+        if (UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>())
+        {
+            EnemyPool->AddSpawnPoint(this);
+        }
+    }
 }
 
-void AEnemy::Tick(float DeltaTime)
+void AEnemy::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-    Super::Tick(DeltaTime);
+    UnregisterSimulation();
+    ShowHP(false);
     
-    // If the enemy is alive and has a follow target assigned, follow the player
-    if (IsAlive && FollowTarget && !IsStunned)
+    Super::EndPlay(EndPlayReason);
+}
+
+void AEnemy::RegisterSimulation()
+{
+    // Let the enemy subsystem simulate this enemy
+    if (EnemySubsystem)
     {
-        // Get the direction of the enemy relative to the player
-        float MoveDirection = (FollowTarget->GetActorLocation().X - GetActorLocation().X) > 0.0f ? 1.0f : -1.0f;
-        // Update the enemy direction
-        UpdateDirection(MoveDirection);
-        // Move to target if not close enough
-        if (ShouldMoveToTarget())
-        {
-            if (CanMove)
-            {
-                // Move towards the player
-                FVector WorldDirection = FVector(1.0f, 0.0f, 0.0f);
-                AddMovementInput(WorldDirection, MoveDirection);
-            }
-        }
-        // Otherwise we are close enough and should attack
-        else
-        {
-            // Attack
-            if (FollowTarget->IsAlive)
-            {
-                Attack();
-            }
-        }
+        EnemySubsystem->RegisterEnemy(this);
+    }
+    
+    // Step the movement and animation in fixed steps when they are on. Done before the tick LOD registration
+    // so the tick LOD leaves the components ticked by the fixed step subsystem alone
+    if (UFixedStepSubsystem* FixedStep = GetWorld()->GetSubsystem<UFixedStepSubsystem>())
+    {
+        FixedStep->RegisterCharacter(this);
+    }
+    
+    // Lower the tick rate of the enemy components while the enemy is away from the camera
+    if (UTickLODSubsystem* TickLOD = GetWorld()->GetSubsystem<UTickLODSubsystem>())
+    {
+        TickLOD->RegisterActor(this);
+    }
+}
+
+void AEnemy::UnregisterSimulation()
+{
+    if (EnemySubsystem)
+    {
+        EnemySubsystem->UnregisterEnemy(this);
+    }
+    
+    if (UTickLODSubsystem* TickLOD = GetWorld()->GetSubsystem<UTickLODSubsystem>())
+    {
+        TickLOD->UnregisterActor(this);
+    }
+    
+    if (UFixedStepSubsystem* FixedStep = GetWorld()->GetSubsystem<UFixedStepSubsystem>())
+    {
+        FixedStep->UnregisterCharacter(this);
+    }
+}
+
+void AEnemy::DeactivateForPool()
+{
+    IsInPool = true;
+    IsAlive = false;
+    FollowTarget = NULL;
+    CrowdEntity.Reset();
+    
+    UGameplayTimerSubsystem* Timers = GetWorld()->GetSubsystem<UGameplayTimerSubsystem>();
+    Timers->ClearTimer(StunTimer);
+    Timers->ClearTimer(AttackCoolDownTimer);
+    Timers->ClearTimer(CorpseTimer);
+    
+    EnableAttackCollisionBox(false);
+    
+    // An enemy can go into the pool alive (crowd demotion, level reset), its health bar is not drawn over the hidden actor
+    ShowHP(false);
+    
+    // A pooled enemy is not simulated and none of its components tick
+    UnregisterSimulation();
+    
+    SetActorHiddenInGame(true);
+    SetActorEnableCollision(false);
+    GetCharacterMovement()->StopMovementImmediately();
+    GetCharacterMovement()->Deactivate();
+    GetAnimationComponent()->Deactivate();
+    GetSprite()->Deactivate();
+}
+
+void AEnemy::ResetForReuse(const FTransform& Transform, int NewHitPoints)
+{
+    IsInPool = false;
+    
+    SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+    SetActorHiddenInGame(false);
+    SetActorEnableCollision(true);
+    GetCharacterMovement()->Activate(true);
+    GetAnimationComponent()->Activate(true);
+    GetSprite()->Activate(true);
+    
+    IsAlive = true;
+    IsStunned = false;
+    CanMove = true;
+    CanAttack = true;
+    
+    MaxHitPoints = NewHitPoints;
+    ShowHP(true);
+    UpdateHP(NewHitPoints);
+    
+    // The CrabbyStateMachine has no jump node to idle. Its take hit state goes back to idle once the short hit
+    // animation has played, so jumping there leaves the die state with the anim instance the enemy already has
+    GetAnimInstance()->StopAllAnimationOverrides();
+    GetAnimInstance()->JumpToNode(FName("JumpTakeHit"), FName("CrabbyStateMachine"));
+    
+    RegisterSimulation();
+}
+
+void AEnemy::SyncSimulationState()
+{
+    if (EnemySubsystem)
+    {
+        EnemySubsystem->UpdateEnemyState(this);
     }
 }
 
@@ -98,26 +231,53 @@ void AEnemy::UpdateDirection(float MoveDirection)
 
 void AEnemy::DetectorOverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+    SCOPE_CYCLE_COUNTER(STAT_EnemyDetectorOverlap);
+    
     APlayerCharacter* Player = Cast<APlayerCharacter>(OtherActor);
     
     // If the casting worked then we know that the player is the actor that entered the sphere
     if (Player)
     {
-        FollowTarget = Player;
+        OnPlayerDetected(Player);
     }
 }
 
 void AEnemy::DetectorOverlapEnd(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
 {
+    SCOPE_CYCLE_COUNTER(STAT_EnemyDetectorOverlap);
+    
     APlayerCharacter* Player = Cast<APlayerCharacter>(OtherActor);
     
     // If the casting worked then we know that the player is the actor that exited the sphere
     if (Player)
     {
-        FollowTarget = NULL;
+        OnPlayerLost(Player);
+    }
+}
+
+void AEnemy::OnPlayerDetected(APlayerCharacter* Player)
+{
+    FollowTarget = Player;
+    SyncSimulationState();
+    
+    // Start ticking every frame right away in case the enemy was asleep
+    WakeUp();
+}
+
+void AEnemy::WakeUp()
+{
+    if (UTickLODSubsystem* TickLOD = GetWorld()->GetSubsystem<UTickLODSubsystem>())
+    {
+        TickLOD->WakeActor(this);
     }
 }
 
+void AEnemy::OnPlayerLost(APlayerCharacter* Player)
+{
+    FollowTarget = NULL;
+    SyncSimulationState();
+}
+
 
 bool AEnemy::ShouldMoveToTarget()
 {
@@ -136,17 +296,56 @@ bool AEnemy::ShouldMoveToTarget()
 
 void AEnemy::UpdateHP(int NewHP)
 {
+    SCOPE_CYCLE_COUNTER(STAT_EnemyUpdateHP);
+    
     // Update Hit Points
     HitPoints = NewHP;
+    
+    if (HealthBarIndex != INDEX_NONE)
+    {
+        // Only the instance of this enemy's bar is touched
+        GetWorld()->GetSubsystem<UHealthBarSubsystem>()->SetBarFraction(HealthBarIndex, MaxHitPoints > 0 ? (float)HitPoints / MaxHitPoints : 0.0f);
+        return;
+    }
+    
     // Update the Hit Points string (displayed above the enemy)
     FString Str = FString::Printf(TEXT("HP: %d"), HitPoints);
     HPText->SetText(FText::FromString(Str));
 }
 
+void AEnemy::ShowHP(bool Visible)
+{
+    UHealthBarSubsystem* HealthBars = GetWorld()->GetSubsystem<UHealthBarSubsystem>();
+    
+    if (UseInstancedHealthBar && HealthBarSprite && HealthBars)
+    {
+        // The text is not added to the scene at all while the health bar is used
+        HPText->SetVisibility(false);
+        
+        if (Visible && HealthBarIndex == INDEX_NONE)
+        {
+            HealthBarIndex = HealthBars->AddBar(HPText, HealthBarSprite, MaxHitPoints > 0 ? (float)HitPoints / MaxHitPoints : 0.0f);
+        }
+        else if (!Visible && HealthBarIndex != INDEX_NONE)
+        {
+            HealthBars->RemoveBar(HealthBarIndex);
+            HealthBarIndex = INDEX_NONE;
+        }
+    }
+    else
+    {
+        HPText->SetHiddenInGame(!Visible);
+    }
+}
+
 void AEnemy::TakeHit(int DamageAmount, float StunDuration)
 {
+    SCOPE_CYCLE_COUNTER(STAT_EnemyTakeHit);
+    
     if (!IsAlive) return;
     
+    WakeUp();
+    
     // Stun the enemy (This makes sure the override animations (such as the attack one) is stopped in case
     // the enemy was attacking while the player attacks)
     Stun(StunDuration);
@@ -157,10 +356,11 @@ void AEnemy::TakeHit(int DamageAmount, float StunDuration)
     {
         // Enemy is dead
         UpdateHP(0);
-        HPText->SetHiddenInGame(true);
+        ShowHP(false);
         IsAlive = false;
         CanMove = false;
         CanAttack = false;
+        SyncSimulationState();
         
         // Play the die animation by jumpting to the JumpDie animation
         GetAnimInstance()->JumpToNode(FName("JumpDie"), FName("CrabbyStateMachine"));
@@ -168,6 +368,9 @@ void AEnemy::TakeHit(int DamageAmount, float StunDuration)
         // Disable the collision box after the enemy is dead
         EnableAttackCollisionBox(false);
         
+        // Go back to the enemy pool once the die animation had time to play
+        GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->SetTimer(CorpseTimer, this, &AEnemy::OnCorpseTimerTimeout, CorpseTimeInSeconds);
+        
     }
     else
     {
@@ -178,16 +381,13 @@ void AEnemy::TakeHit(int DamageAmount, float StunDuration)
 
 void AEnemy::Stun(float DurationInSeconds)
 {
-    IsStunned = true;
+    SCOPE_CYCLE_COUNTER(STAT_EnemyStun);
     
-    // Allow the player to stun the enemy several times
-    bool IsTimerAlreadyActive = GetWorldTimerManager().IsTimerActive(StunTimer);
-    if (IsTimerAlreadyActive)
-    {
-        GetWorldTimerManager().ClearTimer(StunTimer);
-    }
+    IsStunned = true;
+    SyncSimulationState();
     
-    GetWorldTimerManager().SetTimer(StunTimer, this, &AEnemy::OnStunTimerTimeout, 1.0f, false, DurationInSeconds);
+    // Allow the player to stun the enemy several times (setting the timer again moves it if it is already active)
+    GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->SetTimer(StunTimer, this, &AEnemy::OnStunTimerTimeout, DurationInSeconds);
     
     // Make sure we stop any currently playing override animations while stunned (such as attack)
     GetAnimInstance()->StopAllAnimationOverrides();
@@ -199,7 +399,19 @@ void AEnemy::Stun(float DurationInSeconds)
 void AEnemy::OnStunTimerTimeout()
 {
     IsStunned = false;
-    
+    SyncSimulationState();
+}
+
+void AEnemy::OnCorpseTimerTimeout()
+{
+    if (UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>())
+    {
+        EnemyPool->ReleaseEnemy(this);
+    }
+    else
+    {
+        Destroy();
+    }
 }
 
 void AEnemy::Attack()
@@ -208,6 +420,9 @@ void AEnemy::Attack()
     {
         CanAttack = false;
         CanMove = false;
+        SyncSimulationState();
+        
+        AttackSwingId = GetWorld()->GetSubsystem<UCombatSubsystem>()->BeginSwing(this);
         
         // Override the current animation sequence with AttackAnimSequence when the enemy is attacking
         // Once the animation is over, the OnAttackOverrideEndDelegate will be actioned and OnAttackOverrideAnimEnd will be called
@@ -215,7 +430,7 @@ void AEnemy::Attack()
         GetAnimInstance()->PlayAnimationOverride(AttackAnimSequence, FName("DefaultSlot"), 1.0f, 0.0f, OnAttackOverrideEndDelegate);
         
         // We dont want the enemy to attack as soon as hes done attacking, we want the enemy to attack after the cool down
-        GetWorldTimerManager().SetTimer(AttackCoolDownTimer, this, &AEnemy::OnAttackCoolDownTimerTimeout, 1.0f, false, AttackCoolDownInSeconds);
+        GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->SetTimer(AttackCoolDownTimer, this, &AEnemy::OnAttackCoolDownTimerTimeout, AttackCoolDownInSeconds);
     }
 }
 
@@ -224,6 +439,7 @@ void AEnemy::OnAttackCoolDownTimerTimeout()
    if (IsAlive)
    {
        CanAttack = true;
+       SyncSimulationState();
    }
 }
 
@@ -232,22 +448,65 @@ void AEnemy::OnAttackOverrideAnimEnd(bool Completed)
     if (IsAlive)
     {
         CanMove = true;
+        SyncSimulationState();
+    }
+}
+
+void AEnemy::RestoreCrowdState(float StunTimeLeft, float AttackCoolDownLeft)
+{
+    if (StunTimeLeft > 0.0f)
+    {
+        Stun(StunTimeLeft);
+    }
+    
+    if (AttackCoolDownLeft > 0.0f)
+    {
+        CanAttack = false;
+        SyncSimulationState();
+        GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->SetTimer(AttackCoolDownTimer, this, &AEnemy::OnAttackCoolDownTimerTimeout, AttackCoolDownLeft);
     }
 }
 
+void AEnemy::GetCrowdState(float& OutStunTimeLeft, float& OutAttackCoolDownLeft) const
+{
+    const UGameplayTimerSubsystem* Timers = GetWorld()->GetSubsystem<UGameplayTimerSubsystem>();
+    OutStunTimeLeft = IsStunned ? FMath::Max(Timers->GetTimerRemaining(StunTimer), 0.0f) : 0.0f;
+    OutAttackCoolDownLeft = CanAttack ? 0.0f : FMath::Max(Timers->GetTimerRemaining(AttackCoolDownTimer), 0.0f);
+}
+
 void AEnemy::AttackBoxOverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+    SCOPE_CYCLE_COUNTER(STAT_EnemyAttackOverlap);
+    
     // Check if the object entering the collision box is the player
     APlayerCharacter* Player = Cast<APlayerCharacter>(OtherActor);
     
     if (Player)
     {
-        Player->TakeHit(AttackDamage, AttackStunDuration);
+        // The hit is applied by the combat subsystem at the end of the frame
+        GetWorld()->GetSubsystem<UCombatSubsystem>()->QueueHit(this, Player, AttackSwingId, AttackDamage, AttackStunDuration);
     }
 }
 
 void AEnemy::EnableAttackCollisionBox(bool Enabled)
 {
+    if (UseAttackSweep)
+    {
+        // The collision of the box stays disabled, the combat subsystem sweeps it while the attack window is open
+        if (UCombatSubsystem* Combat = GetWorld()->GetSubsystem<UCombatSubsystem>())
+        {
+            if (Enabled)
+            {
+                Combat->OpenAttackWindow(this, AttackCollisionBox, APlayerCharacter::StaticClass(), AttackSwingId, AttackDamage, AttackStunDuration);
+            }
+            else
+            {
+                Combat->CloseAttackWindow(this);
+            }
+        }
+        return;
+    }
+    
     if (Enabled)
     {
         // Enable the collision box
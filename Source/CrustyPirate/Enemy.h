@@ -10,11 +10,16 @@
 
 #include "Components/BoxComponent.h"
 
+#include "PaperSprite.h"
+
 #include "PaperZDAnimInstance.h"
 
-#include "Engine/TimerHandle.h"
+#include "GameplayTimerSubsystem.h"
+
+#include "MassEntityTypes.h"
 
 #include "PlayerCharacter.h"
+#include "EnemySubsystem.h"
 
 #include "Enemy.generated.h"
 
@@ -45,9 +50,26 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     float StopDistanceToTarget = 70.0f;
     
+    // Detect the player with the enemy subsystem's spatial grid instead of the PlayerDetectorSphere overlap events
+    // (the sphere radius is still used as the detection radius)
+    UPROPERTY(EditAnywhere, BlueprintReadOnly)
+    bool UseGridPlayerDetection = false;
+    
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     int HitPoints = 100;
     
+    // The hit points the enemy started with (full health bar)
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    int MaxHitPoints = 100;
+    
+    // Show the hit points with a bar drawn by the health bar subsystem instead of the HPText
+    // (the bar is centered on the HPText, which is not rendered)
+    UPROPERTY(EditAnywhere, BlueprintReadOnly)
+    bool UseInstancedHealthBar = false;
+    
+    UPROPERTY(EditAnywhere, BlueprintReadOnly)
+    UPaperSprite* HealthBarSprite;
+    
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     float AttackCoolDownInSeconds = 3.0f;
     
@@ -57,6 +79,15 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     float AttackStunDuration = 0.3f;
     
+    // How long the dead enemy stays in the level before it goes back to the enemy pool
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float CorpseTimeInSeconds = 3.0f;
+    
+    // Find the player hit by an attack by sweeping the AttackCollisionBox every frame of the attack window (see UCombatSubsystem)
+    // instead of switching its collision on and off and waiting for overlap events
+    UPROPERTY(EditAnywhere, BlueprintReadOnly)
+    bool UseAttackSweep = false;
+    
     UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
     bool IsAlive = true;
     
@@ -69,15 +100,53 @@ public:
     UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
     bool CanAttack = true;
     
-    FTimerHandle StunTimer;
+    FGameplayTimerHandle StunTimer;
+    
+    FGameplayTimerHandle AttackCoolDownTimer;
+    
+    FGameplayTimerHandle CorpseTimer;
     
-    FTimerHandle AttackCoolDownTimer;
+    // Id of the current attack, the combat subsystem only lets one swing hit the player once
+    int AttackSwingId = 0;
     
     FZDOnAnimationOverrideEndSignature OnAttackOverrideEndDelegate;
     
-    AEnemy();
+    // The chase/attack logic of all the enemies is run by the enemy subsystem instead of a per enemy Tick
+    UPROPERTY()
+    UEnemySubsystem* EnemySubsystem;
+    
+    // Index of this enemy in the enemy subsystem arrays (INDEX_NONE when not registered)
+    int SimulationIndex = INDEX_NONE;
+    
+    // Index of the health bar of this enemy (INDEX_NONE when the HPText is used or the enemy is dead)
+    int HealthBarIndex = INDEX_NONE;
+    
+    // The crab crowd entity this enemy was promoted from (unset for enemies placed in the level)
+    FMassEntityHandle CrowdEntity;
+    
+    // Spawned by the enemy pool (enemies placed in the level become spawn points of the pool instead)
+    bool IsFromPool = false;
+    
+    // Dead and waiting in the enemy pool to be reused
+    bool IsInPool = false;
+    
+    // Index of the enemy pool spawn point this enemy stands for (INDEX_NONE when it has none)
+    int SpawnPointIndex = INDEX_NONE;
+    
+    AEnemy(const FObjectInitializer& ObjectInitializer);
     virtual void BeginPlay() override;
-    virtual void Tick(float DeltaTime) override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    
+    // Must be called whenever IsAlive, IsStunned, CanMove, CanAttack or FollowTarget change
+    void SyncSimulationState();
+    
+    // Add/remove the enemy to/from the enemy subsystem and the tick LOD
+    void RegisterSimulation();
+    void UnregisterSimulation();
+    
+    // Called by the enemy pool when the enemy goes into the pool and when it comes out of it
+    void DeactivateForPool();
+    void ResetForReuse(const FTransform& Transform, int NewHitPoints);
     
     UFUNCTION()
     void DetectorOverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
@@ -85,20 +154,36 @@ public:
     UFUNCTION()
     void DetectorOverlapEnd(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
     
+    // Called when the player enters or leaves the detector (from the overlap events or the enemy subsystem)
+    void OnPlayerDetected(APlayerCharacter* Player);
+    void OnPlayerLost(APlayerCharacter* Player);
+    
+    // Make the enemy tick every frame again if the tick LOD put it to sleep
+    void WakeUp();
+    
     bool ShouldMoveToTarget();
     void UpdateDirection(float MoveDirection);
     
     void UpdateHP(int NewHP);
     
+    // Show/hide the hit points (HPText or instanced health bar)
+    void ShowHP(bool Visible);
+    
     void TakeHit(int DamageAmount, float StunDuration);
     
     void Stun(float DurationInSeconds);
     void OnStunTimerTimeout();
     
+    void OnCorpseTimerTimeout();
+    
     void Attack();
     void OnAttackCoolDownTimerTimeout();
     void OnAttackOverrideAnimEnd(bool Completed);
     
+    // Used by the crab crowd to carry the stun and attack cool down timers over when promoting/demoting the enemy
+    void RestoreCrowdState(float StunTimeLeft, float AttackCoolDownLeft);
+    void GetCrowdState(float& OutStunTimeLeft, float& OutAttackCoolDownLeft) const;
+    
     UFUNCTION()
     void AttackBoxOverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
     
@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyPoolSubsystem.h"
+
+#include "CrustyPirate.h"
+#include "Enemy.h"
+
+static TAutoConsoleVariable<int32> CVarEnemyPoolMaxSize(
+    TEXT("CrustyPirate.EnemyPool.MaxSize"),
+    32,
+    TEXT("Maximum number of dead enemies kept for reuse per enemy class (0 destroys dead enemies)."));
+
+static FAutoConsoleCommandWithWorld EnemyPoolStatsCommand(
+    TEXT("CrustyPirate.EnemyPool.Stats"),
+    TEXT("Print the enemy pool hits and misses."),
+    FConsoleCommandWithWorldDelegate::CreateStatic(&UEnemyPoolSubsystem::PrintStats));
+
+static FAutoConsoleCommandWithWorld EnemyPoolResetCommand(
+    TEXT("CrustyPirate.EnemyPool.ResetLevel"),
+    TEXT("Return every enemy placed in the level to its spawn point."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (UEnemyPoolSubsystem* Pool = World ? World->GetSubsystem<UEnemyPoolSubsystem>() : nullptr)
+        {
+            Pool->ResetEnemies();
+        }
+    }));
+
+AEnemy* UEnemyPoolSubsystem::AcquireEnemy(TSubclassOf<AEnemy> EnemyClass, const FTransform& Transform)
+{
+    LLM_SCOPE_BYTAG(CrustyPirate_Enemies);
+
+    if (!EnemyClass) return nullptr;
+
+    if (FEnemyFreeList* FreeList = FreeEnemies.Find(EnemyClass))
+    {
+        while (FreeList->Enemies.Num() > 0)
+        {
+            AEnemy* Enemy = FreeList->Enemies.Pop(EAllowShrinking::No);
+            if (!IsValid(Enemy)) continue;
+
+            PoolHits++;
+            Enemy->ResetForReuse(Transform, GetDefault<AEnemy>(EnemyClass)->HitPoints);
+            return Enemy;
+        }
+    }
+
+    PoolMisses++;
+
+    AEnemy* Enemy = GetWorld()->SpawnActorDeferred<AEnemy>(EnemyClass, Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+    if (!Enemy) return nullptr;
+
+    Enemy->IsFromPool = true;
+    Enemy->FinishSpawning(Transform);
+
+    // Spawned enemies are not possessed automatically and need a controller to move
+    if (!Enemy->Controller)
+    {
+        Enemy->SpawnDefaultController();
+    }
+
+    return Enemy;
+}
+
+void UEnemyPoolSubsystem::ReleaseEnemy(AEnemy* Enemy)
+{
+    if (!IsValid(Enemy) || Enemy->IsInPool) return;
+
+    if (SpawnPointEnemies.IsValidIndex(Enemy->SpawnPointIndex))
+    {
+        SpawnPointEnemies[Enemy->SpawnPointIndex] = nullptr;
+    }
+    Enemy->SpawnPointIndex = INDEX_NONE;
+
+    FEnemyFreeList& FreeList = FreeEnemies.FindOrAdd(Enemy->GetClass());
+    if (FreeList.Enemies.Num() >= CVarEnemyPoolMaxSize.GetValueOnGameThread())
+    {
+        PoolOverflows++;
+        Enemy->Destroy();
+        return;
+    }
+
+    PoolReleases++;
+    Enemy->DeactivateForPool();
+    FreeList.Enemies.Add(Enemy);
+}
+
+void UEnemyPoolSubsystem::AddSpawnPoint(AEnemy* Enemy)
+{
+    if (!Enemy || Enemy->SpawnPointIndex != INDEX_NONE) return;
+
+    Enemy->SpawnPointIndex = SpawnPoints.Add(FSpawnPoint{ Enemy->GetClass(), Enemy->GetActorTransform(), Enemy->HitPoints });
+    SpawnPointEnemies.Add(Enemy);
+}
+
+void UEnemyPoolSubsystem::ResetEnemies()
+{
+    for (int Index = 0; Index < SpawnPoints.Num(); Index++)
+    {
+        RestoreSpawnPoint(Index, true, SpawnPoints[Index].HitPoints, SpawnPoints[Index].Transform.GetLocation());
+    }
+}
+
+AEnemy* UEnemyPoolSubsystem::GetSpawnPointEnemy(int Index) const
+{
+    return SpawnPointEnemies.IsValidIndex(Index) ? SpawnPointEnemies[Index] : nullptr;
+}
+
+void UEnemyPoolSubsystem::RestoreSpawnPoint(int Index, bool IsAlive, int HitPoints, const FVector& Location)
+{
+    if (!SpawnPoints.IsValidIndex(Index)) return;
+
+    // Put the current enemy back in the pool, it is handed out again right below when the enemy has to be alive
+    if (AEnemy* Enemy = SpawnPointEnemies[Index])
+    {
+        ReleaseEnemy(Enemy);
+    }
+
+    if (!IsAlive) return;
+
+    const FSpawnPoint& SpawnPoint = SpawnPoints[Index];
+
+    AEnemy* Enemy = AcquireEnemy(SpawnPoint.EnemyClass, FTransform(SpawnPoint.Transform.GetRotation(), Location));
+    if (!Enemy) return;
+
+    // The enemy may have been placed with different hit points than its class
+    Enemy->MaxHitPoints = SpawnPoint.HitPoints;
+    Enemy->UpdateHP(HitPoints);
+    Enemy->SpawnPointIndex = Index;
+    SpawnPointEnemies[Index] = Enemy;
+}
+
+int UEnemyPoolSubsystem::GetNumPooledEnemies() const
+{
+    int Count = 0;
+    for (const TPair<TObjectPtr<UClass>, FEnemyFreeList>& Pair : FreeEnemies)
+    {
+        Count += Pair.Value.Enemies.Num();
+    }
+    return Count;
+}
+
+void UEnemyPoolSubsystem::PrintStats(UWorld* World)
+{
+    const UEnemyPoolSubsystem* Pool = World ? World->GetSubsystem<UEnemyPoolSubsystem>() : nullptr;
+    if (!Pool) return;
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Enemy pool: %d pooled enemies in %d classes, %d hits, %d misses, %d released, %d destroyed because the pool was full, %d spawn points"),
+           Pool->GetNumPooledEnemies(),
+           Pool->FreeEnemies.Num(),
+           Pool->PoolHits,
+           Pool->PoolMisses,
+           Pool->PoolReleases,
+           Pool->PoolOverflows,
+           Pool->SpawnPoints.Num());
+}
+
+bool UEnemyPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
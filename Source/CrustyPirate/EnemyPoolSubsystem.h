@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "EnemyPoolSubsystem.generated.h"
+
+class AEnemy;
+
+USTRUCT()
+struct FEnemyFreeList
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TArray<TObjectPtr<AEnemy>> Enemies;
+};
+
+/**
+ * Keeps dead enemies around (hidden, without collision and with their components deactivated) so they can
+ * be reused instead of spawning new actors. Enemies return to the pool once their corpse time is over and
+ * AcquireEnemy() hands them out again, reset to full health. The pool keeps at most MaxSize enemies per class.
+ * Enemies placed in the level are remembered as spawn points, ResetEnemies() puts the level back to its
+ * initial state using pooled enemies.
+ * "CrustyPirate.EnemyPool.Stats" prints the pool hits and misses.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UEnemyPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    // Take an enemy of the given class out of the pool (or spawn one if the pool is empty) and place it at Transform
+    AEnemy* AcquireEnemy(TSubclassOf<AEnemy> EnemyClass, const FTransform& Transform);
+
+    // Deactivate the enemy and keep it for reuse (destroyed when the pool of its class is full)
+    void ReleaseEnemy(AEnemy* Enemy);
+
+    // Remember where an enemy placed in the level started
+    void AddSpawnPoint(AEnemy* Enemy);
+
+    // Return every enemy placed in the level to its spawn point with full health
+    void ResetEnemies();
+
+    int GetNumSpawnPoints() const { return SpawnPoints.Num(); }
+
+    // The enemy currently standing for the spawn point (null when it died and went back to the pool)
+    AEnemy* GetSpawnPointEnemy(int Index) const;
+
+    // Bring the enemy of the spawn point back at the given location with the given hit points, or remove it when it is not alive
+    void RestoreSpawnPoint(int Index, bool IsAlive, int HitPoints, const FVector& Location);
+
+    int GetNumPooledEnemies() const;
+
+    int GetPoolHits() const { return PoolHits; }
+    int GetPoolMisses() const { return PoolMisses; }
+
+    static void PrintStats(UWorld* World);
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+    struct FSpawnPoint
+    {
+        TSubclassOf<AEnemy> EnemyClass;
+        FTransform Transform;
+        int HitPoints;
+    };
+
+    UPROPERTY()
+    TMap<TObjectPtr<UClass>, FEnemyFreeList> FreeEnemies;
+
+    // The enemies currently in play that belong to a spawn point
+    UPROPERTY()
+    TArray<TObjectPtr<AEnemy>> SpawnPointEnemies;
+
+    TArray<FSpawnPoint> SpawnPoints;
+
+    int PoolHits = 0;
+    int PoolMisses = 0;
+    int PoolReleases = 0;
+    int PoolOverflows = 0;
+};
@@ -0,0 +1,311 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemySubsystem.h"
+
+#include "Enemy.h"
+#include "FixedStepSubsystem.h"
+#include "PlayerCharacter.h"
+#include "CrustyPirate.h"
+
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Tick"), STAT_EnemyTick, STATGROUP_CrustyPirate);
+DECLARE_CYCLE_STAT(TEXT("Enemy Grid Detection"), STAT_EnemyGridDetection, STATGROUP_CrustyPirate);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Active"), STAT_EnemiesActive, STATGROUP_CrustyPirate);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Stunned"), STAT_EnemiesStunned, STATGROUP_CrustyPirate);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Attacking"), STAT_EnemiesAttacking, STATGROUP_CrustyPirate);
+
+void UEnemySubsystem::RegisterEnemy(AEnemy* Enemy)
+{
+    if (!Enemy || Enemy->SimulationIndex != INDEX_NONE) return;
+
+    Enemy->SimulationIndex = Enemies.Add(Enemy);
+    FollowTargets.Add(nullptr);
+    IsAlive.Add(false);
+    IsStunned.Add(false);
+    CanMove.Add(false);
+    CanAttack.Add(false);
+    StopDistanceToTarget.Add(0.0f);
+    PositionX.Add(Enemy->GetActorLocation().X);
+    // Enemies facing left are rotated by 180 degrees (see AEnemy::UpdateDirection)
+    FacingDirection.Add(Enemy->GetActorRotation().Yaw == 180.0f ? -1.0f : 1.0f);
+
+    const FVector DetectorLocation = Enemy->PlayerDetectorSphere->GetComponentLocation();
+    DetectorPosition.Add(FVector2D(DetectorLocation.X, DetectorLocation.Z));
+    DetectedPlayer.Add(nullptr);
+    DetectionStamp.Add(0);
+
+    if (Enemy->UseGridPlayerDetection)
+    {
+        const float Radius = Enemy->PlayerDetectorSphere->GetScaledSphereRadius();
+        DetectionRadius.Add(Radius);
+
+        if (Radius > MaxDetectionRadius)
+        {
+            // Keep the cells as big as the largest detector so a query only has to look at a few cells
+            MaxDetectionRadius = Radius;
+            DetectionGrid.Reset(MaxDetectionRadius);
+            for (int Index = 0; Index < Enemies.Num() - 1; Index++)
+            {
+                if (DetectionRadius[Index] > 0.0f)
+                {
+                    DetectionGrid.Add(Index, DetectorPosition[Index]);
+                }
+            }
+        }
+
+        DetectionGrid.Add(Enemy->SimulationIndex, DetectorPosition.Last());
+    }
+    else
+    {
+        DetectionRadius.Add(0.0f);
+    }
+
+    UpdateEnemyState(Enemy);
+}
+
+void UEnemySubsystem::UnregisterEnemy(AEnemy* Enemy)
+{
+    if (!Enemy || !Enemies.IsValidIndex(Enemy->SimulationIndex)) return;
+
+    const int Index = Enemy->SimulationIndex;
+    const int LastIndex = Enemies.Num() - 1;
+
+    // Forget the enemy in the detection grid and give the last enemy the index it is about to be moved to
+    DetectionGrid.Remove(Index);
+    DetectionGrid.ChangeId(LastIndex, Index);
+    DetectedEnemies.RemoveSingleSwap(Index);
+    for (int& DetectedIndex : DetectedEnemies)
+    {
+        if (DetectedIndex == LastIndex)
+        {
+            DetectedIndex = Index;
+        }
+    }
+
+    // Move the last enemy into the freed slot so the arrays stay contiguous
+    Enemies.RemoveAtSwap(Index);
+    FollowTargets.RemoveAtSwap(Index);
+    IsAlive.RemoveAtSwap(Index);
+    IsStunned.RemoveAtSwap(Index);
+    CanMove.RemoveAtSwap(Index);
+    CanAttack.RemoveAtSwap(Index);
+    StopDistanceToTarget.RemoveAtSwap(Index);
+    PositionX.RemoveAtSwap(Index);
+    FacingDirection.RemoveAtSwap(Index);
+    DetectionRadius.RemoveAtSwap(Index);
+    DetectorPosition.RemoveAtSwap(Index);
+    DetectedPlayer.RemoveAtSwap(Index);
+    DetectionStamp.RemoveAtSwap(Index);
+
+    if (Enemies.IsValidIndex(Index) && Enemies[Index])
+    {
+        Enemies[Index]->SimulationIndex = Index;
+    }
+
+    Enemy->SimulationIndex = INDEX_NONE;
+}
+
+void UEnemySubsystem::UpdateEnemyState(AEnemy* Enemy)
+{
+    if (!Enemy || !Enemies.IsValidIndex(Enemy->SimulationIndex)) return;
+
+    const int Index = Enemy->SimulationIndex;
+
+    FollowTargets[Index] = Enemy->FollowTarget;
+    IsAlive[Index] = Enemy->IsAlive;
+    IsStunned[Index] = Enemy->IsStunned;
+    CanMove[Index] = Enemy->CanMove;
+    CanAttack[Index] = Enemy->CanAttack;
+    StopDistanceToTarget[Index] = Enemy->StopDistanceToTarget;
+}
+
+void UEnemySubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    
+    // The fixed step subsystem runs the simulation in its steps
+    const UFixedStepSubsystem* FixedStep = GetWorld()->GetSubsystem<UFixedStepSubsystem>();
+    if (FixedStep && FixedStep->IsEnabled()) return;
+    
+    Simulate();
+}
+
+void UEnemySubsystem::Simulate()
+{
+    SCOPE_CYCLE_COUNTER(STAT_EnemyTick);
+
+    const int NumEnemies = Enemies.Num();
+
+    // Refresh the cached positions
+    for (int Index = 0; Index < NumEnemies; Index++)
+    {
+        if (Enemies[Index])
+        {
+            PositionX[Index] = Enemies[Index]->GetActorLocation().X;
+            
+            if (DetectionRadius[Index] > 0.0f)
+            {
+                const FVector DetectorLocation = Enemies[Index]->PlayerDetectorSphere->GetComponentLocation();
+                DetectorPosition[Index] = FVector2D(DetectorLocation.X, DetectorLocation.Z);
+                DetectionGrid.Move(Index, DetectorPosition[Index]);
+            }
+        }
+    }
+    
+    if (MaxDetectionRadius > 0.0f)
+    {
+        UpdateGridDetection();
+    }
+
+    // Most of the time every enemy chases the same player, so only look its state up once
+    APlayerCharacter* CachedTarget = nullptr;
+    float CachedTargetX = 0.0f;
+    bool CachedTargetAlive = false;
+
+    int NumActive = 0;
+    int NumStunned = 0;
+    int NumAttacking = 0;
+    
+    for (int Index = 0; Index < NumEnemies; Index++)
+    {
+        // Enemies that cannot attack while alive and not stunned are in their attack or its cool down
+        if (IsAlive[Index])
+        {
+            NumActive++;
+            if (IsStunned[Index])
+            {
+                NumStunned++;
+            }
+            else if (!CanAttack[Index])
+            {
+                NumAttacking++;
+            }
+        }
+        
+        APlayerCharacter* Target = FollowTargets[Index];
+
+        // Only enemies that are alive, not stunned and have a follow target do anything
+        if (!IsAlive[Index] || IsStunned[Index] || !Target) continue;
+
+        AEnemy* Enemy = Enemies[Index];
+        if (!Enemy) continue;
+
+        if (Target != CachedTarget)
+        {
+            CachedTarget = Target;
+            CachedTargetX = Target->GetActorLocation().X;
+            CachedTargetAlive = Target->IsAlive;
+        }
+
+        const float OffsetToTarget = CachedTargetX - PositionX[Index];
+
+        // Get the direction of the enemy relative to the player and only turn the enemy when it changes
+        const float MoveDirection = OffsetToTarget > 0.0f ? 1.0f : -1.0f;
+        if (MoveDirection != FacingDirection[Index])
+        {
+            FacingDirection[Index] = MoveDirection;
+            Enemy->UpdateDirection(MoveDirection);
+        }
+
+        // Move to target if not close enough
+        if (FMath::Abs(OffsetToTarget) > StopDistanceToTarget[Index])
+        {
+            if (CanMove[Index])
+            {
+                Enemy->AddMovementInput(FVector(1.0f, 0.0f, 0.0f), MoveDirection);
+            }
+        }
+        // Otherwise we are close enough and should attack
+        else if (CachedTargetAlive && CanAttack[Index])
+        {
+            // Attack() pushes the new CanAttack/CanMove state back through UpdateEnemyState
+            Enemy->Attack();
+        }
+    }
+    
+    SET_DWORD_STAT(STAT_EnemiesActive, NumActive);
+    SET_DWORD_STAT(STAT_EnemiesStunned, NumStunned);
+    SET_DWORD_STAT(STAT_EnemiesAttacking, NumAttacking);
+}
+
+void UEnemySubsystem::UpdateGridDetection()
+{
+    SCOPE_CYCLE_COUNTER(STAT_EnemyGridDetection);
+    
+    CurrentDetectionStamp++;
+    NewlyDetectedEnemies.Reset();
+    
+    TArray<int> Candidates;
+    
+    for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+    {
+        APlayerController* PlayerController = Iterator->Get();
+        APlayerCharacter* Player = PlayerController ? Cast<APlayerCharacter>(PlayerController->GetPawn()) : nullptr;
+        if (!Player) continue;
+        
+        // The detector sphere overlaps the player when it touches the player's capsule
+        const UCapsuleComponent* Capsule = Player->GetCapsuleComponent();
+        const FVector PlayerLocation = Capsule->GetComponentLocation();
+        const float CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+        const float CapsuleSegmentHalfHeight = Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere();
+        
+        Candidates.Reset();
+        DetectionGrid.Query(FVector2D(PlayerLocation.X, PlayerLocation.Z), MaxDetectionRadius + CapsuleRadius + CapsuleSegmentHalfHeight, Candidates);
+        
+        for (int Index : Candidates)
+        {
+            if (DetectionStamp[Index] == CurrentDetectionStamp) continue;
+            
+            // Distance from the center of the detector to the segment running through the capsule
+            const float DeltaX = DetectorPosition[Index].X - PlayerLocation.X;
+            const float DeltaZ = FMath::Max(FMath::Abs(DetectorPosition[Index].Y - PlayerLocation.Z) - CapsuleSegmentHalfHeight, 0.0f);
+            const float TouchDistance = DetectionRadius[Index] + CapsuleRadius;
+            
+            if (DeltaX * DeltaX + DeltaZ * DeltaZ <= TouchDistance * TouchDistance)
+            {
+                DetectionStamp[Index] = CurrentDetectionStamp;
+                NewlyDetectedEnemies.Add(Index);
+                
+                // Entering the detector
+                if (DetectedPlayer[Index] != Player)
+                {
+                    DetectedPlayer[Index] = Player;
+                    if (Enemies[Index])
+                    {
+                        Enemies[Index]->OnPlayerDetected(Player);
+                    }
+                }
+            }
+        }
+    }
+    
+    // Enemies that detected a player last frame but not this frame lost it
+    for (int Index : DetectedEnemies)
+    {
+        if (DetectionStamp[Index] != CurrentDetectionStamp)
+        {
+            APlayerCharacter* Player = DetectedPlayer[Index];
+            DetectedPlayer[Index] = nullptr;
+            if (Enemies[Index])
+            {
+                Enemies[Index]->OnPlayerLost(Player);
+            }
+        }
+    }
+    
+    Swap(DetectedEnemies, NewlyDetectedEnemies);
+}
+
+TStatId UEnemySubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemySubsystem, STATGROUP_Tickables);
+}
+
+bool UEnemySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    // Enemies only need simulating in the game (or play in editor) worlds
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
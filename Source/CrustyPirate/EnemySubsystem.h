@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "SpatialGrid2D.h"
+
+#include "EnemySubsystem.generated.h"
+
+class AEnemy;
+class APlayerCharacter;
+
+/**
+ * Runs the chase/attack logic of every enemy in the world in a single pass per frame.
+ * Enemies register themselves in BeginPlay and push their state here whenever it changes, so the
+ * per-frame loop only reads tightly packed arrays (one entry per enemy, same index in every array)
+ * and only calls back into an enemy when it has to turn, move or attack.
+ * Enemies using grid player detection are also kept in a spatial grid that is queried once per frame
+ * around each player instead of relying on the overlap events of their PlayerDetectorSphere.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UEnemySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    void RegisterEnemy(AEnemy* Enemy);
+    void UnregisterEnemy(AEnemy* Enemy);
+
+    // Copy the chase/attack state of the enemy into the simulation arrays
+    void UpdateEnemyState(AEnemy* Enemy);
+
+    int GetNumEnemies() const { return Enemies.Num(); }
+
+    // Run the chase/attack logic of every enemy once (every frame, or every step of UFixedStepSubsystem)
+    void Simulate();
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+    // The registered enemies. Every array below is indexed the same way (AEnemy::SimulationIndex)
+    UPROPERTY()
+    TArray<TObjectPtr<AEnemy>> Enemies;
+
+    UPROPERTY()
+    TArray<TObjectPtr<APlayerCharacter>> FollowTargets;
+
+    TArray<bool> IsAlive;
+    TArray<bool> IsStunned;
+    TArray<bool> CanMove;
+    TArray<bool> CanAttack;
+    TArray<float> StopDistanceToTarget;
+
+    // Cached X position of every enemy, refreshed once per frame
+    TArray<float> PositionX;
+
+    // The direction the enemy is currently facing (-1 left, +1 right)
+    TArray<float> FacingDirection;
+
+    // Radius of the player detector of enemies using grid detection (0 for enemies using overlap events)
+    TArray<float> DetectionRadius;
+
+    // Cached X/Z position of the player detector of enemies using grid detection
+    TArray<FVector2D> DetectorPosition;
+
+    // The player currently inside the detector of the enemy (grid detection only)
+    UPROPERTY()
+    TArray<TObjectPtr<APlayerCharacter>> DetectedPlayer;
+
+    // The last detection pass that found a player inside the detector of the enemy
+    TArray<uint32> DetectionStamp;
+
+    FSpatialGrid2D DetectionGrid;
+
+    // Largest detector radius of the enemies in the grid, used as the grid cell size
+    float MaxDetectionRadius = 0.0f;
+
+    uint32 CurrentDetectionStamp = 0;
+
+    // Indices of the enemies that currently have a player inside their detector (grid detection only)
+    TArray<int> DetectedEnemies;
+    TArray<int> NewlyDetectedEnemies;
+
+    // Query the grid around every player and report the enter/leave transitions to the enemies
+    void UpdateGridDetection();
+};
@@ -0,0 +1,379 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FixedStepSubsystem.h"
+
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/SpringArmComponent.h"
+#include "PaperCharacter.h"
+#include "PaperFlipbookComponent.h"
+#include "PaperZDAnimationComponent.h"
+#include "Components/TextRenderComponent.h"
+
+#include "CrustyPirate.h"
+#include "CombatSubsystem.h"
+#include "EnemySubsystem.h"
+#include "GameplayTimerSubsystem.h"
+#include "TickLODSubsystem.h"
+
+static TAutoConsoleVariable<bool> CVarFixedStepEnabled(
+    TEXT("CrustyPirate.FixedStep.Enabled"),
+    false,
+    TEXT("Run the gameplay simulation in fixed steps (read when a level begins play)."));
+
+static TAutoConsoleVariable<float> CVarFixedStepRate(
+    TEXT("CrustyPirate.FixedStep.Rate"),
+    120.0f,
+    TEXT("Number of gameplay steps per second (read when a level begins play)."));
+
+static TAutoConsoleVariable<int32> CVarFixedStepMaxStepsPerFrame(
+    TEXT("CrustyPirate.FixedStep.MaxStepsPerFrame"),
+    8,
+    TEXT("Most steps run in one frame, the time of longer frames is dropped so a slow frame cannot make the next ones slower."));
+
+static TAutoConsoleVariable<int32> CVarFixedStepStepsPerFrame(
+    TEXT("CrustyPirate.FixedStep.StepsPerFrame"),
+    0,
+    TEXT("Run exactly this many steps every frame whatever the frame time (0 follows the frame time)."));
+
+static FAutoConsoleCommandWithWorld FixedStepStatsCommand(
+    TEXT("CrustyPirate.FixedStep.Stats"),
+    TEXT("Print the fixed step counters."),
+    FConsoleCommandWithWorldDelegate::CreateStatic(&UFixedStepSubsystem::PrintStats));
+
+// A character that moved further than this in one step was teleported (respawn, pool reuse) and is not interpolated
+static const float TeleportDistance = 200.0f;
+
+void FFixedStepTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+    if (Subsystem && TickType != LEVELTICK_ViewportsOnly)
+    {
+        Subsystem->Advance(DeltaTime);
+    }
+}
+
+FString FFixedStepTickFunction::DiagnosticMessage()
+{
+    return TEXT("FFixedStepTickFunction");
+}
+
+void UFixedStepSubsystem::GetSettings(bool& OutIsEnabled, float& OutRate, int& OutStepsPerFrame)
+{
+    OutIsEnabled = CVarFixedStepEnabled.GetValueOnGameThread();
+    OutRate = CVarFixedStepRate.GetValueOnGameThread();
+    OutStepsPerFrame = CVarFixedStepStepsPerFrame.GetValueOnGameThread();
+}
+
+void UFixedStepSubsystem::SetSettings(bool IsEnabled, float Rate, int StepsPerFrame)
+{
+    CVarFixedStepEnabled->Set(IsEnabled, ECVF_SetByCode);
+    CVarFixedStepRate->Set(Rate, ECVF_SetByCode);
+    CVarFixedStepStepsPerFrame->Set(StepsPerFrame, ECVF_SetByCode);
+}
+
+void UFixedStepSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+
+    IsFixedStepWorld = CVarFixedStepEnabled.GetValueOnGameThread();
+    if (!IsFixedStepWorld) return;
+
+    StepSeconds = 1.0f / FMath::Max(CVarFixedStepRate.GetValueOnGameThread(), 1.0f);
+
+    // Runs in PrePhysics once the player controllers processed the input (see Advance)
+    StepTickFunction.Subsystem = this;
+    StepTickFunction.bCanEverTick = true;
+    StepTickFunction.TickGroup = TG_PrePhysics;
+    StepTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Gameplay runs in fixed steps of %.2f ms"), StepSeconds * 1000.0f);
+}
+
+void UFixedStepSubsystem::Deinitialize()
+{
+    if (StepTickFunction.IsTickFunctionRegistered())
+    {
+        StepTickFunction.UnRegisterTickFunction();
+    }
+
+    Super::Deinitialize();
+}
+
+void UFixedStepSubsystem::RegisterCharacter(ACharacter* Character)
+{
+    if (!IsFixedStepWorld || !Character) return;
+
+    FSimulatedCharacter* Simulated = Characters.FindByPredicate([Character](const FSimulatedCharacter& Candidate)
+    {
+        return Candidate.Character.Get() == Character;
+    });
+    if (!Simulated)
+    {
+        Simulated = &Characters.AddDefaulted_GetRef();
+        Simulated->Character = Character;
+        Simulated->Movement = Character->GetCharacterMovement();
+        Simulated->Animation = Character->FindComponentByClass<UPaperZDAnimationComponent>();
+
+        if (const APaperCharacter* PaperCharacter = Cast<APaperCharacter>(Character))
+        {
+            if (UPaperFlipbookComponent* Sprite = PaperCharacter->GetSprite())
+            {
+                Simulated->VisualComponents.Emplace(Sprite, Sprite->GetRelativeLocation());
+            }
+        }
+        if (USpringArmComponent* SpringArm = Character->FindComponentByClass<USpringArmComponent>())
+        {
+            Simulated->VisualComponents.Emplace(SpringArm, SpringArm->GetRelativeLocation());
+        }
+
+        // The HP text of the enemies is also the anchor of their health bar (see UHealthBarSubsystem)
+        TInlineComponentArray<UTextRenderComponent*> TextComponents(Character);
+        for (UTextRenderComponent* Text : TextComponents)
+        {
+            Simulated->VisualComponents.Emplace(Text, Text->GetRelativeLocation());
+        }
+
+        // Once activated again, the components cannot tick before the step tick function turned them off
+        if (UActorComponent* Movement = Simulated->Movement.Get())
+        {
+            Movement->PrimaryComponentTick.AddPrerequisite(this, StepTickFunction);
+        }
+        if (UActorComponent* Animation = Simulated->Animation.Get())
+        {
+            Animation->PrimaryComponentTick.AddPrerequisite(this, StepTickFunction);
+        }
+    }
+
+    // Registered again when the character comes back from the pool, so it does not slide from where it was
+    Simulated->PreviousLocation = Character->GetActorLocation();
+    Simulated->CurrentLocation = Simulated->PreviousLocation;
+
+    ClaimComponentTicks(*Simulated);
+}
+
+void UFixedStepSubsystem::UnregisterCharacter(ACharacter* Character)
+{
+    if (!Character) return;
+
+    // Removed before the next frame is stepped, the steps can be running right now
+    for (FSimulatedCharacter& Simulated : Characters)
+    {
+        if (Simulated.Character.Get() == Character)
+        {
+            Simulated.Character.Reset();
+        }
+    }
+}
+
+void UFixedStepSubsystem::ClaimComponentTicks(const FSimulatedCharacter& Simulated) const
+{
+    if (UActorComponent* Movement = Simulated.Movement.Get())
+    {
+        if (Movement->IsComponentTickEnabled())
+        {
+            Movement->SetComponentTickEnabled(false);
+        }
+    }
+    if (UActorComponent* Animation = Simulated.Animation.Get())
+    {
+        if (Animation->IsComponentTickEnabled())
+        {
+            Animation->SetComponentTickEnabled(false);
+        }
+    }
+}
+
+void UFixedStepSubsystem::Advance(float DeltaTime)
+{
+    NumFrames++;
+
+    Characters.RemoveAll([](const FSimulatedCharacter& Simulated) { return !Simulated.Character.IsValid(); });
+
+    // The player input is processed by the controller ticks, the steps have to wait for them (from the next frame on)
+    for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+    {
+        if (APlayerController* PlayerController = Iterator->Get())
+        {
+            StepTickFunction.AddPrerequisite(PlayerController, PlayerController->PrimaryActorTick);
+        }
+    }
+
+    int StepsToRun;
+    const int FixedStepsPerFrame = CVarFixedStepStepsPerFrame.GetValueOnGameThread();
+    if (FixedStepsPerFrame > 0)
+    {
+        StepsToRun = FixedStepsPerFrame;
+        Accumulator = StepSeconds;
+    }
+    else
+    {
+        Accumulator += DeltaTime;
+        StepsToRun = FMath::FloorToInt(Accumulator / StepSeconds);
+        Accumulator -= StepsToRun * StepSeconds;
+
+        const int MaxSteps = FMath::Max(CVarFixedStepMaxStepsPerFrame.GetValueOnGameThread(), 1);
+        if (StepsToRun > MaxSteps)
+        {
+            NumFramesOverMaxSteps++;
+            StepsToRun = MaxSteps;
+        }
+    }
+    MaxStepsInFrame = FMath::Max(MaxStepsInFrame, StepsToRun);
+
+    for (FSimulatedCharacter& Simulated : Characters)
+    {
+        ClaimComponentTicks(Simulated);
+
+        // The movement component consumes the input on the first step, the other steps get it again
+        ACharacter* Character = Simulated.Character.Get();
+        Simulated.PlayerInput = Character->IsPlayerControlled() ? Character->GetPendingMovementInputVector() : FVector::ZeroVector;
+    }
+
+    for (int StepIndex = 0; StepIndex < StepsToRun; StepIndex++)
+    {
+        if (StepIndex > 0)
+        {
+            for (const FSimulatedCharacter& Simulated : Characters)
+            {
+                ACharacter* Character = Simulated.Character.Get();
+                if (Character && !Simulated.PlayerInput.IsZero())
+                {
+                    Character->AddMovementInput(Simulated.PlayerInput);
+                }
+            }
+        }
+
+        Step();
+    }
+
+    Interpolate(FMath::Clamp(Accumulator / StepSeconds, 0.0f, 1.0f));
+}
+
+void UFixedStepSubsystem::Step()
+{
+    UWorld* World = GetWorld();
+
+    if (UEnemySubsystem* Enemies = World->GetSubsystem<UEnemySubsystem>())
+    {
+        Enemies->Simulate();
+    }
+
+    const UTickLODSubsystem* TickLOD = World->GetSubsystem<UTickLODSubsystem>();
+    const float ReducedInterval = UTickLODSubsystem::GetReducedInterval();
+
+    // The components can hit, kill or release characters, so nothing is kept across their ticks
+    for (int Index = 0; Index < Characters.Num(); Index++)
+    {
+        ACharacter* Character = Characters[Index].Character.Get();
+        if (!Character) continue;
+
+        // Characters far from the view sleep like they would with their own ticks
+        const ETickLODTier Tier = TickLOD ? TickLOD->GetActorTier(Character) : ETickLODTier::Full;
+        if (Tier == ETickLODTier::Asleep)
+        {
+            Characters[Index].SkippedSeconds = 0.0f;
+            continue;
+        }
+
+        // Characters close to the view are stepped at the reduced tick interval, with the time of the steps they skipped
+        float DeltaTime = StepSeconds + Characters[Index].SkippedSeconds;
+        if (Tier == ETickLODTier::Reduced && DeltaTime < ReducedInterval)
+        {
+            FSimulatedCharacter& Simulated = Characters[Index];
+            Simulated.SkippedSeconds = DeltaTime;
+            // Drawn where it stands until its next step
+            Simulated.PreviousLocation = Simulated.CurrentLocation;
+            continue;
+        }
+        Characters[Index].SkippedSeconds = 0.0f;
+
+        UCharacterMovementComponent* Movement = Characters[Index].Movement.Get();
+        if (Movement && Movement->IsActive())
+        {
+            Movement->TickComponent(DeltaTime, LEVELTICK_All, &Movement->PrimaryComponentTick);
+        }
+
+        UActorComponent* Animation = Characters[Index].Animation.Get();
+        if (Animation && Animation->IsActive())
+        {
+            Animation->TickComponent(DeltaTime, LEVELTICK_All, &Animation->PrimaryComponentTick);
+        }
+
+        if (Characters.IsValidIndex(Index) && Characters[Index].Character.Get() == Character)
+        {
+            FSimulatedCharacter& Simulated = Characters[Index];
+            Simulated.PreviousLocation = Simulated.CurrentLocation;
+            Simulated.CurrentLocation = Character->GetActorLocation();
+            if (FVector::DistSquared(Simulated.PreviousLocation, Simulated.CurrentLocation) > FMath::Square(TeleportDistance))
+            {
+                Simulated.PreviousLocation = Simulated.CurrentLocation;
+            }
+        }
+    }
+
+    if (UCombatSubsystem* Combat = World->GetSubsystem<UCombatSubsystem>())
+    {
+        Combat->ResolveHits();
+    }
+
+    if (UGameplayTimerSubsystem* Timers = World->GetSubsystem<UGameplayTimerSubsystem>())
+    {
+        Timers->AdvanceTime(StepSeconds);
+    }
+
+    NumSteps++;
+}
+
+void UFixedStepSubsystem::Interpolate(float Alpha)
+{
+    for (const FSimulatedCharacter& Simulated : Characters)
+    {
+        const ACharacter* Character = Simulated.Character.Get();
+        if (!Character || !Character->GetRootComponent()) continue;
+
+        // Teleports outside of the steps are not interpolated either
+        const FVector ActorLocation = Character->GetActorLocation();
+        FVector Offset = FMath::Lerp(Simulated.PreviousLocation, Simulated.CurrentLocation, Alpha) - ActorLocation;
+        if (Offset.SizeSquared() > FMath::Square(TeleportDistance))
+        {
+            Offset = FVector::ZeroVector;
+        }
+
+        const FVector LocalOffset = Character->GetRootComponent()->GetComponentTransform().InverseTransformVectorNoScale(Offset);
+        for (const TPair<TWeakObjectPtr<USceneComponent>, FVector>& Visual : Simulated.VisualComponents)
+        {
+            if (USceneComponent* Component = Visual.Key.Get())
+            {
+                Component->SetRelativeLocation(Visual.Value + LocalOffset);
+            }
+        }
+    }
+}
+
+void UFixedStepSubsystem::PrintStats(UWorld* World)
+{
+    const UFixedStepSubsystem* FixedStep = World ? World->GetSubsystem<UFixedStepSubsystem>() : nullptr;
+    if (!FixedStep) return;
+
+    if (!FixedStep->IsFixedStepWorld)
+    {
+        UE_LOG(LogCrustyPirate, Display, TEXT("Fixed steps are off in this level (CrustyPirate.FixedStep.Enabled)"));
+        return;
+    }
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Fixed steps: %.2f ms per step, %llu steps in %llu frames (%.2f per frame), at most %d in a frame, %d frames dropped time, %d characters"),
+           FixedStep->StepSeconds * 1000.0f,
+           FixedStep->NumSteps,
+           FixedStep->NumFrames,
+           FixedStep->NumFrames > 0 ? (double)FixedStep->NumSteps / FixedStep->NumFrames : 0.0,
+           FixedStep->MaxStepsInFrame,
+           FixedStep->NumFramesOverMaxSteps,
+           FixedStep->Characters.Num());
+}
+
+bool UFixedStepSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+
+#include "FixedStepSubsystem.generated.h"
+
+class ACharacter;
+class UCharacterMovementComponent;
+class UFixedStepSubsystem;
+
+USTRUCT()
+struct FFixedStepTickFunction : public FTickFunction
+{
+    GENERATED_BODY()
+
+    UFixedStepSubsystem* Subsystem = nullptr;
+
+    virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+    virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FFixedStepTickFunction> : public TStructOpsTypeTraitsBase2<FFixedStepTickFunction>
+{
+    enum { WithCopy = false };
+};
+
+/**
+ * Runs the gameplay simulation in fixed steps (CrustyPirate.FixedStep.Rate per second) instead of once per
+ * rendered frame, when CrustyPirate.FixedStep.Enabled is set as the world begins play. Every step runs, in order:
+ * the enemy chase/attack logic, the movement and animation components of the registered characters (their own
+ * ticks are turned off), the combat resolve and the gameplay timers. The frame time is accumulated and as many
+ * steps as it covers are run in PrePhysics, right after the player controllers processed the input. The sprites,
+ * the text components (the HP text the enemy health bars follow) and the camera of the player are then placed
+ * between the last two steps so the motion stays smooth.
+ * Characters follow their tick LOD tier (see UTickLODSubsystem): asleep ones are not stepped and reduced ones are
+ * stepped once per CrustyPirate.TickLOD.ReducedInterval with the time they skipped.
+ * The input is still read once per rendered frame: every step of a frame gets the same movement input, and a jump
+ * or attack pressed during the frame starts on its first step. The same input on the same steps gives the same
+ * outcome whatever the number of steps per frame, but a lower frame rate moves presses to the first step of a
+ * later frame, so outcomes do depend on the frame rate at that resolution. The crab crowd (see UCrabCrowdSubsystem)
+ * is not stepped either and moves with the frame time. With CrustyPirate.FixedStep.StepsPerFrame above 0, exactly
+ * that many steps run every frame whatever the frame time, which runs the simulation faster than real time in
+ * -nullrhi runs without a frame rate limit.
+ * "CrustyPirate.FixedStep.Stats" prints the step counters.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UFixedStepSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    // Whether the gameplay of this world runs in fixed steps
+    bool IsEnabled() const { return IsFixedStepWorld; }
+
+    float GetStepSeconds() const { return StepSeconds; }
+
+    // Let the subsystem step the movement and animation of the character (does nothing when fixed steps are off)
+    void RegisterCharacter(ACharacter* Character);
+    void UnregisterCharacter(ACharacter* Character);
+
+    // Run the simulation for DeltaTime worth of steps
+    void Advance(float DeltaTime);
+
+    // The fixed step console variables (the input replay plays a recording back with the ones it was made with)
+    static void GetSettings(bool& OutIsEnabled, float& OutRate, int& OutStepsPerFrame);
+    static void SetSettings(bool IsEnabled, float Rate, int StepsPerFrame);
+
+    virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+    virtual void Deinitialize() override;
+
+    static void PrintStats(UWorld* World);
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+    struct FSimulatedCharacter
+    {
+        TWeakObjectPtr<ACharacter> Character;
+        TWeakObjectPtr<UCharacterMovementComponent> Movement;
+        TWeakObjectPtr<UActorComponent> Animation;
+
+        // The components placed between the last two steps, with their relative location when the character registered
+        TArray<TPair<TWeakObjectPtr<USceneComponent>, FVector>> VisualComponents;
+
+        FVector PreviousLocation = FVector::ZeroVector;
+        FVector CurrentLocation = FVector::ZeroVector;
+
+        // Movement input of a player for the frame, given again to every step after the first one
+        FVector PlayerInput = FVector::ZeroVector;
+
+        // Time of the steps skipped in the reduced tick LOD tier, given to the next step of the character
+        float SkippedSeconds = 0.0f;
+    };
+
+    void Step();
+
+    // Turn off the own ticks of the components stepped here (activating a component turns its tick back on,
+    // their tick functions wait for the step tick function so they are turned off again before they can run)
+    void ClaimComponentTicks(const FSimulatedCharacter& Simulated) const;
+
+    // Place the visual components of every character between its last two step locations
+    void Interpolate(float Alpha);
+
+    bool IsFixedStepWorld = false;
+    float StepSeconds = 1.0f / 120.0f;
+    float Accumulator = 0.0f;
+
+    FFixedStepTickFunction StepTickFunction;
+
+    TArray<FSimulatedCharacter> Characters;
+
+    uint64 NumSteps = 0;
+    uint64 NumFrames = 0;
+    int MaxStepsInFrame = 0;
+    int NumFramesOverMaxSteps = 0;
+};
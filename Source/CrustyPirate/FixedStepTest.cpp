@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "InputActionValue.h"
+
+#include "FixedStepSubsystem.h"
+#include "PlayerCharacter.h"
+#include "Enemy.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFixedStepStepsPerFrameTest, "CrustyPirate.FixedStep.StepsPerFrame",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+static const TCHAR* FixedStepPlayerClassPath = TEXT("/Game/Blueprints/Characters/Blueprint_PlayerCharacter.Blueprint_PlayerCharacter_C");
+static const TCHAR* FixedStepEnemyClassPath = TEXT("/Game/Blueprints/Characters/Blueprint_Enemy.Blueprint_Enemy_C");
+
+static const float FixedStepTestRate = 120.0f;
+
+// 6 seconds of steps. Every input below starts and ends on a multiple of 4 steps, so with 4 steps per frame it
+// falls on the first step of a frame, the only one the input can reach
+static const int FixedStepTestSteps = 720;
+
+struct FFixedStepTestResult
+{
+    FVector PlayerLocation = FVector::ZeroVector;
+    int PlayerHitPoints = 0;
+    FVector EnemyLocation = FVector::ZeroVector;
+    int EnemyHitPoints = 0;
+};
+
+// The input of the player on the step: walk to the enemy, jump, walk back, attack twice and walk to it again
+static void ApplyScriptedInput(APlayerCharacter* Player, int Step)
+{
+    if ((Step >= 40 && Step < 200) || (Step >= 480 && Step < 600))
+    {
+        Player->Move(FInputActionValue(1.0f));
+    }
+    else if (Step >= 280 && Step < 360)
+    {
+        Player->Move(FInputActionValue(-1.0f));
+    }
+
+    if (Step == 200)
+    {
+        Player->JumpStarted(FInputActionValue(true));
+    }
+    else if (Step == 240)
+    {
+        Player->JumpEnded(FInputActionValue(false));
+    }
+    else if (Step == 360 || Step == 420)
+    {
+        Player->Attack(FInputActionValue(true));
+    }
+}
+
+// Play the script in a new world running StepsPerFrame steps every frame
+static bool RunScript(FAutomationTestBase& Test, int StepsPerFrame, FFixedStepTestResult& OutResult)
+{
+    UClass* PlayerClass = LoadClass<APlayerCharacter>(nullptr, FixedStepPlayerClassPath);
+    UClass* EnemyClass = LoadClass<AEnemy>(nullptr, FixedStepEnemyClassPath);
+    UStaticMesh* FloorMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+    if (!Test.TestNotNull(TEXT("Player class"), PlayerClass) || !Test.TestNotNull(TEXT("Enemy class"), EnemyClass) || !Test.TestNotNull(TEXT("Floor mesh"), FloorMesh)) return false;
+
+    // Read by the subsystem when the world begins play
+    UFixedStepSubsystem::SetSettings(true, FixedStepTestRate, StepsPerFrame);
+
+    UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+    FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    WorldContext.SetCurrentWorld(World);
+
+    const FURL URL;
+    World->SetGameMode(URL);
+    World->InitializeActorsForPlay(URL);
+    World->BeginPlay();
+
+    AStaticMeshActor* Floor = World->SpawnActor<AStaticMeshActor>(FVector(0.0f, 0.0f, -50.0f), FRotator::ZeroRotator);
+    Floor->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+    Floor->GetStaticMeshComponent()->SetStaticMesh(FloorMesh);
+    Floor->SetActorScale3D(FVector(100.0f, 100.0f, 1.0f));
+
+    APlayerCharacter* Player = World->SpawnActorDeferred<APlayerCharacter>(PlayerClass, FTransform(FVector(0.0f, 0.0f, 100.0f)));
+    Player->PlayerHUDClass = nullptr;
+    Player->ItemPickupSound = nullptr;
+    Player->FinishSpawning(FTransform(FVector(0.0f, 0.0f, 100.0f)));
+
+    APlayerController* Controller = World->SpawnActor<APlayerController>();
+    Controller->Possess(Player);
+
+    AEnemy* Enemy = World->SpawnActor<AEnemy>(EnemyClass, FVector(400.0f, 0.0f, 100.0f), FRotator::ZeroRotator);
+
+    const bool IsStepped = Test.TestTrue(TEXT("Fixed steps"), World->GetSubsystem<UFixedStepSubsystem>()->IsEnabled());
+    if (IsStepped && Test.TestNotNull(TEXT("Enemy"), Enemy))
+    {
+        const float FrameSeconds = StepsPerFrame / FixedStepTestRate;
+        for (int Step = 0; Step < FixedStepTestSteps; Step += StepsPerFrame)
+        {
+            ApplyScriptedInput(Player, Step);
+            World->Tick(LEVELTICK_All, FrameSeconds);
+        }
+
+        OutResult.PlayerLocation = Player->GetActorLocation();
+        OutResult.PlayerHitPoints = Player->HitPoints;
+        OutResult.EnemyLocation = Enemy->GetActorLocation();
+        OutResult.EnemyHitPoints = Enemy->HitPoints;
+    }
+
+    GEngine->DestroyWorldContext(World);
+    World->DestroyWorld(false);
+    return IsStepped && Enemy != nullptr;
+}
+
+bool FFixedStepStepsPerFrameTest::RunTest(const FString& Parameters)
+{
+    bool WasEnabled;
+    float PreviousRate;
+    int PreviousStepsPerFrame;
+    UFixedStepSubsystem::GetSettings(WasEnabled, PreviousRate, PreviousStepsPerFrame);
+
+    FFixedStepTestResult OneStep;
+    FFixedStepTestResult FourSteps;
+    if (RunScript(*this, 1, OneStep) && RunScript(*this, 4, FourSteps))
+    {
+        TestTrue(TEXT("The player moved"), !OneStep.PlayerLocation.Equals(FVector(0.0f, 0.0f, 100.0f), 10.0f));
+
+        TestTrue(FString::Printf(TEXT("Player location %s with 1 step per frame, %s with 4"), *OneStep.PlayerLocation.ToString(), *FourSteps.PlayerLocation.ToString()),
+                 OneStep.PlayerLocation.Equals(FourSteps.PlayerLocation, 0.01f));
+        TestEqual(TEXT("Player HP"), FourSteps.PlayerHitPoints, OneStep.PlayerHitPoints);
+        TestTrue(FString::Printf(TEXT("Enemy location %s with 1 step per frame, %s with 4"), *OneStep.EnemyLocation.ToString(), *FourSteps.EnemyLocation.ToString()),
+                 OneStep.EnemyLocation.Equals(FourSteps.EnemyLocation, 0.01f));
+        TestEqual(TEXT("Enemy HP"), FourSteps.EnemyHitPoints, OneStep.EnemyHitPoints);
+    }
+
+    UFixedStepSubsystem::SetSettings(WasEnabled, PreviousRate, PreviousStepsPerFrame);
+    return true;
+}
+
+#endif
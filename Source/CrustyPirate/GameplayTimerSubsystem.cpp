@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayTimerSubsystem.h"
+
+#include "FixedStepSubsystem.h"
+
+void UGameplayTimerSubsystem::SetTimer(FGameplayTimerHandle& InOutHandle, FSimpleDelegate Callback, float DelayInSeconds)
+{
+    TimerWheel.SetTimer(InOutHandle, MoveTemp(Callback), DelayInSeconds);
+}
+
+void UGameplayTimerSubsystem::ClearTimer(FGameplayTimerHandle& InOutHandle)
+{
+    TimerWheel.ClearTimer(InOutHandle);
+}
+
+bool UGameplayTimerSubsystem::IsTimerActive(const FGameplayTimerHandle& Handle) const
+{
+    return TimerWheel.IsTimerActive(Handle);
+}
+
+float UGameplayTimerSubsystem::GetTimerRemaining(const FGameplayTimerHandle& Handle) const
+{
+    return TimerWheel.GetTimerRemaining(Handle);
+}
+
+void UGameplayTimerSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    // The fixed step subsystem advances the timers in its steps
+    const UFixedStepSubsystem* FixedStep = GetWorld()->GetSubsystem<UFixedStepSubsystem>();
+    if (FixedStep && FixedStep->IsEnabled()) return;
+
+    AdvanceTime(DeltaTime);
+}
+
+void UGameplayTimerSubsystem::AdvanceTime(float DeltaTime)
+{
+    TimerWheel.Advance(DeltaTime);
+}
+
+TStatId UGameplayTimerSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UGameplayTimerSubsystem, STATGROUP_Tickables);
+}
+
+bool UGameplayTimerSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "GameplayTimerWheel.h"
+
+#include "GameplayTimerSubsystem.generated.h"
+
+/**
+ * Gameplay timers (stun, attack cool down, restart, level exit...) backed by a hierarchical timing wheel.
+ * Works like FTimerManager, except that setting an active handle again moves the timer in place and
+ * all the timers that expire during a frame are fired together when the subsystem ticks.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UGameplayTimerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    void SetTimer(FGameplayTimerHandle& InOutHandle, FSimpleDelegate Callback, float DelayInSeconds);
+
+    template<class UserClass>
+    void SetTimer(FGameplayTimerHandle& InOutHandle, UserClass* Object, typename TMemFunPtrType<false, UserClass, void()>::Type Method, float DelayInSeconds)
+    {
+        SetTimer(InOutHandle, FSimpleDelegate::CreateUObject(Object, Method), DelayInSeconds);
+    }
+
+    void ClearTimer(FGameplayTimerHandle& InOutHandle);
+
+    bool IsTimerActive(const FGameplayTimerHandle& Handle) const;
+
+    // Time left before the timer fires (-1 when the timer is not active)
+    float GetTimerRemaining(const FGameplayTimerHandle& Handle) const;
+
+    int GetNumActiveTimers() const { return TimerWheel.GetNumActiveTimers(); }
+
+    // Advance the time of the timers (by the frame time, or by every step of UFixedStepSubsystem)
+    void AdvanceTime(float DeltaTime);
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+    FGameplayTimerWheel TimerWheel;
+};
@@ -0,0 +1,243 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayTimerWheel.h"
+
+FGameplayTimerWheel::FGameplayTimerWheel(float InTickSeconds)
+    : TickSeconds(FMath::Max(InTickSeconds, KINDA_SMALL_NUMBER))
+{
+    for (int32& Head : SlotHeads)
+    {
+        Head = INDEX_NONE;
+    }
+}
+
+void FGameplayTimerWheel::SetTimer(FGameplayTimerHandle& InOutHandle, FSimpleDelegate&& Callback, float DelayInSeconds)
+{
+    int32 Index;
+    if (FindNode(InOutHandle))
+    {
+        // Reschedule in place
+        Index = InOutHandle.Index;
+        Unlink(Index);
+    }
+    else
+    {
+        Index = AllocateNode();
+        InOutHandle.Index = Index;
+        InOutHandle.Serial = Nodes[Index].Serial;
+    }
+
+    FTimerNode& Node = Nodes[Index];
+    Node.Callback = MoveTemp(Callback);
+
+    // Fire on the first tick at or after the delay
+    const double ExpireSeconds = ElapsedSeconds + FMath::Max(DelayInSeconds, 0.0f);
+    Node.ExpireTick = FMath::Max((uint64)FMath::CeilToDouble(ExpireSeconds / TickSeconds), BaseTick);
+
+    Link(Index);
+}
+
+void FGameplayTimerWheel::ClearTimer(FGameplayTimerHandle& InOutHandle)
+{
+    if (FindNode(InOutHandle))
+    {
+        Unlink(InOutHandle.Index);
+        FreeNode(InOutHandle.Index);
+    }
+
+    InOutHandle.Invalidate();
+}
+
+bool FGameplayTimerWheel::IsTimerActive(const FGameplayTimerHandle& Handle) const
+{
+    return FindNode(Handle) != nullptr;
+}
+
+float FGameplayTimerWheel::GetTimerRemaining(const FGameplayTimerHandle& Handle) const
+{
+    const FTimerNode* Node = FindNode(Handle);
+    if (!Node) return -1.0f;
+
+    return FMath::Max((float)((double)Node->ExpireTick * TickSeconds - ElapsedSeconds), 0.0f);
+}
+
+void FGameplayTimerWheel::Advance(float DeltaTime)
+{
+    ElapsedSeconds += FMath::Max(DeltaTime, 0.0f);
+    const uint64 TargetTick = (uint64)FMath::FloorToDouble(ElapsedSeconds / TickSeconds);
+
+    // Collect every timer that expires up to the target tick
+    while (ElapsedTicks < TargetTick)
+    {
+        ProcessTick(ElapsedTicks + 1);
+        ElapsedTicks++;
+        BaseTick = ElapsedTicks + 1;
+    }
+
+    // Then fire them all in one go. Callbacks can set or clear timers (including the ones still waiting to fire)
+    for (int32 ExpiredIndex = 0; ExpiredIndex < ExpiredTimers.Num(); ExpiredIndex++)
+    {
+        const int32 Index = ExpiredTimers[ExpiredIndex].Key;
+        FTimerNode& Node = Nodes[Index];
+        // Skip timers that were cleared or rescheduled (linked back into a slot) by an earlier callback
+        if (!Node.Active || Node.Serial != ExpiredTimers[ExpiredIndex].Value || Node.Slot != INDEX_NONE) continue;
+
+        // Free the node before firing so the callback can restart the timer with the same handle
+        FSimpleDelegate Callback = MoveTemp(Node.Callback);
+        FreeNode(Index);
+        Callback.ExecuteIfBound();
+    }
+    ExpiredTimers.Reset();
+}
+
+const FGameplayTimerWheel::FTimerNode* FGameplayTimerWheel::FindNode(const FGameplayTimerHandle& Handle) const
+{
+    if (!Nodes.IsValidIndex(Handle.Index)) return nullptr;
+
+    const FTimerNode& Node = Nodes[Handle.Index];
+    return Node.Active && Node.Serial == Handle.Serial ? &Node : nullptr;
+}
+
+int32 FGameplayTimerWheel::AllocateNode()
+{
+    int32 Index = FreeHead;
+    if (Index != INDEX_NONE)
+    {
+        FreeHead = Nodes[Index].Next;
+    }
+    else
+    {
+        Index = Nodes.AddDefaulted();
+    }
+
+    FTimerNode& Node = Nodes[Index];
+    Node.Active = true;
+    Node.Prev = INDEX_NONE;
+    Node.Next = INDEX_NONE;
+    Node.Slot = INDEX_NONE;
+    NumActiveTimers++;
+    return Index;
+}
+
+void FGameplayTimerWheel::FreeNode(int32 Index)
+{
+    FTimerNode& Node = Nodes[Index];
+    if (!Node.Active) return;
+
+    // Changing the serial invalidates every handle to this node
+    Node.Active = false;
+    Node.Serial++;
+    Node.Callback.Unbind();
+    Node.Slot = INDEX_NONE;
+    Node.Prev = INDEX_NONE;
+    Node.Next = FreeHead;
+    FreeHead = Index;
+    NumActiveTimers--;
+}
+
+void FGameplayTimerWheel::Link(int32 Index)
+{
+    FTimerNode& Node = Nodes[Index];
+
+    const uint64 Delay = Node.ExpireTick - BaseTick;
+
+    int32 Slot;
+    if (Delay < Wheel0Size)
+    {
+        Slot = (int32)(Node.ExpireTick & (Wheel0Size - 1));
+    }
+    else
+    {
+        // Timers further away than the last wheel can hold wait in its last slot and get cascaded again
+        const uint64 WheelTick = Delay < MaxDelayTicks ? Node.ExpireTick : BaseTick + MaxDelayTicks - 1;
+
+        int32 Wheel = 1;
+        while (Wheel < NumWheels - 1 && Delay >= (1ull << (Wheel0Bits + Wheel * WheelNBits)))
+        {
+            Wheel++;
+        }
+
+        const int32 Shift = Wheel0Bits + (Wheel - 1) * WheelNBits;
+        Slot = Wheel0Size + (Wheel - 1) * WheelNSize + (int32)((WheelTick >> Shift) & (WheelNSize - 1));
+    }
+
+    Node.Slot = Slot;
+    Node.Prev = INDEX_NONE;
+    Node.Next = SlotHeads[Slot];
+    if (Node.Next != INDEX_NONE)
+    {
+        Nodes[Node.Next].Prev = Index;
+    }
+    SlotHeads[Slot] = Index;
+}
+
+void FGameplayTimerWheel::Unlink(int32 Index)
+{
+    FTimerNode& Node = Nodes[Index];
+    if (Node.Slot == INDEX_NONE) return;
+
+    if (Node.Prev != INDEX_NONE)
+    {
+        Nodes[Node.Prev].Next = Node.Next;
+    }
+    else
+    {
+        SlotHeads[Node.Slot] = Node.Next;
+    }
+
+    if (Node.Next != INDEX_NONE)
+    {
+        Nodes[Node.Next].Prev = Node.Prev;
+    }
+
+    Node.Slot = INDEX_NONE;
+    Node.Prev = INDEX_NONE;
+    Node.Next = INDEX_NONE;
+}
+
+void FGameplayTimerWheel::Cascade(int32 Wheel, int32 SlotInWheel)
+{
+    const int32 Slot = Wheel0Size + (Wheel - 1) * WheelNSize + SlotInWheel;
+
+    int32 Index = SlotHeads[Slot];
+    SlotHeads[Slot] = INDEX_NONE;
+
+    while (Index != INDEX_NONE)
+    {
+        const int32 Next = Nodes[Index].Next;
+        Nodes[Index].Slot = INDEX_NONE;
+        Link(Index);
+        Index = Next;
+    }
+}
+
+void FGameplayTimerWheel::ProcessTick(uint64 Tick)
+{
+    BaseTick = Tick;
+
+    // Each time a wheel wraps around, bring the timers of the next slot of the coarser wheel down
+    for (int32 Wheel = 1; Wheel < NumWheels; Wheel++)
+    {
+        const int32 Shift = Wheel0Bits + (Wheel - 1) * WheelNBits;
+        if ((Tick & ((1ull << Shift) - 1)) != 0) break;
+
+        Cascade(Wheel, (int32)((Tick >> Shift) & (WheelNSize - 1)));
+    }
+
+    // Every timer in the slot of this tick expires now
+    const int32 Slot = (int32)(Tick & (Wheel0Size - 1));
+    int32 Index = SlotHeads[Slot];
+    SlotHeads[Slot] = INDEX_NONE;
+
+    while (Index != INDEX_NONE)
+    {
+        FTimerNode& Node = Nodes[Index];
+        const int32 Next = Node.Next;
+        Node.Slot = INDEX_NONE;
+        Node.Prev = INDEX_NONE;
+        Node.Next = INDEX_NONE;
+        ExpiredTimers.Add(TPair<int32, uint32>(Index, Node.Serial));
+        Index = Next;
+    }
+}
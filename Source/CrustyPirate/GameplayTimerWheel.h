@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Identifies a timer of a FGameplayTimerWheel. Stays valid until the timer fires or is cleared */
+struct CRUSTYPIRATE_API FGameplayTimerHandle
+{
+    int32 Index = INDEX_NONE;
+    uint32 Serial = 0;
+
+    bool IsValid() const { return Index != INDEX_NONE; }
+    void Invalidate() { Index = INDEX_NONE; Serial = 0; }
+};
+
+/**
+ * Hierarchical timing wheel (in the style of the Linux kernel timers).
+ * Time is counted in fixed ticks. Timers expiring in the next 256 ticks sit in the slot of their expiry tick,
+ * later ones sit in one of three coarser wheels of 64 slots and are moved down a wheel whenever the finer
+ * wheel wraps around. Scheduling, rescheduling and cancelling are O(1) and never allocate once the node
+ * pool is warm. Expired timers are collected while advancing and their callbacks are fired in one batch.
+ */
+class CRUSTYPIRATE_API FGameplayTimerWheel
+{
+public:
+    explicit FGameplayTimerWheel(float InTickSeconds = 0.001f);
+
+    // Start the timer of the handle. If the handle is still active the timer is moved in place instead
+    void SetTimer(FGameplayTimerHandle& InOutHandle, FSimpleDelegate&& Callback, float DelayInSeconds);
+
+    void ClearTimer(FGameplayTimerHandle& InOutHandle);
+
+    bool IsTimerActive(const FGameplayTimerHandle& Handle) const;
+
+    // Time left before the timer fires (-1 when the timer is not active)
+    float GetTimerRemaining(const FGameplayTimerHandle& Handle) const;
+
+    int GetNumActiveTimers() const { return NumActiveTimers; }
+
+    // Advance the time and fire the callbacks of every timer that expired, in expiry order
+    void Advance(float DeltaTime);
+
+private:
+    static constexpr int32 Wheel0Bits = 8;
+    static constexpr int32 WheelNBits = 6;
+    static constexpr int32 NumWheels = 4;
+    static constexpr int32 Wheel0Size = 1 << Wheel0Bits;
+    static constexpr int32 WheelNSize = 1 << WheelNBits;
+    static constexpr int32 NumSlots = Wheel0Size + (NumWheels - 1) * WheelNSize;
+    static constexpr uint64 MaxDelayTicks = 1ull << (Wheel0Bits + (NumWheels - 1) * WheelNBits);
+
+    struct FTimerNode
+    {
+        uint64 ExpireTick = 0;
+        int32 Prev = INDEX_NONE;
+        int32 Next = INDEX_NONE;
+        int32 Slot = INDEX_NONE;
+        uint32 Serial = 0;
+        bool Active = false;
+        FSimpleDelegate Callback;
+    };
+
+    const FTimerNode* FindNode(const FGameplayTimerHandle& Handle) const;
+
+    int32 AllocateNode();
+    void FreeNode(int32 Index);
+
+    void Link(int32 Index);
+    void Unlink(int32 Index);
+
+    // Move every timer of a slot of a coarse wheel down to the finer wheels
+    void Cascade(int32 Wheel, int32 SlotInWheel);
+
+    void ProcessTick(uint64 Tick);
+
+    float TickSeconds;
+
+    // Total time the wheel was advanced by
+    double ElapsedSeconds = 0.0;
+
+    // The last tick that was processed. Timers are inserted relative to BaseTick (the tick being processed next)
+    uint64 ElapsedTicks = 0;
+    uint64 BaseTick = 1;
+
+    int32 SlotHeads[NumSlots];
+
+    TArray<FTimerNode> Nodes;
+    int32 FreeHead = INDEX_NONE;
+    int NumActiveTimers = 0;
+
+    // Timers that expired during the current Advance (node index and serial)
+    TArray<TPair<int32, uint32>> ExpiredTimers;
+};
@@ -0,0 +1,17 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HealthBarRenderer.h"
+
+AHealthBarRenderer::AHealthBarRenderer()
+{
+	PrimaryActorTick.bCanEverTick = false;
+    
+    HealthBars = CreateDefaultSubobject<UPaperGroupedSpriteComponent>(TEXT("HealthBars"));
+    SetRootComponent(HealthBars);
+    
+    // The bars are only drawn
+    HealthBars->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    HealthBars->SetGenerateOverlapEvents(false);
+    HealthBars->SetCastShadow(false);
+}
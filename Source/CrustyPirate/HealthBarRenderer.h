@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+
+#include "PaperGroupedSpriteComponent.h"
+
+#include "HealthBarRenderer.generated.h"
+
+/**
+ * Draws the health bars of all the enemies with a single grouped sprite component (spawned by UHealthBarSubsystem)
+ */
+UCLASS(NotPlaceable)
+class CRUSTYPIRATE_API AHealthBarRenderer : public AActor
+{
+	GENERATED_BODY()
+	
+public:
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    UPaperGroupedSpriteComponent* HealthBars;
+    
+	AHealthBarRenderer();
+};
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HealthBarSubsystem.h"
+
+#include "PaperSprite.h"
+
+#include "CrustyPirate.h"
+#include "HealthBarRenderer.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Health Bar Rebuilds"), STAT_HealthBarRebuilds, STATGROUP_CrustyPirate);
+
+static TAutoConsoleVariable<float> CVarHealthBarMoveRebuildInterval(
+    TEXT("CrustyPirate.HealthBars.MoveRebuildInterval"),
+    0.05f,
+    TEXT("Shortest time (in seconds) between two rebuilds of the health bars caused only by moving enemies, 0 follows them every frame."));
+
+int UHealthBarSubsystem::AddBar(USceneComponent* Anchor, UPaperSprite* Sprite, float Fraction)
+{
+    if (!Anchor || !Sprite) return INDEX_NONE;
+
+    if (!Renderer)
+    {
+        LLM_SCOPE_BYTAG(CrustyPirate_HUD);
+
+        FActorSpawnParameters SpawnParameters;
+        SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+        Renderer = GetWorld()->SpawnActor<AHealthBarRenderer>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParameters);
+        if (!Renderer) return INDEX_NONE;
+    }
+
+    int BarIndex;
+    TArray<int>* FreeList = FreeBars.Find(Sprite);
+    if (FreeList && FreeList->Num() > 0)
+    {
+        BarIndex = FreeList->Pop(EAllowShrinking::No);
+    }
+    else
+    {
+        // The renderer sits at the origin, so the instances are placed in world space
+        BarIndex = Renderer->HealthBars->AddInstance(FTransform::Identity, Sprite, true);
+        Anchors.Add(nullptr);
+        Sprites.Add(Sprite);
+        HalfWidths.Add(Sprite->GetRenderBounds().BoxExtent.X);
+        Fractions.Add(0.0f);
+        AnchorLocations.Add(FVector::ZeroVector);
+        NeedsUpdate.Add(false);
+    }
+
+    Anchors[BarIndex] = Anchor;
+    Fractions[BarIndex] = FMath::Clamp(Fraction, 0.0f, 1.0f);
+    AnchorLocations[BarIndex] = Anchor->GetComponentLocation();
+    NeedsUpdate[BarIndex] = true;
+    HasChanges = true;
+    
+    return BarIndex;
+}
+
+void UHealthBarSubsystem::RemoveBar(int BarIndex)
+{
+    if (!Anchors.IsValidIndex(BarIndex) || !Anchors[BarIndex]) return;
+
+    Anchors[BarIndex] = nullptr;
+    FreeBars.FindOrAdd(Sprites[BarIndex]).Add(BarIndex);
+
+    // Hide the instance until it is reused
+    if (Renderer)
+    {
+        Renderer->HealthBars->UpdateInstanceTransform(BarIndex, FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector), true, false);
+        HasChanges = true;
+    }
+    NeedsUpdate[BarIndex] = false;
+}
+
+void UHealthBarSubsystem::SetBarFraction(int BarIndex, float Fraction)
+{
+    if (!Anchors.IsValidIndex(BarIndex)) return;
+
+    Fraction = FMath::Clamp(Fraction, 0.0f, 1.0f);
+    if (Fractions[BarIndex] != Fraction)
+    {
+        Fractions[BarIndex] = Fraction;
+        NeedsUpdate[BarIndex] = true;
+        HasChanges = true;
+    }
+}
+
+int UHealthBarSubsystem::GetNumFreeBars() const
+{
+    int Count = 0;
+    for (const TPair<TObjectPtr<UPaperSprite>, TArray<int>>& Pair : FreeBars)
+    {
+        Count += Pair.Value.Num();
+    }
+    return Count;
+}
+
+void UHealthBarSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    if (!Renderer) return;
+
+    // Moved bars wait for the interval, unless the batch is rebuilt anyway for a health change
+    TimeSinceRebuild += DeltaTime;
+    const bool CanMoveBars = HasChanges || TimeSinceRebuild >= CVarHealthBarMoveRebuildInterval.GetValueOnGameThread();
+
+    for (int BarIndex = 0; BarIndex < Anchors.Num(); BarIndex++)
+    {
+        const USceneComponent* Anchor = Anchors[BarIndex];
+        if (!Anchor) continue;
+
+        // Only the bars of the enemies that moved or got hit are touched
+        const FVector Location = Anchor->GetComponentLocation();
+        if (NeedsUpdate[BarIndex] || (CanMoveBars && !Location.Equals(AnchorLocations[BarIndex])))
+        {
+            AnchorLocations[BarIndex] = Location;
+            UpdateInstance(BarIndex);
+        }
+    }
+
+    if (HasChanges)
+    {
+        Renderer->HealthBars->MarkRenderStateDirty();
+        HasChanges = false;
+        TimeSinceRebuild = 0.0f;
+        INC_DWORD_STAT(STAT_HealthBarRebuilds);
+    }
+}
+
+void UHealthBarSubsystem::UpdateInstance(int BarIndex)
+{
+    const float Fraction = Fractions[BarIndex];
+
+    // Shrink the bar towards its left end
+    const FVector Location = AnchorLocations[BarIndex] - FVector((1.0f - Fraction) * HalfWidths[BarIndex], 0.0f, 0.0f);
+    const FTransform Transform(FQuat::Identity, Location, FVector(Fraction, 1.0f, 1.0f));
+    const FLinearColor Color = FLinearColor::LerpUsingHSV(FLinearColor::Red, FLinearColor::Green, Fraction);
+
+    Renderer->HealthBars->UpdateInstanceTransform(BarIndex, Transform, true, false);
+    Renderer->HealthBars->UpdateInstanceColor(BarIndex, Color, false);
+
+    NeedsUpdate[BarIndex] = false;
+    HasChanges = true;
+}
+
+TStatId UHealthBarSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UHealthBarSubsystem, STATGROUP_Tickables);
+}
+
+bool UHealthBarSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "HealthBarSubsystem.generated.h"
+
+class AHealthBarRenderer;
+class UPaperSprite;
+
+/**
+ * Health bars drawn as instances of one grouped sprite component (see AHealthBarRenderer) instead of a text
+ * render component per enemy. The health of a bar is a 0-1 fraction shown by the width and the colour of its
+ * instance. The grouped sprite component has no way to update one instance on the GPU, every change rebuilds the
+ * render state of the whole batch. A health change, an added or a removed bar is shown on the next frame, but bars
+ * whose anchor only moved follow it at most every "CrustyPirate.HealthBars.MoveRebuildInterval" seconds, so enemies
+ * walking around do not rebuild the batch every frame.
+ * Removed bars are hidden and their instance is reused by the next bar with the same sprite.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UHealthBarSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    // Add a bar following the anchor component (centered on it) and return its index
+    int AddBar(USceneComponent* Anchor, UPaperSprite* Sprite, float Fraction);
+    void RemoveBar(int BarIndex);
+
+    void SetBarFraction(int BarIndex, float Fraction);
+
+    int GetNumBars() const { return Anchors.Num() - GetNumFreeBars(); }
+    int GetNumFreeBars() const;
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+    // Write the transform and colour of the bar into its instance (without rebuilding the render state)
+    void UpdateInstance(int BarIndex);
+
+    UPROPERTY()
+    TObjectPtr<AHealthBarRenderer> Renderer;
+
+    // One entry per instance of the grouped sprite component. Every array below is indexed the same way
+    UPROPERTY()
+    TArray<TObjectPtr<USceneComponent>> Anchors;
+
+    UPROPERTY()
+    TArray<TObjectPtr<UPaperSprite>> Sprites;
+
+    TArray<float> HalfWidths;
+    TArray<float> Fractions;
+    TArray<FVector> AnchorLocations;
+    TArray<bool> NeedsUpdate;
+
+    // Unused instances for each sprite
+    TMap<TObjectPtr<UPaperSprite>, TArray<int>> FreeBars;
+
+    // Set when a health change, an added or a removed bar needs a rebuild on the next tick
+    bool HasChanges = false;
+
+    float TimeSinceRebuild = 0.0f;
+};
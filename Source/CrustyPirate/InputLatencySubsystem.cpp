@@ -0,0 +1,302 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InputLatencySubsystem.h"
+
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Misc/App.h"
+#include "PaperZDCharacter.h"
+#include "PaperZDAnimInstance.h"
+#include "PaperZDAnimPlayer.h"
+
+#include "CrustyPirate.h"
+
+static TAutoConsoleVariable<bool> CVarInputLatencyEnabled(
+    TEXT("CrustyPirate.InputLatency.Enabled"),
+    true,
+    TEXT("Measure the latency between the input actions of the player and their effect."));
+
+static TAutoConsoleVariable<int32> CVarInputLatencyTimeoutFrames(
+    TEXT("CrustyPirate.InputLatency.TimeoutFrames"),
+    30,
+    TEXT("Number of frames after which an input action without effect is counted as a timeout."));
+
+static TAutoConsoleVariable<int32> CVarInputLatencyBudgetFrames(
+    TEXT("CrustyPirate.InputLatency.BudgetFrames"),
+    2,
+    TEXT("Largest 95th percentile latency in frames allowed for every input action."));
+
+static FAutoConsoleCommandWithWorld InputLatencyStatsCommand(
+    TEXT("CrustyPirate.InputLatency.Stats"),
+    TEXT("Print the input latency histograms of the player actions."),
+    FConsoleCommandWithWorldDelegate::CreateStatic(&UInputLatencySubsystem::PrintStats));
+
+static FAutoConsoleCommandWithWorld InputLatencyResetCommand(
+    TEXT("CrustyPirate.InputLatency.Reset"),
+    TEXT("Clear the input latency histograms."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (UInputLatencySubsystem* InputLatency = World ? World->GetSubsystem<UInputLatencySubsystem>() : nullptr)
+        {
+            InputLatency->ResetHistograms();
+        }
+    }));
+
+// About a quarter of a 60 Hz frame up to 8 frames
+const double UInputLatencySubsystem::MicrosecondBucketEdges[] = { 4000.0, 8000.0, 16700.0, 33300.0, 50000.0, 66700.0, 100000.0, 133300.0 };
+const int UInputLatencySubsystem::NumMicrosecondBuckets = UE_ARRAY_COUNT(MicrosecondBucketEdges) + 1;
+
+// Velocity change along X that counts as the movement responding to a move input
+static const float MoveResponseVelocity = 1.0f;
+
+const TCHAR* UInputLatencySubsystem::GetActionName(EInputLatencyAction Action)
+{
+    switch (Action)
+    {
+    case EInputLatencyAction::Move: return TEXT("Move");
+    case EInputLatencyAction::Jump: return TEXT("Jump");
+    case EInputLatencyAction::Attack: return TEXT("Attack");
+    default: return TEXT("?");
+    }
+}
+
+void UInputLatencySubsystem::FHistogram::Add(int Frames, double Microseconds)
+{
+    FrameBuckets[FMath::Min(Frames, NumFrameBuckets - 1)]++;
+
+    int Bucket = 0;
+    while (Bucket < NumMicrosecondBuckets - 1 && Microseconds > MicrosecondBucketEdges[Bucket])
+    {
+        Bucket++;
+    }
+    MicrosecondBuckets[Bucket]++;
+
+    NumSamples++;
+    TotalMicroseconds += Microseconds;
+    MaxMicroseconds = FMath::Max(MaxMicroseconds, Microseconds);
+}
+
+int UInputLatencySubsystem::FHistogram::GetFramesPercentile(float Fraction) const
+{
+    const int Target = FMath::CeilToInt(Fraction * NumSamples);
+    int Count = 0;
+    for (int Frames = 0; Frames < FrameBuckets.Num(); Frames++)
+    {
+        Count += FrameBuckets[Frames];
+        if (Count >= Target) return Frames;
+    }
+    return NumFrameBuckets - 1;
+}
+
+double UInputLatencySubsystem::FHistogram::GetMicrosecondsPercentile(float Fraction) const
+{
+    const int Target = FMath::CeilToInt(Fraction * NumSamples);
+    int Count = 0;
+    for (int Bucket = 0; Bucket < MicrosecondBuckets.Num() - 1; Bucket++)
+    {
+        Count += MicrosecondBuckets[Bucket];
+        if (Count >= Target) return MicrosecondBucketEdges[Bucket];
+    }
+    return MaxMicroseconds;
+}
+
+void UInputLatencySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    ResetHistograms();
+}
+
+void UInputLatencySubsystem::ResetHistograms()
+{
+    for (FHistogram& Histogram : Histograms)
+    {
+        Histogram = FHistogram();
+        Histogram.FrameBuckets.Init(0, NumFrameBuckets);
+        Histogram.MicrosecondBuckets.Init(0, NumMicrosecondBuckets);
+    }
+}
+
+void UInputLatencySubsystem::InputReceived(ACharacter* Character, EInputLatencyAction Action, float Direction)
+{
+    if (!Character || !CVarInputLatencyEnabled.GetValueOnGameThread()) return;
+
+    if (TrackedCharacter.Get() != Character)
+    {
+        TrackedCharacter = Character;
+        for (FPendingAction& Pending : PendingActions)
+        {
+            Pending.IsPending = false;
+        }
+    }
+
+    if (Action == EInputLatencyAction::Move)
+    {
+        // The move action triggers every frame while it is held, only a press or a change of direction is timed
+        const bool IsPress = FrameNumber > LastMoveFrame + 1 || FMath::Sign(Direction) != FMath::Sign(LastMoveDirection);
+        LastMoveFrame = FrameNumber;
+        LastMoveDirection = Direction;
+        if (!IsPress || Direction == 0.0f) return;
+    }
+
+    // Keep timing the first input until it has an effect
+    FPendingAction& Pending = PendingActions[(int)Action];
+    if (Pending.IsPending) return;
+
+    Pending.IsPending = true;
+    Pending.InputFrame = FrameNumber;
+    // The input was pumped at the start of the frame
+    Pending.InputTime = FApp::GetCurrentTime();
+    Pending.Direction = Direction;
+    Pending.StartVelocityX = Character->GetCharacterMovement() ? Character->GetCharacterMovement()->Velocity.X : 0.0f;
+    Pending.EffectSequence = nullptr;
+
+    // Already running as fast as possible that way, the input cannot change anything
+    if (Action == EInputLatencyAction::Move && Character->GetCharacterMovement())
+    {
+        const float MaxSpeed = Character->GetCharacterMovement()->GetMaxSpeed();
+        if (Pending.StartVelocityX * FMath::Sign(Direction) >= MaxSpeed - MoveResponseVelocity)
+        {
+            Pending.IsPending = false;
+        }
+    }
+}
+
+void UInputLatencySubsystem::EffectApplied(ACharacter* Character, EInputLatencyAction Action)
+{
+    if (!Character || TrackedCharacter.Get() != Character) return;
+    if (!PendingActions[(int)Action].IsPending) return;
+
+    Complete(Action);
+}
+
+void UInputLatencySubsystem::WaitForAnimation(ACharacter* Character, EInputLatencyAction Action, const UPaperZDAnimSequence* Sequence)
+{
+    if (!Character || TrackedCharacter.Get() != Character) return;
+
+    FPendingAction& Pending = PendingActions[(int)Action];
+    if (Pending.IsPending)
+    {
+        Pending.EffectSequence = Sequence;
+    }
+}
+
+void UInputLatencySubsystem::Complete(EInputLatencyAction Action)
+{
+    FPendingAction& Pending = PendingActions[(int)Action];
+    Pending.IsPending = false;
+
+    const int Frames = (int)(FrameNumber - Pending.InputFrame);
+    const double Microseconds = FMath::Max(FPlatformTime::Seconds() - Pending.InputTime, 0.0) * 1000000.0;
+    Histograms[(int)Action].Add(Frames, Microseconds);
+}
+
+void UInputLatencySubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    ACharacter* Character = TrackedCharacter.Get();
+    if (!Character) return;
+
+    // Tickables run after all the tick groups, so the movement component already moved the character this frame
+    FPendingAction& PendingMove = PendingActions[(int)EInputLatencyAction::Move];
+    const UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+    if (PendingMove.IsPending && Movement)
+    {
+        const float VelocityChange = (Movement->Velocity.X - PendingMove.StartVelocityX) * FMath::Sign(PendingMove.Direction);
+        if (VelocityChange >= MoveResponseVelocity)
+        {
+            Complete(EInputLatencyAction::Move);
+        }
+    }
+
+    // The animation component ticked too, its animation player shows what is on screen this frame
+    APaperZDCharacter* PaperCharacter = Cast<APaperZDCharacter>(Character);
+    UPaperZDAnimInstance* AnimInstance = PaperCharacter ? PaperCharacter->GetAnimInstance() : nullptr;
+    UPaperZDAnimPlayer* AnimPlayer = AnimInstance ? AnimInstance->GetPlayer() : nullptr;
+    for (int Action = 0; Action < (int)EInputLatencyAction::Count; Action++)
+    {
+        const FPendingAction& Pending = PendingActions[Action];
+        if (Pending.IsPending && Pending.EffectSequence.IsValid() && AnimPlayer && AnimPlayer->GetCurrentAnimSequence() == Pending.EffectSequence.Get())
+        {
+            Complete((EInputLatencyAction)Action);
+        }
+    }
+
+    const uint64 TimeoutFrames = (uint64)FMath::Max(CVarInputLatencyTimeoutFrames.GetValueOnGameThread(), 1);
+    for (int Action = 0; Action < (int)EInputLatencyAction::Count; Action++)
+    {
+        FPendingAction& Pending = PendingActions[Action];
+        if (Pending.IsPending && FrameNumber - Pending.InputFrame >= TimeoutFrames)
+        {
+            Pending.IsPending = false;
+            Histograms[Action].NumTimeouts++;
+        }
+    }
+
+    FrameNumber++;
+}
+
+int UInputLatencySubsystem::GetBudgetFrames()
+{
+    return CVarInputLatencyBudgetFrames.GetValueOnGameThread();
+}
+
+void UInputLatencySubsystem::PrintStats(UWorld* World)
+{
+    const UInputLatencySubsystem* InputLatency = World ? World->GetSubsystem<UInputLatencySubsystem>() : nullptr;
+    if (!InputLatency) return;
+
+    for (int Action = 0; Action < (int)EInputLatencyAction::Count; Action++)
+    {
+        const FHistogram& Histogram = InputLatency->Histograms[Action];
+        const TCHAR* ActionName = GetActionName((EInputLatencyAction)Action);
+
+        UE_LOG(LogCrustyPirate, Display, TEXT("Input latency of %s: %d samples, %d timeouts, mean %.0f us, p50 %d frames, p95 %d frames (%.0f us), max %.0f us"),
+               ActionName,
+               Histogram.NumSamples,
+               Histogram.NumTimeouts,
+               Histogram.GetMeanMicroseconds(),
+               Histogram.GetFramesPercentile(0.5f),
+               Histogram.GetFramesPercentile(0.95f),
+               Histogram.GetMicrosecondsPercentile(0.95f),
+               Histogram.MaxMicroseconds);
+
+        if (Histogram.NumSamples == 0) continue;
+
+        FString Frames;
+        for (int Bucket = 0; Bucket < NumFrameBuckets; Bucket++)
+        {
+            Frames += FString::Printf(Bucket < NumFrameBuckets - 1 ? TEXT(" %d:%d") : TEXT(" %d+:%d"), Bucket, Histogram.FrameBuckets[Bucket]);
+        }
+        UE_LOG(LogCrustyPirate, Display, TEXT("  frames%s"), *Frames);
+
+        FString Microseconds;
+        for (int Bucket = 0; Bucket < NumMicrosecondBuckets; Bucket++)
+        {
+            Microseconds += Bucket < NumMicrosecondBuckets - 1
+                ? FString::Printf(TEXT(" <=%.0f:%d"), MicrosecondBucketEdges[Bucket], Histogram.MicrosecondBuckets[Bucket])
+                : FString::Printf(TEXT(" >%.0f:%d"), MicrosecondBucketEdges[Bucket - 1], Histogram.MicrosecondBuckets[Bucket]);
+        }
+        UE_LOG(LogCrustyPirate, Display, TEXT("  us%s"), *Microseconds);
+
+        if (Histogram.GetFramesPercentile(0.95f) > GetBudgetFrames())
+        {
+            UE_LOG(LogCrustyPirate, Warning, TEXT("Input latency of %s is over budget: p95 %d frames, budget %d frames"),
+                   ActionName,
+                   Histogram.GetFramesPercentile(0.95f),
+                   GetBudgetFrames());
+        }
+    }
+}
+
+TStatId UInputLatencySubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UInputLatencySubsystem, STATGROUP_Tickables);
+}
+
+bool UInputLatencySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "InputLatencySubsystem.generated.h"
+
+class ACharacter;
+class UPaperZDAnimSequence;
+
+UENUM()
+enum class EInputLatencyAction : uint8
+{
+    // Pressing a direction (or turning around): the movement component speeds up the character that way
+    Move,
+    // The character leaves the ground (ACharacter::OnJumped)
+    Jump,
+    // The animation player of the character starts playing the attack animation override
+    Attack,
+    Count UMETA(Hidden)
+};
+
+/**
+ * Measures how long it takes for the input actions of the player to have an effect. InputReceived() stamps an
+ * action with the start of the frame (when the input was pumped) and EffectApplied() closes it. The effect of
+ * a move is found at the end of the frame, after the character movement components ran, by looking at the
+ * velocity of the character, and an action waiting for an animation (see WaitForAnimation) has its effect once the
+ * animation player of the character plays it. Actions that have no effect within TimeoutFrames are counted as timeouts.
+ * The latencies go into histograms in frames and microseconds per action. "CrustyPirate.InputLatency.Stats"
+ * prints them and warns when the 95th percentile is above BudgetFrames, the benchmark checks the same budget.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UInputLatencySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    struct FHistogram
+    {
+        // One bucket per frame count, the last one holds everything above
+        TArray<int> FrameBuckets;
+
+        // Buckets up to the edges in MicrosecondBucketEdges, the last one holds everything above
+        TArray<int> MicrosecondBuckets;
+
+        int NumSamples = 0;
+        int NumTimeouts = 0;
+        double TotalMicroseconds = 0.0;
+        double MaxMicroseconds = 0.0;
+
+        void Add(int Frames, double Microseconds);
+
+        // Smallest frame count that covers Fraction of the samples
+        int GetFramesPercentile(float Fraction) const;
+
+        // Upper edge of the bucket that covers Fraction of the samples
+        double GetMicrosecondsPercentile(float Fraction) const;
+
+        double GetMeanMicroseconds() const { return NumSamples > 0 ? TotalMicroseconds / NumSamples : 0.0; }
+    };
+
+    static const int NumFrameBuckets = 9;
+    static const double MicrosecondBucketEdges[];
+    static const int NumMicrosecondBuckets;
+
+    // Start timing an action of the character. Direction is the move value (ignored by the other actions)
+    void InputReceived(ACharacter* Character, EInputLatencyAction Action, float Direction = 0.0f);
+
+    // The pending action of the character had its effect
+    void EffectApplied(ACharacter* Character, EInputLatencyAction Action);
+
+    // The pending action of the character has its effect when its animation player plays Sequence (the character must be a APaperZDCharacter)
+    void WaitForAnimation(ACharacter* Character, EInputLatencyAction Action, const UPaperZDAnimSequence* Sequence);
+
+    static const TCHAR* GetActionName(EInputLatencyAction Action);
+
+    const FHistogram& GetHistogram(EInputLatencyAction Action) const { return Histograms[(int)Action]; }
+
+    // The 95th percentile in frames allowed by CrustyPirate.InputLatency.BudgetFrames
+    static int GetBudgetFrames();
+
+    void ResetHistograms();
+
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    static void PrintStats(UWorld* World);
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+    struct FPendingAction
+    {
+        bool IsPending = false;
+        uint64 InputFrame = 0;
+        double InputTime = 0.0;
+        float Direction = 0.0f;
+        float StartVelocityX = 0.0f;
+
+        // The animation that shows the effect of the action (null when the effect is reported with EffectApplied)
+        TWeakObjectPtr<const UPaperZDAnimSequence> EffectSequence;
+    };
+
+    void Complete(EInputLatencyAction Action);
+
+    TWeakObjectPtr<ACharacter> TrackedCharacter;
+
+    // Frames of the world, counted at the end of every tick so the latency only depends on the world being ticked
+    uint64 FrameNumber = 0;
+
+    FPendingAction PendingActions[(int)EInputLatencyAction::Count];
+    FHistogram Histograms[(int)EInputLatencyAction::Count];
+
+    // Frame and direction of the last move input, to only time presses and turns (the move action triggers every frame)
+    uint64 LastMoveFrame = 0;
+    float LastMoveDirection = 0.0f;
+};
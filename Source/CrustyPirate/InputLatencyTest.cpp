@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "InputActionValue.h"
+
+#include "InputLatencySubsystem.h"
+#include "PlayerCharacter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInputLatencyBudgetTest, "CrustyPirate.InputLatency.Budget",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+static const TCHAR* PlayerClassPath = TEXT("/Game/Blueprints/Characters/Blueprint_PlayerCharacter.Blueprint_PlayerCharacter_C");
+
+// One 60 Hz frame of the test world: the movement, animation and the subsystem all tick in it
+static void TickFrame(UWorld* World)
+{
+    World->Tick(LEVELTICK_All, 1.0f / 60.0f);
+}
+
+// Tick until the player stands on the floor (or give up after MaxFrames)
+static bool TickUntilGrounded(UWorld* World, APlayerCharacter* Player, int MaxFrames)
+{
+    for (int Frame = 0; Frame < MaxFrames; Frame++)
+    {
+        TickFrame(World);
+        if (Player->GetCharacterMovement()->IsMovingOnGround()) return true;
+    }
+    return false;
+}
+
+bool FInputLatencyBudgetTest::RunTest(const FString& Parameters)
+{
+    UClass* PlayerClass = LoadClass<APlayerCharacter>(nullptr, PlayerClassPath);
+    UStaticMesh* FloorMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+    if (!TestNotNull(TEXT("Player class"), PlayerClass) || !TestNotNull(TEXT("Floor mesh"), FloorMesh)) return false;
+
+    UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+    FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    WorldContext.SetCurrentWorld(World);
+
+    const FURL URL;
+    World->SetGameMode(URL);
+    World->InitializeActorsForPlay(URL);
+    World->BeginPlay();
+
+    // A floor of 100 m with its top at Z = 0
+    AStaticMeshActor* Floor = World->SpawnActor<AStaticMeshActor>(FVector(0.0f, 0.0f, -50.0f), FRotator::ZeroRotator);
+    Floor->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+    Floor->GetStaticMeshComponent()->SetStaticMesh(FloorMesh);
+    Floor->SetActorScale3D(FVector(100.0f, 100.0f, 1.0f));
+
+    // The real player, without the HUD and sounds that need a local player
+    APlayerCharacter* Player = World->SpawnActorDeferred<APlayerCharacter>(PlayerClass, FTransform(FVector(0.0f, 0.0f, 200.0f)));
+    Player->PlayerHUDClass = nullptr;
+    Player->ItemPickupSound = nullptr;
+    Player->FinishSpawning(FTransform(FVector(0.0f, 0.0f, 200.0f)));
+
+    APlayerController* Controller = World->SpawnActor<APlayerController>();
+    Controller->Possess(Player);
+
+    UInputLatencySubsystem* InputLatency = World->GetSubsystem<UInputLatencySubsystem>();
+    if (TestNotNull(TEXT("Input latency subsystem"), InputLatency) && TestTrue(TEXT("Player landed"), TickUntilGrounded(World, Player, 120)))
+    {
+        const int NumPresses = 20;
+        const int BudgetFrames = UInputLatencySubsystem::GetBudgetFrames();
+        InputLatency->ResetHistograms();
+
+        // Run one way then turn around, every turn is a timed press of the move action
+        for (int Press = 0; Press < NumPresses; Press++)
+        {
+            const float Direction = (Press % 2) == 0 ? 1.0f : -1.0f;
+            for (int Frame = 0; Frame < 15; Frame++)
+            {
+                Player->Move(FInputActionValue(Direction));
+                TickFrame(World);
+            }
+        }
+
+        const UInputLatencySubsystem::FHistogram& Move = InputLatency->GetHistogram(EInputLatencyAction::Move);
+        TestEqual(TEXT("Move samples"), Move.NumSamples, NumPresses);
+        TestEqual(TEXT("Move timeouts"), Move.NumTimeouts, 0);
+        TestTrue(FString::Printf(TEXT("Move p95 of %d frames within the budget of %d"), Move.GetFramesPercentile(0.95f), BudgetFrames),
+                 Move.GetFramesPercentile(0.95f) <= BudgetFrames);
+
+        // Let the player stop before jumping in place
+        for (int Frame = 0; Frame < 60; Frame++)
+        {
+            TickFrame(World);
+        }
+
+        for (int Press = 0; Press < NumPresses; Press++)
+        {
+            Player->JumpStarted(FInputActionValue(true));
+            TickFrame(World);
+            Player->JumpEnded(FInputActionValue(false));
+            TickUntilGrounded(World, Player, 180);
+        }
+
+        const UInputLatencySubsystem::FHistogram& Jump = InputLatency->GetHistogram(EInputLatencyAction::Jump);
+        TestEqual(TEXT("Jump samples"), Jump.NumSamples, NumPresses);
+        TestEqual(TEXT("Jump timeouts"), Jump.NumTimeouts, 0);
+        TestTrue(FString::Printf(TEXT("Jump p95 of %d frames within the budget of %d"), Jump.GetFramesPercentile(0.95f), BudgetFrames),
+                 Jump.GetFramesPercentile(0.95f) <= BudgetFrames);
+
+        // Every attack waits for the end of the previous one
+        const int NumAttacks = 5;
+        for (int Press = 0; Press < NumAttacks; Press++)
+        {
+            Player->Attack(FInputActionValue(true));
+            for (int Frame = 0; Frame < 120 && !Player->CanAttack; Frame++)
+            {
+                TickFrame(World);
+            }
+        }
+
+        const UInputLatencySubsystem::FHistogram& Attack = InputLatency->GetHistogram(EInputLatencyAction::Attack);
+        TestEqual(TEXT("Attack samples"), Attack.NumSamples, NumAttacks);
+        TestEqual(TEXT("Attack timeouts"), Attack.NumTimeouts, 0);
+        TestTrue(FString::Printf(TEXT("Attack p95 of %d frames within the budget of %d"), Attack.GetFramesPercentile(0.95f), BudgetFrames),
+                 Attack.GetFramesPercentile(0.95f) <= BudgetFrames);
+    }
+
+    GEngine->DestroyWorldContext(World);
+    World->DestroyWorld(false);
+    return true;
+}
+
+#endif
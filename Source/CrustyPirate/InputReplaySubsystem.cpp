@@ -0,0 +1,745 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InputReplaySubsystem.h"
+
+#include "EnhancedInputComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "InputActionValue.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#include "CrustyPirate.h"
+#include "CrustyPirateGameInstance.h"
+#include "FixedStepSubsystem.h"
+#include "PlayerCharacter.h"
+
+static FAutoConsoleCommandWithWorldAndArgs ReplayRecordCommand(
+    TEXT("CrustyPirate.Replay.Record"),
+    TEXT("Restart the current level and record the input of the player (optional argument: file path)."),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+    {
+        UInputReplaySubsystem* InputReplay = World && World->GetGameInstance() ? World->GetGameInstance()->GetSubsystem<UInputReplaySubsystem>() : nullptr;
+        if (InputReplay)
+        {
+            InputReplay->StartRecording(Args.Num() > 0 ? Args[0] : FString());
+        }
+    }));
+
+static FAutoConsoleCommandWithWorld ReplayStopCommand(
+    TEXT("CrustyPirate.Replay.Stop"),
+    TEXT("Stop recording the input and write the file."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        UInputReplaySubsystem* InputReplay = World && World->GetGameInstance() ? World->GetGameInstance()->GetSubsystem<UInputReplaySubsystem>() : nullptr;
+        if (InputReplay)
+        {
+            InputReplay->StopRecording();
+        }
+    }));
+
+static FAutoConsoleCommandWithWorldAndArgs ReplayPlayCommand(
+    TEXT("CrustyPirate.Replay.Play"),
+    TEXT("Play an input recording back (argument: file path)."),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+    {
+        UInputReplaySubsystem* InputReplay = World && World->GetGameInstance() ? World->GetGameInstance()->GetSubsystem<UInputReplaySubsystem>() : nullptr;
+        if (InputReplay && Args.Num() > 0)
+        {
+            InputReplay->StartPlayback(Args[0]);
+        }
+    }));
+
+static FAutoConsoleCommandWithWorld ReplayStatsCommand(
+    TEXT("CrustyPirate.Replay.Stats"),
+    TEXT("Print the state of the input recorder."),
+    FConsoleCommandWithWorldDelegate::CreateStatic(&UInputReplaySubsystem::PrintStats));
+
+// "CPIR"
+static const uint32 ReplayMagic = 0x52495043;
+static const uint16 ReplayVersion = 2;
+
+// The action is stored in the low bits of the event varint, the frame delta above them
+static const int ReplayActionBits = 3;
+
+// Longest frame time stored (a hitch while loading), keeps the change between two frames in an int32
+static const uint32 MaxFrameMicroseconds = 10000000;
+
+void UInputReplaySubsystem::WriteVarInt(TArray<uint8>& Data, uint32 Value)
+{
+    while (Value >= 0x80)
+    {
+        Data.Add((uint8)(Value | 0x80));
+        Value >>= 7;
+    }
+    Data.Add((uint8)Value);
+}
+
+bool UInputReplaySubsystem::ReadVarInt(const TArray<uint8>& Data, int& InOutOffset, uint32& OutValue)
+{
+    OutValue = 0;
+    for (int Shift = 0; Shift < 35 && InOutOffset < Data.Num(); Shift += 7)
+    {
+        const uint8 Byte = Data[InOutOffset++];
+        OutValue |= (uint32)(Byte & 0x7f) << Shift;
+        if ((Byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+static FString GetDefaultReplayPath()
+{
+    return FPaths::ProjectSavedDir() / TEXT("Replays/Input.replay");
+}
+
+static bool IsLevelLoaded(const UWorld* World, int LevelIndex)
+{
+    return World && UWorld::RemovePIEPrefix(World->GetMapName()) == FString::Printf(TEXT("Level_%d"), LevelIndex);
+}
+
+bool UInputReplaySubsystem::IsPlaybackRun()
+{
+    FString Path;
+    return FParse::Value(FCommandLine::Get(), TEXT("PlayInput="), Path);
+}
+
+void UInputReplaySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UInputReplaySubsystem::OnPostLoadMap);
+
+    // Both start with the first level loaded
+    const TCHAR* CommandLine = FCommandLine::Get();
+    FString Path;
+    if (FParse::Value(CommandLine, TEXT("PlayInput="), Path))
+    {
+        StartPlayback(Path);
+    }
+    else if (FParse::Param(CommandLine, TEXT("RecordInput")))
+    {
+        FParse::Value(CommandLine, TEXT("RecordInput="), Path);
+        FilePath = Path.IsEmpty() ? GetDefaultReplayPath() : Path;
+        Mode = EMode::RecordPending;
+    }
+}
+
+void UInputReplaySubsystem::Deinitialize()
+{
+    // A recording ends with the game (the Quit action included)
+    StopRecording();
+
+    // The engine outlives the game instance in the editor
+    if (Mode == EMode::PlayPending || Mode == EMode::Playing)
+    {
+        RestoreEngineSettings();
+        Mode = EMode::None;
+    }
+
+    FCoreUObjectDelegates::PostLoadMapWithWorld.RemoveAll(this);
+    FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+
+    Super::Deinitialize();
+}
+
+void UInputReplaySubsystem::StartRecording(const FString& Path)
+{
+    if (Mode == EMode::Recording)
+    {
+        StopRecording();
+    }
+
+    FilePath = Path.IsEmpty() ? GetDefaultReplayPath() : Path;
+    Mode = EMode::RecordPending;
+
+    // Record from the start of the level
+    if (UCrustyPirateGameInstance* GameInstance = Cast<UCrustyPirateGameInstance>(GetGameInstance()))
+    {
+        GameInstance->ChangeLevel(GameInstance->CurrentLevelIndex);
+    }
+}
+
+void UInputReplaySubsystem::StopRecording()
+{
+    if (Mode == EMode::RecordPending)
+    {
+        Mode = EMode::None;
+    }
+    if (Mode != EMode::Recording) return;
+
+    UnbindRecorder();
+    WriteRecording(FilePath, Recording);
+
+    Mode = EMode::None;
+    FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+    PreActorTickHandle.Reset();
+}
+
+bool UInputReplaySubsystem::StartPlayback(const FString& Path)
+{
+    if (Mode == EMode::Recording)
+    {
+        StopRecording();
+    }
+
+    FRecording NewRecording;
+    if (!ReadRecording(Path, NewRecording))
+    {
+        return false;
+    }
+
+    if (Mode != EMode::PlayPending && Mode != EMode::Playing)
+    {
+        PreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+        PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+        UFixedStepSubsystem::GetSettings(PreviousIsFixedStepEnabled, PreviousFixedStepRate, PreviousFixedStepsPerFrame);
+    }
+
+    // The levels begin play with the fixed step settings of the recording
+    UFixedStepSubsystem::SetSettings(NewRecording.IsFixedStepEnabled, NewRecording.FixedStepRate, NewRecording.FixedStepsPerFrame);
+
+    bool IsFixedStepEnabled = false;
+    float FixedStepRate = 0.0f;
+    int FixedStepsPerFrame = 0;
+    UFixedStepSubsystem::GetSettings(IsFixedStepEnabled, FixedStepRate, FixedStepsPerFrame);
+    if (IsFixedStepEnabled != NewRecording.IsFixedStepEnabled || FixedStepRate != NewRecording.FixedStepRate || FixedStepsPerFrame != NewRecording.FixedStepsPerFrame)
+    {
+        UE_LOG(LogCrustyPirate, Error, TEXT("Input replay: %s was recorded with other fixed step settings (CrustyPirate.FixedStep.*) and they cannot be changed"), *Path);
+        RestoreEngineSettings();
+        Mode = EMode::None;
+        return false;
+    }
+
+    Recording = MoveTemp(NewRecording);
+    FilePath = Path;
+    Mode = EMode::PlayPending;
+    IsStartStateApplied = false;
+
+    // From the console a level is already running, from the command line the startup map is loaded first
+    UWorld* World = GetGameInstance()->GetWorld();
+    if (World && World->HasBegunPlay())
+    {
+        ApplyStartState();
+    }
+    return true;
+}
+
+void UInputReplaySubsystem::ApplyStartState()
+{
+    UCrustyPirateGameInstance* GameInstance = Cast<UCrustyPirateGameInstance>(GetGameInstance());
+    if (!GameInstance) return;
+
+    IsStartStateApplied = true;
+    GameInstance->PlayerHP = Recording.PlayerHP;
+    GameInstance->CollectedDiamondCount = Recording.DiamondCount;
+    GameInstance->IsDoubleJumpUnlocked = Recording.IsDoubleJumpUnlocked;
+    GameInstance->CurrentLevelIndex = Recording.LevelIndex;
+
+    // The player reads the state of the game instance when the level begins play
+    GameInstance->ChangeLevel(Recording.LevelIndex);
+}
+
+void UInputReplaySubsystem::OnPostLoadMap(UWorld* LoadedWorld)
+{
+    UCrustyPirateGameInstance* GameInstance = Cast<UCrustyPirateGameInstance>(GetGameInstance());
+    if (!GameInstance || !LoadedWorld || LoadedWorld != GameInstance->GetWorld()) return;
+
+    if (Mode == EMode::RecordPending)
+    {
+        // The startup map is skipped when the game goes on from a saved level
+        if (!IsLevelLoaded(LoadedWorld, GameInstance->CurrentLevelIndex)) return;
+
+        Recording = FRecording();
+        Recording.LevelIndex = GameInstance->CurrentLevelIndex;
+        Recording.PlayerHP = GameInstance->PlayerHP;
+        Recording.DiamondCount = GameInstance->CollectedDiamondCount;
+        Recording.IsDoubleJumpUnlocked = GameInstance->IsDoubleJumpUnlocked;
+        UFixedStepSubsystem::GetSettings(Recording.IsFixedStepEnabled, Recording.FixedStepRate, Recording.FixedStepsPerFrame);
+
+        LastMoveValue = 0;
+        RecordedPlayer.Reset();
+        Mode = EMode::Recording;
+    }
+    else if (Mode == EMode::Recording)
+    {
+        // A level exit loaded the next level, playback lines up with it (the preload makes the number of frames vary)
+        RecordEvent(EReplayAction::LevelLoaded);
+        return;
+    }
+    else if (Mode == EMode::PlayPending)
+    {
+        if (!IsStartStateApplied)
+        {
+            ApplyStartState();
+            return;
+        }
+        if (!IsLevelLoaded(LoadedWorld, Recording.LevelIndex)) return;
+
+        NextEvent = 0;
+        HeldMoveValue = 0.0f;
+        IsWaitingForLevel = false;
+        NumWaitFrames = 0;
+        NumSkippedEvents = 0;
+        PlaybackStartTime = FPlatformTime::Seconds();
+        Mode = EMode::Playing;
+
+        // From now on every frame takes the time it took in the recording
+        FApp::SetUseFixedTimeStep(true);
+        SetNextFrameTime(0);
+    }
+    else if (Mode == EMode::Playing)
+    {
+        OnPlaybackLevelLoaded();
+        return;
+    }
+    else
+    {
+        return;
+    }
+
+    Frame = -1;
+    if (!PreActorTickHandle.IsValid())
+    {
+        PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(this, &UInputReplaySubsystem::OnWorldPreActorTick);
+    }
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Input replay: %s Level_%d (%s)"), Mode == EMode::Recording ? TEXT("recording") : TEXT("playing"), Recording.LevelIndex, *FilePath);
+}
+
+void UInputReplaySubsystem::OnWorldPreActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+    if (World != GetGameInstance()->GetWorld() || TickType == LEVELTICK_ViewportsOnly) return;
+
+    // The frames of the recording wait for the level the playback is still loading
+    if (Mode == EMode::Playing && IsWaitingForLevel)
+    {
+        NumWaitFrames++;
+        return;
+    }
+
+    Frame++;
+
+    // A new player comes with every level and every restart
+    APlayerCharacter* Player = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerCharacter(World, 0));
+
+    if (Mode == EMode::Recording)
+    {
+        // The engine time of the frame, before the world dilates or clamps it
+        const uint64 Microseconds = (uint64)FMath::RoundToDouble(FMath::Max(FApp::GetDeltaTime(), 0.0) * 1000000.0);
+        Recording.FrameMicroseconds.Add((uint32)FMath::Min<uint64>(Microseconds, MaxFrameMicroseconds));
+
+        if (Player != RecordedPlayer.Get())
+        {
+            BindRecorder(Player);
+        }
+    }
+    else if (Mode == EMode::Playing)
+    {
+        PlayFrame(Player);
+
+        if (Mode == EMode::Playing && !IsWaitingForLevel)
+        {
+            SetNextFrameTime(Frame + 1);
+        }
+    }
+}
+
+void UInputReplaySubsystem::BindRecorder(APlayerCharacter* Player)
+{
+    UnbindRecorder();
+
+    UEnhancedInputComponent* Input = Player ? Cast<UEnhancedInputComponent>(Player->InputComponent) : nullptr;
+    if (!Input) return;
+
+    RecordedPlayer = Player;
+    RecordedInputComponent = Input;
+
+    // The same triggers as the bindings of the player
+    BindingHandles.Add(Input->BindAction(Player->MoveAction, ETriggerEvent::Triggered, this, &UInputReplaySubsystem::OnMoveTriggered).GetHandle());
+    BindingHandles.Add(Input->BindAction(Player->MoveAction, ETriggerEvent::Completed, this, &UInputReplaySubsystem::OnMoveCompleted).GetHandle());
+    BindingHandles.Add(Input->BindAction(Player->JumpAction, ETriggerEvent::Started, this, &UInputReplaySubsystem::OnJumpStarted).GetHandle());
+    BindingHandles.Add(Input->BindAction(Player->JumpAction, ETriggerEvent::Completed, this, &UInputReplaySubsystem::OnJumpEnded).GetHandle());
+    BindingHandles.Add(Input->BindAction(Player->JumpAction, ETriggerEvent::Canceled, this, &UInputReplaySubsystem::OnJumpEnded).GetHandle());
+    BindingHandles.Add(Input->BindAction(Player->AttackAction, ETriggerEvent::Started, this, &UInputReplaySubsystem::OnAttack).GetHandle());
+    BindingHandles.Add(Input->BindAction(Player->QuitAction, ETriggerEvent::Started, this, &UInputReplaySubsystem::OnQuit).GetHandle());
+}
+
+void UInputReplaySubsystem::UnbindRecorder()
+{
+    if (UEnhancedInputComponent* Input = RecordedInputComponent.Get())
+    {
+        for (const uint32 Handle : BindingHandles)
+        {
+            Input->RemoveBindingByHandle(Handle);
+        }
+    }
+    BindingHandles.Reset();
+    RecordedInputComponent.Reset();
+    RecordedPlayer.Reset();
+}
+
+void UInputReplaySubsystem::OnMoveTriggered(const FInputActionValue& Value)
+{
+    RecordEvent(EReplayAction::Move, Value.Get<float>());
+}
+
+void UInputReplaySubsystem::OnMoveCompleted(const FInputActionValue& Value)
+{
+    RecordEvent(EReplayAction::Move, 0.0f);
+}
+
+void UInputReplaySubsystem::OnJumpStarted(const FInputActionValue& Value)
+{
+    RecordEvent(EReplayAction::JumpStarted);
+}
+
+void UInputReplaySubsystem::OnJumpEnded(const FInputActionValue& Value)
+{
+    RecordEvent(EReplayAction::JumpEnded);
+}
+
+void UInputReplaySubsystem::OnAttack(const FInputActionValue& Value)
+{
+    RecordEvent(EReplayAction::Attack);
+}
+
+void UInputReplaySubsystem::OnQuit(const FInputActionValue& Value)
+{
+    RecordEvent(EReplayAction::Quit);
+}
+
+void UInputReplaySubsystem::RecordEvent(EReplayAction Action, float Value)
+{
+    if (Mode != EMode::Recording || Frame < 0) return;
+
+    // The move action triggers every frame while it is held, only changes of its value are kept
+    if (Action == EReplayAction::Move)
+    {
+        const int8 MoveValue = (int8)FMath::Clamp(FMath::RoundToInt(Value * 127.0f), -127, 127);
+        if (MoveValue == LastMoveValue) return;
+        LastMoveValue = MoveValue;
+        Value = MoveValue / 127.0f;
+    }
+
+    Recording.Events.Add(FReplayEvent{ Frame, Action, Value });
+}
+
+void UInputReplaySubsystem::SetNextFrameTime(int NextFrame) const
+{
+    if (Recording.FrameMicroseconds.IsValidIndex(NextFrame))
+    {
+        FApp::SetFixedDeltaTime(Recording.FrameMicroseconds[NextFrame] / 1000000.0);
+    }
+}
+
+void UInputReplaySubsystem::PlayFrame(APlayerCharacter* Player)
+{
+    // Keys pressed during the playback must not add to the recorded input
+    if (Player != PlayedPlayer.Get())
+    {
+        PlayedPlayer = Player;
+        if (APlayerController* PlayerController = Player ? Cast<APlayerController>(Player->GetController()) : nullptr)
+        {
+            Player->DisableInput(PlayerController);
+        }
+    }
+
+    const TArray<FReplayEvent>& Events = Recording.Events;
+    while (NextEvent < Events.Num() && Events[NextEvent].Frame <= Frame)
+    {
+        const FReplayEvent& Event = Events[NextEvent];
+
+        // The recorded run loaded the next level after this frame, the events after it belong to that level
+        if (Event.Action == EReplayAction::LevelLoaded)
+        {
+            IsWaitingForLevel = true;
+            return;
+        }
+        NextEvent++;
+
+        if (Event.Action == EReplayAction::Move)
+        {
+            HeldMoveValue = Event.Value;
+            continue;
+        }
+        if (!Player) continue;
+
+        switch (Event.Action)
+        {
+        case EReplayAction::JumpStarted: Player->JumpStarted(FInputActionValue(true)); break;
+        case EReplayAction::JumpEnded: Player->JumpEnded(FInputActionValue(false)); break;
+        case EReplayAction::Attack: Player->Attack(FInputActionValue(true)); break;
+        case EReplayAction::Quit:
+            // The summary has to be in the log before the game quits (-PlayInputExit quits on its own)
+            FinishPlayback();
+            if (!FParse::Param(FCommandLine::Get(), TEXT("PlayInputExit")))
+            {
+                Player->QuitGame();
+            }
+            return;
+        default: break;
+        }
+    }
+
+    // The move action triggers every frame while it is held
+    if (Player && HeldMoveValue != 0.0f)
+    {
+        Player->Move(FInputActionValue(HeldMoveValue));
+    }
+
+    if (NextEvent >= Events.Num() && Frame + 1 >= Recording.FrameMicroseconds.Num())
+    {
+        FinishPlayback();
+    }
+}
+
+void UInputReplaySubsystem::OnPlaybackLevelLoaded()
+{
+    const TArray<FReplayEvent>& Events = Recording.Events;
+    int LoadEvent = NextEvent;
+    while (LoadEvent < Events.Num() && Events[LoadEvent].Action != EReplayAction::LevelLoaded)
+    {
+        LoadEvent++;
+    }
+    if (LoadEvent >= Events.Num())
+    {
+        UE_LOG(LogCrustyPirate, Warning, TEXT("Input replay: a level was loaded at frame %d that the recording %s did not load"), Frame, *FilePath);
+        return;
+    }
+
+    // Loaded sooner than in the recording, the input meant for the old level is dropped but the held move value is kept
+    for (int Index = NextEvent; Index < LoadEvent; Index++)
+    {
+        if (Events[Index].Action == EReplayAction::Move)
+        {
+            HeldMoveValue = Events[Index].Value;
+        }
+        else
+        {
+            NumSkippedEvents++;
+        }
+    }
+
+    NextEvent = LoadEvent + 1;
+    Frame = Events[LoadEvent].Frame;
+    IsWaitingForLevel = false;
+    SetNextFrameTime(Frame + 1);
+}
+
+void UInputReplaySubsystem::FinishPlayback()
+{
+    const int NumFrames = Recording.FrameMicroseconds.Num();
+    const double Seconds = FPlatformTime::Seconds() - PlaybackStartTime;
+    UE_LOG(LogCrustyPirate, Display, TEXT("Input replay: %s played in %.2f seconds, %d frames (%.2f ms per frame), %d frames waiting for a level, %d events skipped"),
+           *FilePath,
+           Seconds,
+           NumFrames,
+           NumFrames > 0 ? Seconds * 1000.0 / NumFrames : 0.0,
+           NumWaitFrames,
+           NumSkippedEvents);
+
+    Mode = EMode::None;
+    FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+    PreActorTickHandle.Reset();
+
+    RestoreEngineSettings();
+
+    APlayerCharacter* Player = PlayedPlayer.Get();
+    if (APlayerController* PlayerController = Player ? Cast<APlayerController>(Player->GetController()) : nullptr)
+    {
+        Player->EnableInput(PlayerController);
+    }
+    PlayedPlayer.Reset();
+
+    if (FParse::Param(FCommandLine::Get(), TEXT("PlayInputExit")))
+    {
+        FPlatformMisc::RequestExitWithStatus(false, 0);
+    }
+}
+
+void UInputReplaySubsystem::RestoreEngineSettings()
+{
+    FApp::SetUseFixedTimeStep(PreviousUseFixedTimeStep);
+    FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+    UFixedStepSubsystem::SetSettings(PreviousIsFixedStepEnabled, PreviousFixedStepRate, PreviousFixedStepsPerFrame);
+}
+
+void UInputReplaySubsystem::EncodeRecording(const FRecording& Recording, TArray<uint8>& OutData)
+{
+    OutData.Reset();
+    FMemoryWriter Writer(OutData);
+
+    uint32 Magic = ReplayMagic;
+    uint16 Version = ReplayVersion;
+    int32 LevelIndex = Recording.LevelIndex;
+    int32 PlayerHP = Recording.PlayerHP;
+    int32 DiamondCount = Recording.DiamondCount;
+    uint8 DoubleJump = Recording.IsDoubleJumpUnlocked ? 1 : 0;
+    uint8 FixedStepEnabled = Recording.IsFixedStepEnabled ? 1 : 0;
+    float FixedStepRate = Recording.FixedStepRate;
+    int32 FixedStepsPerFrame = Recording.FixedStepsPerFrame;
+    uint32 FrameCount = (uint32)Recording.FrameMicroseconds.Num();
+    uint32 EventCount = (uint32)Recording.Events.Num();
+    Writer << Magic << Version << LevelIndex << PlayerHP << DiamondCount << DoubleJump;
+    Writer << FixedStepEnabled << FixedStepRate << FixedStepsPerFrame << FrameCount << EventCount;
+
+    int LastEventFrame = 0;
+    for (const FReplayEvent& Event : Recording.Events)
+    {
+        WriteVarInt(OutData, ((uint32)(Event.Frame - LastEventFrame) << ReplayActionBits) | (uint32)Event.Action);
+        if (Event.Action == EReplayAction::Move)
+        {
+            OutData.Add((uint8)(int8)FMath::Clamp(FMath::RoundToInt(Event.Value * 127.0f), -127, 127));
+        }
+        LastEventFrame = Event.Frame;
+    }
+
+    // The frame time hardly changes from one frame to the next, its change is stored zigzag encoded
+    int32 LastMicroseconds = 0;
+    for (const uint32 FrameMicroseconds : Recording.FrameMicroseconds)
+    {
+        const int32 Microseconds = (int32)FMath::Min(FrameMicroseconds, MaxFrameMicroseconds);
+        const int32 Change = Microseconds - LastMicroseconds;
+        WriteVarInt(OutData, ((uint32)Change << 1) ^ (uint32)(Change >> 31));
+        LastMicroseconds = Microseconds;
+    }
+}
+
+bool UInputReplaySubsystem::DecodeRecording(const TArray<uint8>& Data, FRecording& OutRecording)
+{
+    FMemoryReader Reader(Data);
+
+    uint32 Magic = 0;
+    uint16 Version = 0;
+    int32 LevelIndex = 1;
+    int32 PlayerHP = 0;
+    int32 DiamondCount = 0;
+    uint8 DoubleJump = 0;
+    uint8 FixedStepEnabled = 0;
+    float FixedStepRate = 0.0f;
+    int32 FixedStepsPerFrame = 0;
+    uint32 FrameCount = 0;
+    uint32 EventCount = 0;
+    Reader << Magic << Version;
+    if (Reader.IsError() || Magic != ReplayMagic || Version != ReplayVersion) return false;
+
+    Reader << LevelIndex << PlayerHP << DiamondCount << DoubleJump;
+    Reader << FixedStepEnabled << FixedStepRate << FixedStepsPerFrame << FrameCount << EventCount;
+    if (Reader.IsError()) return false;
+
+    OutRecording = FRecording();
+    OutRecording.LevelIndex = LevelIndex;
+    OutRecording.PlayerHP = PlayerHP;
+    OutRecording.DiamondCount = DiamondCount;
+    OutRecording.IsDoubleJumpUnlocked = DoubleJump != 0;
+    OutRecording.IsFixedStepEnabled = FixedStepEnabled != 0;
+    OutRecording.FixedStepRate = FixedStepRate;
+    OutRecording.FixedStepsPerFrame = FixedStepsPerFrame;
+
+    // Every event and frame takes at least one byte
+    int Offset = (int)Reader.Tell();
+    if ((int64)EventCount + FrameCount > Data.Num() - Offset) return false;
+
+    OutRecording.Events.Reserve(EventCount);
+    int EventFrame = 0;
+    for (uint32 Index = 0; Index < EventCount; Index++)
+    {
+        uint32 Encoded = 0;
+        if (!ReadVarInt(Data, Offset, Encoded)) return false;
+
+        const uint32 ActionValue = Encoded & ((1 << ReplayActionBits) - 1);
+        if (ActionValue >= (uint32)EReplayAction::Count) return false;
+
+        EventFrame += (int)(Encoded >> ReplayActionBits);
+
+        FReplayEvent& Event = OutRecording.Events.AddDefaulted_GetRef();
+        Event.Frame = EventFrame;
+        Event.Action = (EReplayAction)ActionValue;
+        Event.Value = 0.0f;
+
+        if (Event.Action == EReplayAction::Move)
+        {
+            if (Offset >= Data.Num()) return false;
+            Event.Value = (int8)Data[Offset++] / 127.0f;
+        }
+    }
+
+    OutRecording.FrameMicroseconds.Reserve(FrameCount);
+    int32 Microseconds = 0;
+    for (uint32 Index = 0; Index < FrameCount; Index++)
+    {
+        uint32 Encoded = 0;
+        if (!ReadVarInt(Data, Offset, Encoded)) return false;
+
+        Microseconds += (int32)(Encoded >> 1) ^ -(int32)(Encoded & 1);
+        if (Microseconds < 0 || (uint32)Microseconds > MaxFrameMicroseconds) return false;
+        OutRecording.FrameMicroseconds.Add((uint32)Microseconds);
+    }
+
+    return true;
+}
+
+bool UInputReplaySubsystem::WriteRecording(const FString& Path, const FRecording& Recording)
+{
+    TArray<uint8> Data;
+    EncodeRecording(Recording, Data);
+
+    if (!FFileHelper::SaveArrayToFile(Data, *Path))
+    {
+        UE_LOG(LogCrustyPirate, Error, TEXT("Input replay: could not write %s"), *Path);
+        return false;
+    }
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Input replay: %d events over %d frames written to %s (%d bytes)"), Recording.Events.Num(), Recording.FrameMicroseconds.Num(), *Path, Data.Num());
+    return true;
+}
+
+bool UInputReplaySubsystem::ReadRecording(const FString& Path, FRecording& OutRecording)
+{
+    TArray<uint8> Data;
+    if (!FFileHelper::LoadFileToArray(Data, *Path))
+    {
+        UE_LOG(LogCrustyPirate, Error, TEXT("Input replay: could not read %s"), *Path);
+        return false;
+    }
+
+    if (!DecodeRecording(Data, OutRecording))
+    {
+        UE_LOG(LogCrustyPirate, Error, TEXT("Input replay: %s is not an input recording of this version or is truncated"), *Path);
+        return false;
+    }
+    return true;
+}
+
+void UInputReplaySubsystem::PrintStats(UWorld* World)
+{
+    const UInputReplaySubsystem* InputReplay = World && World->GetGameInstance() ? World->GetGameInstance()->GetSubsystem<UInputReplaySubsystem>() : nullptr;
+    if (!InputReplay) return;
+
+    if (InputReplay->IsRecording())
+    {
+        UE_LOG(LogCrustyPirate, Display, TEXT("Input replay: recording Level_%d to %s, %d events in %d frames"),
+               InputReplay->Recording.LevelIndex,
+               *InputReplay->FilePath,
+               InputReplay->Recording.Events.Num(),
+               InputReplay->Recording.FrameMicroseconds.Num());
+    }
+    else if (InputReplay->IsPlaying())
+    {
+        UE_LOG(LogCrustyPirate, Display, TEXT("Input replay: playing %s, frame %d of %d, event %d of %d%s"),
+               *InputReplay->FilePath,
+               InputReplay->Frame,
+               InputReplay->Recording.FrameMicroseconds.Num(),
+               InputReplay->NextEvent,
+               InputReplay->Recording.Events.Num(),
+               InputReplay->IsWaitingForLevel ? TEXT(", waiting for the next level") : TEXT(""));
+    }
+    else
+    {
+        UE_LOG(LogCrustyPirate, Display, TEXT("Input replay: idle"));
+    }
+}
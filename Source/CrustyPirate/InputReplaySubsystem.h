@@ -0,0 +1,183 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+
+#include "InputReplaySubsystem.generated.h"
+
+class APlayerCharacter;
+class UEnhancedInputComponent;
+struct FInputActionValue;
+
+/**
+ * Records the input actions of the player (Move, Jump, Attack, Quit) and plays them back through the handlers
+ * of APlayerCharacter, to replay a level for a benchmark or a bug report:
+ *   CrustyPirate -RecordInput[=Path]                   records from the first level loaded until the game exits
+ *   CrustyPirate -PlayInput=Path [-PlayInputExit]      plays a recording back (and exits once it is over)
+ * "CrustyPirate.Replay.Record [Path]" restarts the current level and records it, "CrustyPirate.Replay.Stop" writes
+ * the file and "CrustyPirate.Replay.Play <Path>" plays a file back.
+ * A recording starts when a level is loaded and keeps the state of the game instance at that point (level,
+ * HP, diamonds, double jump) and the fixed step settings (see UFixedStepSubsystem), which are restored before
+ * playing the level again. The recorder binds its own handlers to the input actions, so nothing runs until an
+ * action triggers. Events are stored as the number of frames since the previous event and the action in one
+ * varint (one byte most of the time), the held move value is only stored when it changes. The time of every
+ * frame is stored too, in microseconds as the zigzag varint of the change from the previous frame.
+ * Playback is frame locked: the engine runs with a fixed time step set to the recorded time of each frame, so
+ * the simulation gets the same frame times whatever the machine. The loads of the next level are events too,
+ * playback waits for a load that comes later than in the recording and skips to it when it comes sooner.
+ * The input bindings of the player are turned off while a recording plays.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UInputReplaySubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    // Whether the game was started to play a recording back
+    static bool IsPlaybackRun();
+
+    // Record from the next time the current level is loaded
+    void StartRecording(const FString& Path);
+    void StopRecording();
+
+    bool StartPlayback(const FString& Path);
+
+    bool IsRecording() const { return Mode == EMode::Recording; }
+    bool IsPlaying() const { return Mode == EMode::Playing; }
+
+    static void PrintStats(UWorld* World);
+
+    enum class EReplayAction : uint8
+    {
+        Move,
+        JumpStarted,
+        JumpEnded,
+        Attack,
+        Quit,
+        // The next level was loaded after this frame
+        LevelLoaded,
+        Count
+    };
+
+    struct FReplayEvent
+    {
+        int Frame;
+        EReplayAction Action;
+        float Value;
+    };
+
+    struct FRecording
+    {
+        // State of the game instance when the recording started
+        int LevelIndex = 1;
+        int PlayerHP = 100;
+        int DiamondCount = 0;
+        bool IsDoubleJumpUnlocked = false;
+
+        // The fixed step settings of the recorded run
+        bool IsFixedStepEnabled = false;
+        float FixedStepRate = 120.0f;
+        int FixedStepsPerFrame = 0;
+
+        TArray<FReplayEvent> Events;
+
+        // Engine time of every frame in microseconds (one per frame)
+        TArray<uint32> FrameMicroseconds;
+    };
+
+    // The file format, public for the automation tests
+    static void WriteVarInt(TArray<uint8>& Data, uint32 Value);
+    static bool ReadVarInt(const TArray<uint8>& Data, int& InOutOffset, uint32& OutValue);
+    static void EncodeRecording(const FRecording& Recording, TArray<uint8>& OutData);
+    static bool DecodeRecording(const TArray<uint8>& Data, FRecording& OutRecording);
+    static bool WriteRecording(const FString& Path, const FRecording& Recording);
+    static bool ReadRecording(const FString& Path, FRecording& OutRecording);
+
+private:
+    enum class EMode : uint8
+    {
+        None,
+        // Waiting for the level to be loaded
+        RecordPending,
+        Recording,
+        PlayPending,
+        Playing
+    };
+
+    // Give the game instance the state the recording started with and load the level again
+    void ApplyStartState();
+
+    void OnPostLoadMap(UWorld* LoadedWorld);
+    void OnWorldPreActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+    // Bind the recorder to the input component of the player (once per player)
+    void BindRecorder(APlayerCharacter* Player);
+    void UnbindRecorder();
+
+    void OnMoveTriggered(const FInputActionValue& Value);
+    void OnMoveCompleted(const FInputActionValue& Value);
+    void OnJumpStarted(const FInputActionValue& Value);
+    void OnJumpEnded(const FInputActionValue& Value);
+    void OnAttack(const FInputActionValue& Value);
+    void OnQuit(const FInputActionValue& Value);
+
+    void RecordEvent(EReplayAction Action, float Value = 0.0f);
+
+    // Feed the events of the current frame to the player
+    void PlayFrame(APlayerCharacter* Player);
+
+    // Line the playback up with the level load of the recording
+    void OnPlaybackLevelLoaded();
+
+    // Give the engine the recorded time of the frame for its next frame
+    void SetNextFrameTime(int NextFrame) const;
+
+    // Log how long the playback took, give the engine its time step and the player its input back
+    void FinishPlayback();
+
+    // Give the engine its time step and the fixed step settings from before the playback
+    void RestoreEngineSettings();
+
+    EMode Mode = EMode::None;
+    FString FilePath;
+    FDelegateHandle PreActorTickHandle;
+
+    FRecording Recording;
+
+    // Frames since the recording or the playback started (-1 until the first frame)
+    int Frame = -1;
+
+    // Recording: the move value of the last move event
+    int8 LastMoveValue = 0;
+
+    TWeakObjectPtr<APlayerCharacter> RecordedPlayer;
+    TWeakObjectPtr<UEnhancedInputComponent> RecordedInputComponent;
+    TArray<uint32> BindingHandles;
+
+    // Playback
+    int NextEvent = 0;
+    bool IsStartStateApplied = false;
+    float HeldMoveValue = 0.0f;
+    double PlaybackStartTime = 0.0;
+
+    // The recording reached the load of the next level before the playback did
+    bool IsWaitingForLevel = false;
+    int NumWaitFrames = 0;
+    int NumSkippedEvents = 0;
+
+    // The player whose input bindings are off
+    TWeakObjectPtr<APlayerCharacter> PlayedPlayer;
+
+    // The engine time step and fixed step settings before the playback
+    bool PreviousUseFixedTimeStep = false;
+    double PreviousFixedDeltaTime = 0.0;
+    bool PreviousIsFixedStepEnabled = false;
+    float PreviousFixedStepRate = 120.0f;
+    int PreviousFixedStepsPerFrame = 0;
+};
@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+
+#include "InputReplaySubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInputReplayVarIntTest, "CrustyPirate.InputReplay.VarInt",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInputReplayVarIntTest::RunTest(const FString& Parameters)
+{
+    const uint32 Values[] = { 0, 1, 0x7f, 0x80, 0x3fff, 0x4000, 16667, 0x1fffff, 0x200000, 0x0fffffff, 0x10000000, MAX_uint32 };
+    const int Sizes[] = { 1, 1, 1, 2, 2, 3, 3, 3, 4, 4, 5, 5 };
+
+    TArray<uint8> Data;
+    for (int Index = 0; Index < UE_ARRAY_COUNT(Values); Index++)
+    {
+        const int Start = Data.Num();
+        UInputReplaySubsystem::WriteVarInt(Data, Values[Index]);
+        TestEqual(FString::Printf(TEXT("Size of %u"), Values[Index]), Data.Num() - Start, Sizes[Index]);
+    }
+
+    int Offset = 0;
+    for (const uint32 Value : Values)
+    {
+        uint32 ReadValue = 0;
+        TestTrue(FString::Printf(TEXT("Read %u"), Value), UInputReplaySubsystem::ReadVarInt(Data, Offset, ReadValue));
+        TestEqual(TEXT("Value"), ReadValue, Value);
+    }
+    TestEqual(TEXT("Every byte read"), Offset, Data.Num());
+
+    // A varint cut after a continuation byte
+    TArray<uint8> Truncated;
+    UInputReplaySubsystem::WriteVarInt(Truncated, 0x4000);
+    Truncated.Pop();
+    Offset = 0;
+    uint32 ReadValue = 0;
+    TestFalse(TEXT("Truncated varint"), UInputReplaySubsystem::ReadVarInt(Truncated, Offset, ReadValue));
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInputReplayRecordingTest, "CrustyPirate.InputReplay.Recording",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInputReplayRecordingTest::RunTest(const FString& Parameters)
+{
+    using EReplayAction = UInputReplaySubsystem::EReplayAction;
+
+    UInputReplaySubsystem::FRecording Recording;
+    Recording.LevelIndex = 2;
+    Recording.PlayerHP = 75;
+    Recording.DiamondCount = 12;
+    Recording.IsDoubleJumpUnlocked = true;
+    Recording.IsFixedStepEnabled = true;
+    Recording.FixedStepRate = 120.0f;
+    Recording.FixedStepsPerFrame = 2;
+    Recording.Events.Add({ 0, EReplayAction::Move, 1.0f });
+    Recording.Events.Add({ 3, EReplayAction::JumpStarted, 0.0f });
+    Recording.Events.Add({ 3, EReplayAction::Attack, 0.0f });
+    Recording.Events.Add({ 20, EReplayAction::JumpEnded, 0.0f });
+    Recording.Events.Add({ 500, EReplayAction::Move, -64.0f / 127.0f });
+    Recording.Events.Add({ 900, EReplayAction::LevelLoaded, 0.0f });
+    Recording.Events.Add({ 5000, EReplayAction::Quit, 0.0f });
+
+    // Steady frames, a hitch, a frame that got faster and a load longer than what is stored
+    for (int Frame = 0; Frame <= 5000; Frame++)
+    {
+        uint32 Microseconds = 16667;
+        if (Frame == 100) Microseconds = 250000;
+        if (Frame == 101) Microseconds = 8333;
+        if (Frame == 901) Microseconds = 20000000;
+        Recording.FrameMicroseconds.Add(Microseconds);
+    }
+
+    const FString Path = FPaths::AutomationTransientDir() / TEXT("InputReplayTest.replay");
+    TestTrue(TEXT("Write"), UInputReplaySubsystem::WriteRecording(Path, Recording));
+
+    UInputReplaySubsystem::FRecording ReadBack;
+    if (TestTrue(TEXT("Read"), UInputReplaySubsystem::ReadRecording(Path, ReadBack)))
+    {
+        TestEqual(TEXT("Level"), ReadBack.LevelIndex, Recording.LevelIndex);
+        TestEqual(TEXT("HP"), ReadBack.PlayerHP, Recording.PlayerHP);
+        TestEqual(TEXT("Diamonds"), ReadBack.DiamondCount, Recording.DiamondCount);
+        TestEqual(TEXT("Double jump"), ReadBack.IsDoubleJumpUnlocked, Recording.IsDoubleJumpUnlocked);
+        TestEqual(TEXT("Fixed steps"), ReadBack.IsFixedStepEnabled, Recording.IsFixedStepEnabled);
+        TestEqual(TEXT("Fixed step rate"), ReadBack.FixedStepRate, Recording.FixedStepRate);
+        TestEqual(TEXT("Steps per frame"), ReadBack.FixedStepsPerFrame, Recording.FixedStepsPerFrame);
+
+        if (TestEqual(TEXT("Events"), ReadBack.Events.Num(), Recording.Events.Num()))
+        {
+            for (int Index = 0; Index < Recording.Events.Num(); Index++)
+            {
+                TestEqual(TEXT("Event frame"), ReadBack.Events[Index].Frame, Recording.Events[Index].Frame);
+                TestTrue(TEXT("Event action"), ReadBack.Events[Index].Action == Recording.Events[Index].Action);
+                TestEqual(TEXT("Event value"), ReadBack.Events[Index].Value, Recording.Events[Index].Value);
+            }
+        }
+
+        if (TestEqual(TEXT("Frames"), ReadBack.FrameMicroseconds.Num(), Recording.FrameMicroseconds.Num()))
+        {
+            TestEqual(TEXT("Steady frame"), ReadBack.FrameMicroseconds[0], 16667u);
+            TestEqual(TEXT("Hitch"), ReadBack.FrameMicroseconds[100], 250000u);
+            TestEqual(TEXT("Fast frame"), ReadBack.FrameMicroseconds[101], 8333u);
+            TestEqual(TEXT("Long load clamped"), ReadBack.FrameMicroseconds[901], 10000000u);
+            TestEqual(TEXT("Last frame"), ReadBack.FrameMicroseconds.Last(), 16667u);
+        }
+    }
+
+    // Steady frames take one byte each
+    TArray<uint8> Data;
+    UInputReplaySubsystem::EncodeRecording(Recording, Data);
+    TestTrue(TEXT("About a byte per frame"), Data.Num() < Recording.FrameMicroseconds.Num() + 64);
+
+    // Cut in the frame times
+    Data.SetNum(Data.Num() - 10);
+    TestFalse(TEXT("Truncated recording"), UInputReplaySubsystem::DecodeRecording(Data, ReadBack));
+
+    // Another format
+    Data.Reset();
+    Data.Append({ 'N', 'O', 'P', 'E', 1, 0 });
+    TestFalse(TEXT("Not a recording"), UInputReplaySubsystem::DecodeRecording(Data, ReadBack));
+
+    IFileManager::Get().Delete(*Path);
+    return true;
+}
+
+#endif
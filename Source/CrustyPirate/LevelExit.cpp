@@ -3,13 +3,18 @@
 
 #include "Kismet/GameplayStatics.h"
 
+#include "CheckpointSubsystem.h"
 #include "PlayerCharacter.h"
 #include "CrustyPirateGameInstance.h"
+#include "TickLODSubsystem.h"
+#include "CrustyPirate.h"
+
+DECLARE_CYCLE_STAT(TEXT("Level Exit Overlap"), STAT_LevelExitOverlap, STATGROUP_CrustyPirate);
 
 
 ALevelExit::ALevelExit()
 {
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
     
     BoxComp = CreateDefaultSubobject<UBoxComponent>(TEXT("BoxComp"));
     SetRootComponent(BoxComp);
@@ -31,17 +36,33 @@ void ALevelExit::BeginPlay()
     
     // Close the door (i,e., go to the first frame)
     DoorFlipbook->SetPlaybackPosition(0.0f, false);
-	
+    
+    // Stop ticking the door while it is away from the camera
+    if (UTickLODSubsystem* TickLOD = GetWorld()->GetSubsystem<UTickLODSubsystem>())
+    {
+        TickLOD->RegisterActor(this);
+    }
+    
+    if (UCheckpointSubsystem* Checkpoints = GetWorld()->GetSubsystem<UCheckpointSubsystem>())
+    {
+        Checkpoints->RegisterExit(this);
+    }
 }
 
-void ALevelExit::Tick(float DeltaTime)
+void ALevelExit::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
-
+    if (UTickLODSubsystem* TickLOD = GetWorld()->GetSubsystem<UTickLODSubsystem>())
+    {
+        TickLOD->UnregisterActor(this);
+    }
+    
+    Super::EndPlay(EndPlayReason);
 }
 
 void ALevelExit::OverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+    SCOPE_CYCLE_COUNTER(STAT_LevelExitOverlap);
+    
     // Check if the actor that overlaps is the player
     APlayerCharacter* Player = Cast<APlayerCharacter>(OtherActor);
     if (Player && Player->IsAlive)
@@ -51,9 +72,21 @@ void ALevelExit::OverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* Oth
             // Deactivate the player
             Player->Deactivate();
             
+            // Load the next level while the door opens
+            if (UCrustyPirateGameInstance* MyGameInstance = Cast<UCrustyPirateGameInstance>(GetGameInstance()))
+            {
+                MyGameInstance->PreloadLevel(LevelIndex);
+            }
+            
             
             IsActive = false;
             
+            // Make sure the door animates
+            if (UTickLODSubsystem* TickLOD = GetWorld()->GetSubsystem<UTickLODSubsystem>())
+            {
+                TickLOD->WakeActor(this);
+            }
+            
             // Open the door
             DoorFlipbook->SetPlayRate(1.0f);
             DoorFlipbook->PlayFromStart();
@@ -61,14 +94,35 @@ void ALevelExit::OverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* Oth
             UGameplayStatics::PlaySound2D(GetWorld(), PlayerEnterSound);
             
             // Change levels
-            GetWorldTimerManager().SetTimer(WaitTimer, this, &ALevelExit::OnWaitTimerTimeout, 1.0f, false, WaitTimeInSeconds);
+            GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->SetTimer(WaitTimer, this, &ALevelExit::OnWaitTimerTimeout, WaitTimeInSeconds);
         }
     }
 }
 
+void ALevelExit::RestoreState(bool Active)
+{
+    if (IsActive == Active) return;
+    
+    IsActive = Active;
+    
+    if (Active)
+    {
+        // Do not change levels and close the door
+        GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->ClearTimer(WaitTimer);
+        DoorFlipbook->SetPlayRate(0.0f);
+        DoorFlipbook->SetPlaybackPosition(0.0f, false);
+    }
+    else
+    {
+        // Leave the door open
+        DoorFlipbook->SetPlayRate(0.0f);
+        DoorFlipbook->SetPlaybackPositionInFrames(DoorFlipbook->GetFlipbookLengthInFrames() - 1, false);
+    }
+}
+
 void ALevelExit::OnWaitTimerTimeout()
 {
-    // Get the game instance
+    // Get the game instance (it waits for the preload started in OverlapBegin if it is not done yet)
     UCrustyPirateGameInstance* MyGameInstance = Cast<UCrustyPirateGameInstance>(GetGameInstance());
     if (MyGameInstance)
     {
@@ -7,7 +7,7 @@
 #include "PaperFlipbookComponent.h"
 
 #include "Sound/SoundBase.h"
-#include "Engine/TimerHandle.h"
+#include "GameplayTimerSubsystem.h"
 
 #include "LevelExit.generated.h"
 
@@ -35,17 +35,20 @@ public:
     UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
     bool IsActive = true;
     
-    FTimerHandle WaitTimer;
+    FGameplayTimerHandle WaitTimer;
     
 	ALevelExit();
 
 	virtual void BeginPlay() override;
-
-	virtual void Tick(float DeltaTime) override;
+    
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
     
     UFUNCTION()
     void OverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
     
     void OnWaitTimerTimeout();
+    
+    // Open or close the exit again without playing any sound (used when a checkpoint is restored)
+    void RestoreState(bool Active);
 
 };
@@ -0,0 +1,299 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LevelPreloadSubsystem.h"
+
+#include "Engine/AssetManager.h"
+#include "AssetRegistry/IAssetRegistry.h"
+#include "EngineUtils.h"
+#include "Kismet/GameplayStatics.h"
+
+#include "PaperTileMap.h"
+#include "PaperTileSet.h"
+#include "PaperFlipbook.h"
+#include "PaperSprite.h"
+#include "Engine/Texture.h"
+#include "Sound/SoundBase.h"
+
+#include "CrustyPirate.h"
+#include "LevelExit.h"
+
+static TAutoConsoleVariable<float> CVarPreloadFraction(
+    TEXT("CrustyPirate.Preload.LevelFraction"),
+    0.6f,
+    TEXT("Start preloading the next level once the player got this fraction of the way from its start to a level exit."));
+
+static TAutoConsoleVariable<float> CVarPreloadExitDistance(
+    TEXT("CrustyPirate.Preload.ExitDistance"),
+    1500.0f,
+    TEXT("Start preloading the next level when the player gets this close (along X) to a level exit."));
+
+static FAutoConsoleCommandWithWorld PreloadReportCommand(
+    TEXT("CrustyPirate.Preload.Report"),
+    TEXT("Print the level preload hits and misses."),
+    FConsoleCommandWithWorldDelegate::CreateStatic(&ULevelPreloadSubsystem::PrintReport));
+
+static const FName LevelPreloadAssetType("LevelPreload");
+
+// The bundles of a level
+static const FName TileMapsBundle("TileMaps");
+static const FName FlipbooksBundle("Flipbooks");
+static const FName SpritesBundle("Sprites");
+static const FName SoundsBundle("Sounds");
+
+static FName GetBundleName(const FAssetData& Asset)
+{
+    const UClass* AssetClass = Asset.GetClass();
+    if (!AssetClass) return NAME_None;
+
+    if (AssetClass->IsChildOf<UPaperTileMap>() || AssetClass->IsChildOf<UPaperTileSet>()) return TileMapsBundle;
+    if (AssetClass->IsChildOf<UPaperFlipbook>()) return FlipbooksBundle;
+    if (AssetClass->IsChildOf<UPaperSprite>() || AssetClass->IsChildOf<UTexture>()) return SpritesBundle;
+    if (AssetClass->IsChildOf<USoundBase>()) return SoundsBundle;
+
+    return NAME_None;
+}
+
+void ULevelPreloadSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    RegisterLevelAssets();
+
+    FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ULevelPreloadSubsystem::OnPostLoadMap);
+}
+
+void ULevelPreloadSubsystem::Deinitialize()
+{
+    FCoreUObjectDelegates::PostLoadMapWithWorld.RemoveAll(this);
+
+    ReleasePreloads();
+
+    Super::Deinitialize();
+}
+
+void ULevelPreloadSubsystem::RegisterLevelAssets()
+{
+    UAssetManager* AssetManager = UAssetManager::GetIfInitialized();
+    if (!AssetManager) return;
+
+    IAssetRegistry& AssetRegistry = AssetManager->GetAssetRegistry();
+
+    TArray<FAssetData> Maps;
+    AssetRegistry.GetAssetsByPath(FName("/Game/Levels"), Maps);
+
+    TSet<FName> VisitedPackages;
+    TArray<FName> PackagesToVisit;
+    TArray<FName> Dependencies;
+    TArray<FAssetData> PackageAssets;
+
+    for (const FAssetData& Map : Maps)
+    {
+        if (Map.AssetClassPath != UWorld::StaticClass()->GetClassPathName()) continue;
+
+        const int LevelIndex = GetLevelIndex(Map.AssetName.ToString());
+        if (LevelIndex <= 0) continue;
+
+        // Walk the hard package dependencies of the map (the blueprints placed in it bring in the flipbooks and sounds)
+        FAssetBundleData Bundles;
+        VisitedPackages.Reset();
+        PackagesToVisit.Reset();
+        PackagesToVisit.Add(Map.PackageName);
+
+        while (PackagesToVisit.Num() > 0)
+        {
+            const FName PackageName = PackagesToVisit.Pop(EAllowShrinking::No);
+
+            Dependencies.Reset();
+            AssetRegistry.GetDependencies(PackageName, Dependencies, UE::AssetRegistry::EDependencyCategory::Package, UE::AssetRegistry::EDependencyQuery::Hard);
+
+            for (const FName Dependency : Dependencies)
+            {
+                // Engine and plugin content is left alone
+                if (!Dependency.ToString().StartsWith(TEXT("/Game/"))) continue;
+
+                bool AlreadyVisited = false;
+                VisitedPackages.Add(Dependency, &AlreadyVisited);
+                if (AlreadyVisited) continue;
+
+                PackagesToVisit.Add(Dependency);
+
+                PackageAssets.Reset();
+                AssetRegistry.GetAssetsByPackageName(Dependency, PackageAssets);
+                for (const FAssetData& Asset : PackageAssets)
+                {
+                    const FName BundleName = GetBundleName(Asset);
+                    if (!BundleName.IsNone())
+                    {
+                        Bundles.AddBundleAsset(BundleName, Asset.GetSoftObjectPath().GetAssetPath());
+                    }
+                }
+            }
+        }
+
+        LevelAssets.Add(LevelIndex, { Map.GetSoftObjectPath(), MoveTemp(Bundles) });
+    }
+
+    UE_LOG(LogCrustyPirate, Log, TEXT("Level preload: found the bundles of %d levels"), LevelAssets.Num());
+}
+
+void ULevelPreloadSubsystem::PreloadLevel(int LevelIndex)
+{
+    const FLevelAssets* Assets = LevelAssets.Find(LevelIndex);
+    if (!Assets || PreloadHandles.Contains(LevelIndex)) return;
+
+    UAssetManager* AssetManager = UAssetManager::GetIfInitialized();
+    if (!AssetManager) return;
+
+    // The level is only known to the asset manager while it is preloading (see ReleasePreloads)
+    if (!AssetManager->AddDynamicAsset(GetLevelAssetId(LevelIndex), Assets->Map, Assets->Bundles)) return;
+
+    const TArray<FName> Bundles = { TileMapsBundle, FlipbooksBundle, SpritesBundle, SoundsBundle };
+    PreloadHandles.Add(LevelIndex, AssetManager->PreloadPrimaryAssets({ GetLevelAssetId(LevelIndex) }, Bundles, false));
+}
+
+void ULevelPreloadSubsystem::Tick(float DeltaTime)
+{
+    UWorld* World = GetTickableGameObjectWorld();
+    if (!World || !World->IsGameWorld()) return;
+
+    // Find the level exits once per world
+    if (ScannedWorld != World)
+    {
+        ScannedWorld = World;
+        LevelExits.Reset();
+        for (TActorIterator<ALevelExit> It(World); It; ++It)
+        {
+            LevelExits.Add(*It);
+        }
+        HasLevelStart = false;
+    }
+
+    const APawn* Player = UGameplayStatics::GetPlayerPawn(World, 0);
+    if (!Player) return;
+
+    const float PlayerX = Player->GetActorLocation().X;
+    if (!HasLevelStart)
+    {
+        HasLevelStart = true;
+        LevelStartX = PlayerX;
+    }
+
+    const float PreloadFraction = CVarPreloadFraction.GetValueOnGameThread();
+    const float PreloadExitDistance = CVarPreloadExitDistance.GetValueOnGameThread();
+
+    for (const TWeakObjectPtr<ALevelExit>& LevelExit : LevelExits)
+    {
+        if (!LevelExit.IsValid() || PreloadHandles.Contains(LevelExit->LevelIndex)) continue;
+
+        const float ExitX = LevelExit->GetActorLocation().X;
+        const float LevelLength = ExitX - LevelStartX;
+        const float Progress = FMath::Abs(LevelLength) > 1.0f ? (PlayerX - LevelStartX) / LevelLength : 1.0f;
+
+        if (Progress >= PreloadFraction || FMath::Abs(ExitX - PlayerX) <= PreloadExitDistance)
+        {
+            PreloadLevel(LevelExit->LevelIndex);
+        }
+    }
+}
+
+void ULevelPreloadSubsystem::OnPostLoadMap(UWorld* LoadedWorld)
+{
+    const int LevelIndex = LoadedWorld ? GetLevelIndex(LoadedWorld->GetMapName()) : 0;
+
+    // The first map is loaded with the game, there was nothing to preload it from
+    if (HasLoadedFirstMap && LevelIndex > 0)
+    {
+        const TSharedPtr<FStreamableHandle>* Handle = PreloadHandles.Find(LevelIndex);
+        if (LevelIndex == LoadedLevelIndex)
+        {
+            // Restarting the level loads it again from what it left in memory, it is not a preload miss
+            LevelRestarts++;
+        }
+        else if (!Handle)
+        {
+            PreloadMisses++;
+        }
+        else if (!Handle->IsValid() || (*Handle)->HasLoadCompleted())
+        {
+            // There is no handle when the bundles were already in memory
+            PreloadHits++;
+        }
+        else
+        {
+            PreloadLateHits++;
+        }
+    }
+    HasLoadedFirstMap = true;
+    LoadedLevelIndex = LevelIndex;
+
+    // The new world references everything it uses now
+    ReleasePreloads();
+}
+
+void ULevelPreloadSubsystem::ReleasePreloads()
+{
+    UAssetManager* AssetManager = UAssetManager::GetIfInitialized();
+
+    for (TPair<int, TSharedPtr<FStreamableHandle>>& Pair : PreloadHandles)
+    {
+        if (Pair.Value.IsValid())
+        {
+            Pair.Value->ReleaseHandle();
+        }
+
+        if (AssetManager)
+        {
+            AssetManager->RemoveDynamicAsset(GetLevelAssetId(Pair.Key));
+        }
+    }
+    PreloadHandles.Reset();
+}
+
+FPrimaryAssetId ULevelPreloadSubsystem::GetLevelAssetId(int LevelIndex)
+{
+    return FPrimaryAssetId(LevelPreloadAssetType, FName(FString::Printf(TEXT("Level_%d"), LevelIndex)));
+}
+
+int ULevelPreloadSubsystem::GetLevelIndex(const FString& MapName)
+{
+    // PIE maps are prefixed (UEDPIE_0_Level_2)
+    const int Position = MapName.Find(TEXT("Level_"), ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+    if (Position == INDEX_NONE) return 0;
+
+    return FCString::Atoi(*MapName.Mid(Position + 6));
+}
+
+void ULevelPreloadSubsystem::PrintReport(UWorld* World)
+{
+    const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+    const ULevelPreloadSubsystem* Preload = GameInstance ? GameInstance->GetSubsystem<ULevelPreloadSubsystem>() : nullptr;
+    if (!Preload) return;
+
+    const int NumLoads = Preload->PreloadHits + Preload->PreloadLateHits + Preload->PreloadMisses;
+    UE_LOG(LogCrustyPirate, Display, TEXT("Level preload: %d levels found, %d level loads, %d hits, %d still loading, %d misses (hit rate %.0f%%), %d restarts not counted, %d preloads in flight"),
+           Preload->LevelAssets.Num(),
+           NumLoads,
+           Preload->PreloadHits,
+           Preload->PreloadLateHits,
+           Preload->PreloadMisses,
+           NumLoads > 0 ? 100.0f * Preload->PreloadHits / NumLoads : 0.0f,
+           Preload->LevelRestarts,
+           Preload->PreloadHandles.Num());
+}
+
+TStatId ULevelPreloadSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(ULevelPreloadSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType ULevelPreloadSubsystem::GetTickableTickType() const
+{
+    // The class default object of the subsystem must not tick
+    return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Always;
+}
+
+UWorld* ULevelPreloadSubsystem::GetTickableGameObjectWorld() const
+{
+    return GetGameInstance() ? GetGameInstance()->GetWorld() : nullptr;
+}
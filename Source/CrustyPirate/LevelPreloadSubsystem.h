@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+#include "Engine/StreamableManager.h"
+#include "AssetRegistry/AssetBundleData.h"
+
+#include "LevelPreloadSubsystem.generated.h"
+
+class ALevelExit;
+
+/**
+ * Loads the assets of the next level before the player gets there.
+ * The bundles of every Level_N map hold the tile maps/tile sets, flipbooks, sprites/textures and sounds the map
+ * depends on (found in the asset registry). While playing, the level an ALevelExit leads to is registered with the
+ * asset manager as a "LevelPreload" primary asset and its bundles start loading once the player got through
+ * PreloadFraction of the way from where it started to the exit, or is within PreloadExitDistance of it.
+ * Once the next map is loaded the preloads are released and the levels removed from the asset manager again.
+ * "CrustyPirate.Preload.Report" prints how many level loads found their bundles already loaded (restarting the
+ * same level is not counted).
+ */
+UCLASS()
+class CRUSTYPIRATE_API ULevelPreloadSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    // Start loading the bundles of the level (does nothing if it is already loading)
+    void PreloadLevel(int LevelIndex);
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+    virtual ETickableTickType GetTickableTickType() const override;
+    virtual UWorld* GetTickableGameObjectWorld() const override;
+
+    static void PrintReport(UWorld* World);
+
+private:
+    struct FLevelAssets
+    {
+        FSoftObjectPath Map;
+        FAssetBundleData Bundles;
+    };
+
+    // Find the Level_N maps and their bundles
+    void RegisterLevelAssets();
+
+    void OnPostLoadMap(UWorld* LoadedWorld);
+
+    // Release the preload handles and remove their levels from the asset manager
+    void ReleasePreloads();
+
+    static FPrimaryAssetId GetLevelAssetId(int LevelIndex);
+
+    // Index of the level from the name of its map (0 when it is not a Level_N map)
+    static int GetLevelIndex(const FString& MapName);
+
+    // The levels whose bundles are loading or loaded, each one registered with the asset manager
+    TMap<int, TSharedPtr<FStreamableHandle>> PreloadHandles;
+
+    TMap<int, FLevelAssets> LevelAssets;
+
+    // The level exits of the current world and the X position the player started from
+    TWeakObjectPtr<UWorld> ScannedWorld;
+    TArray<TWeakObjectPtr<ALevelExit>> LevelExits;
+    bool HasLevelStart = false;
+    float LevelStartX = 0.0f;
+
+    bool HasLoadedFirstMap = false;
+    int LoadedLevelIndex = 0;
+
+    // Level loads that found their bundles fully loaded, still loading or not requested at all
+    int PreloadHits = 0;
+    int PreloadLateHits = 0;
+    int PreloadMisses = 0;
+    int LevelRestarts = 0;
+};
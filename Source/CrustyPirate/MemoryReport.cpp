@@ -0,0 +1,232 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MemoryReport.h"
+
+#include "EngineUtils.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/UObjectHash.h"
+#include "UObject/UObjectIterator.h"
+#include "Blueprint/WidgetTree.h"
+#include "PaperTileMap.h"
+#include "PaperTileMapComponent.h"
+
+#include "CrustyPirate.h"
+#include "BakedDecorations.h"
+#include "CollectableField.h"
+#include "CollectableItem.h"
+#include "Enemy.h"
+#include "HealthBarRenderer.h"
+#include "PlayerCharacter.h"
+#include "PlayerHUD.h"
+
+static TAutoConsoleVariable<int32> CVarMemBudgetEnemies(
+    TEXT("CrustyPirate.MemReport.Budget.Enemies"),
+    0,
+    TEXT("Memory budget in KB of the enemies, pooled ones included (0 for no budget)."));
+
+static TAutoConsoleVariable<int32> CVarMemBudgetPlayer(
+    TEXT("CrustyPirate.MemReport.Budget.Player"),
+    0,
+    TEXT("Memory budget in KB of the player character (0 for no budget)."));
+
+static TAutoConsoleVariable<int32> CVarMemBudgetCollectables(
+    TEXT("CrustyPirate.MemReport.Budget.Collectables"),
+    0,
+    TEXT("Memory budget in KB of the collectable items and fields (0 for no budget)."));
+
+static TAutoConsoleVariable<int32> CVarMemBudgetHUD(
+    TEXT("CrustyPirate.MemReport.Budget.HUD"),
+    0,
+    TEXT("Memory budget in KB of the HUD widgets and the health bars (0 for no budget)."));
+
+static TAutoConsoleVariable<int32> CVarMemBudgetTileMaps(
+    TEXT("CrustyPirate.MemReport.Budget.TileMaps"),
+    0,
+    TEXT("Memory budget in KB of the tile maps, their baked chunks and decorations (0 for no budget)."));
+
+static FAutoConsoleCommandWithWorld MemReportCommand(
+    TEXT("CrustyPirate.MemReport"),
+    TEXT("Print the instance counts, component counts and memory of the gameplay classes and check them against their budgets."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        FMemoryReport::PrintReport(World);
+    }));
+
+enum class EMemoryCategory : uint8
+{
+    Enemies,
+    Player,
+    Collectables,
+    HUD,
+    TileMaps,
+    Count
+};
+
+static int64 GetObjectBytes(UObject* Object)
+{
+    FArchiveCountMem Count(Object);
+    return Count.GetMax() + Object->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+}
+
+// The object and everything it owns (components, anim instance, widget tree...)
+static int64 GetOwnedBytes(UObject* Object)
+{
+    int64 Bytes = GetObjectBytes(Object);
+    ForEachObjectWithOuter(Object, [&Bytes](UObject* Inner)
+    {
+        Bytes += GetObjectBytes(Inner);
+    }, true);
+    return Bytes;
+}
+
+static void AddToCategory(FMemoryReport::FCategory& Category, FName ClassName, int NumComponents, int64 Bytes)
+{
+    FMemoryReport::FClassEntry* Entry = Category.Classes.FindByPredicate([ClassName](const FMemoryReport::FClassEntry& Candidate)
+    {
+        return Candidate.ClassName == ClassName;
+    });
+    if (!Entry)
+    {
+        Entry = &Category.Classes.AddDefaulted_GetRef();
+        Entry->ClassName = ClassName;
+    }
+
+    Entry->NumInstances++;
+    Entry->NumComponents += NumComponents;
+    Entry->Bytes += Bytes;
+
+    Category.NumInstances++;
+    Category.NumComponents += NumComponents;
+    Category.Bytes += Bytes;
+}
+
+void FMemoryReport::Gather(UWorld* World, TArray<FCategory>& OutCategories)
+{
+    OutCategories.Reset();
+    OutCategories.SetNum((int)EMemoryCategory::Count);
+
+    OutCategories[(int)EMemoryCategory::Enemies].Name = TEXT("Enemies");
+    OutCategories[(int)EMemoryCategory::Enemies].BudgetBytes = CVarMemBudgetEnemies.GetValueOnGameThread() * 1024ll;
+    OutCategories[(int)EMemoryCategory::Player].Name = TEXT("Player");
+    OutCategories[(int)EMemoryCategory::Player].BudgetBytes = CVarMemBudgetPlayer.GetValueOnGameThread() * 1024ll;
+    OutCategories[(int)EMemoryCategory::Collectables].Name = TEXT("Collectables");
+    OutCategories[(int)EMemoryCategory::Collectables].BudgetBytes = CVarMemBudgetCollectables.GetValueOnGameThread() * 1024ll;
+    OutCategories[(int)EMemoryCategory::HUD].Name = TEXT("HUD");
+    OutCategories[(int)EMemoryCategory::HUD].BudgetBytes = CVarMemBudgetHUD.GetValueOnGameThread() * 1024ll;
+    OutCategories[(int)EMemoryCategory::TileMaps].Name = TEXT("TileMaps");
+    OutCategories[(int)EMemoryCategory::TileMaps].BudgetBytes = CVarMemBudgetTileMaps.GetValueOnGameThread() * 1024ll;
+
+    if (!World) return;
+
+    // Tile map assets can be shared by several components, they are counted once
+    TSet<UPaperTileMap*> CountedTileMaps;
+
+    for (TActorIterator<AActor> It(World); It; ++It)
+    {
+        AActor* Actor = *It;
+
+        EMemoryCategory Category = EMemoryCategory::Count;
+        if (Actor->IsA<AEnemy>())
+        {
+            Category = EMemoryCategory::Enemies;
+        }
+        else if (Actor->IsA<APlayerCharacter>())
+        {
+            Category = EMemoryCategory::Player;
+        }
+        else if (Actor->IsA<ACollectableItem>() || Actor->IsA<ACollectableField>())
+        {
+            Category = EMemoryCategory::Collectables;
+        }
+        else if (Actor->IsA<AHealthBarRenderer>())
+        {
+            Category = EMemoryCategory::HUD;
+        }
+        else if (Actor->IsA<ABakedDecorations>() || Actor->FindComponentByClass<UPaperTileMapComponent>())
+        {
+            Category = EMemoryCategory::TileMaps;
+        }
+        if (Category == EMemoryCategory::Count) continue;
+
+        int64 Bytes = GetOwnedBytes(Actor);
+
+        if (Category == EMemoryCategory::TileMaps)
+        {
+            TInlineComponentArray<UPaperTileMapComponent*> Components(Actor);
+            for (UPaperTileMapComponent* Component : Components)
+            {
+                // A tile map made editable is owned by its component and already counted with the actor
+                UPaperTileMap* TileMap = Component->TileMap;
+                if (TileMap && !TileMap->IsIn(Actor) && !CountedTileMaps.Contains(TileMap))
+                {
+                    CountedTileMaps.Add(TileMap);
+                    Bytes += GetOwnedBytes(TileMap);
+                }
+            }
+        }
+
+        AddToCategory(OutCategories[(int)Category], Actor->GetClass()->GetFName(), Actor->GetComponents().Num(), Bytes);
+    }
+
+    // The widgets of the HUD are counted as its components
+    for (TObjectIterator<UPlayerHUD> It; It; ++It)
+    {
+        UPlayerHUD* Widget = *It;
+        if (Widget->HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject) || Widget->GetWorld() != World) continue;
+
+        TArray<UWidget*> Widgets;
+        if (Widget->WidgetTree)
+        {
+            Widget->WidgetTree->GetAllWidgets(Widgets);
+        }
+
+        AddToCategory(OutCategories[(int)EMemoryCategory::HUD], Widget->GetClass()->GetFName(), Widgets.Num(), GetOwnedBytes(Widget));
+    }
+
+    for (FCategory& Category : OutCategories)
+    {
+        Category.Classes.Sort([](const FClassEntry& A, const FClassEntry& B) { return A.Bytes > B.Bytes; });
+    }
+}
+
+int FMemoryReport::PrintReport(UWorld* World)
+{
+    if (!World) return 0;
+
+    TArray<FCategory> Categories;
+    Gather(World, Categories);
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Memory report of %s:"), *World->GetMapName());
+
+    int NumOverBudget = 0;
+    for (const FCategory& Category : Categories)
+    {
+        UE_LOG(LogCrustyPirate, Display, TEXT("  %s: %d instances, %d components, %.1f KB (budget %s)"),
+               *Category.Name.ToString(),
+               Category.NumInstances,
+               Category.NumComponents,
+               Category.Bytes / 1024.0,
+               Category.BudgetBytes > 0 ? *FString::Printf(TEXT("%lld KB"), Category.BudgetBytes / 1024) : TEXT("none"));
+
+        for (const FClassEntry& Entry : Category.Classes)
+        {
+            UE_LOG(LogCrustyPirate, Display, TEXT("    %s: %d instances, %d components, %.1f KB"),
+                   *Entry.ClassName.ToString(),
+                   Entry.NumInstances,
+                   Entry.NumComponents,
+                   Entry.Bytes / 1024.0);
+        }
+
+        if (Category.IsOverBudget())
+        {
+            NumOverBudget++;
+            UE_LOG(LogCrustyPirate, Warning, TEXT("Memory budget of %s exceeded: %.1f KB of %lld KB"),
+                   *Category.Name.ToString(),
+                   Category.Bytes / 1024.0,
+                   Category.BudgetBytes / 1024);
+        }
+    }
+
+    return NumOverBudget;
+}
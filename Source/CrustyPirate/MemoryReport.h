@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Accounts the memory of the gameplay objects of a world per category (enemies, player, collectables, HUD,
+ * tile maps) and per class: instance count, component count and bytes. The bytes of an object include everything
+ * it owns (components, anim instance, widget tree...) as counted by FArchiveCountMem plus the resource size of
+ * its meshes. Only objects are looked at, so the report also works in -nullrhi runs.
+ * Every category has a budget in KB ("CrustyPirate.MemReport.Budget.<Category>", 0 for none), a warning is
+ * logged when it is exceeded. "CrustyPirate.MemReport" prints the report.
+ * The allocations of the gameplay classes are also tagged for the Low-Level Memory Tracker (CrustyPirate/...
+ * in "stat LLMFULL" and Unreal Insights when running with -llm).
+ */
+class CRUSTYPIRATE_API FMemoryReport
+{
+public:
+    struct FClassEntry
+    {
+        FName ClassName;
+        int NumInstances = 0;
+        int NumComponents = 0;
+        int64 Bytes = 0;
+    };
+
+    struct FCategory
+    {
+        FName Name;
+        int64 BudgetBytes = 0;
+        int NumInstances = 0;
+        int NumComponents = 0;
+        int64 Bytes = 0;
+
+        // Sorted by bytes, largest first
+        TArray<FClassEntry> Classes;
+
+        bool IsOverBudget() const { return BudgetBytes > 0 && Bytes > BudgetBytes; }
+    };
+
+    static void Gather(UWorld* World, TArray<FCategory>& OutCategories);
+
+    // Log the report and a warning for every category over its budget. Returns the number of categories over budget
+    static int PrintReport(UWorld* World);
+};
@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlatformerWalkerMovement.h"
+
+#include "GameFramework/Character.h"
+#include "GameFramework/PhysicsVolume.h"
+#include "Components/CapsuleComponent.h"
+
+#include "CrustyPirate.h"
+
+DECLARE_CYCLE_STAT(TEXT("Platformer Walker Movement"), STAT_PlatformerWalkerMovement, STATGROUP_CrustyPirate);
+
+void UPlatformerWalkerMovement::InitializeComponent()
+{
+    Super::InitializeComponent();
+    
+    if (UseKinematicWalking)
+    {
+        // None of these are needed by enemies walking along a single axis
+        NetworkSmoothingMode = ENetworkSmoothingMode::Disabled;
+        bEnablePhysicsInteraction = false;
+        bUseRVOAvoidance = false;
+    }
+}
+
+void UPlatformerWalkerMovement::OnTeleported()
+{
+    Super::OnTeleported();
+    
+    HasKnownFloor = false;
+}
+
+void UPlatformerWalkerMovement::Activate(bool bReset)
+{
+    Super::Activate(bReset);
+    
+    HasKnownFloor = false;
+}
+
+void UPlatformerWalkerMovement::PhysWalking(float DeltaTime, int32 Iterations)
+{
+    if (!UseKinematicWalking)
+    {
+        Super::PhysWalking(DeltaTime, Iterations);
+        return;
+    }
+    
+    SCOPE_CYCLE_COUNTER(STAT_PlatformerWalkerMovement);
+    
+    if (DeltaTime < MIN_TICK_TIME || !CharacterOwner || !UpdatedComponent) return;
+    
+    // Only walk along X
+    Acceleration = FVector(Acceleration.X, 0.0f, 0.0f);
+    Velocity = FVector(Velocity.X, 0.0f, 0.0f);
+    CalcVelocity(DeltaTime, GroundFriction, false, GetMaxBrakingDeceleration());
+    Velocity = FVector(Velocity.X, 0.0f, 0.0f);
+    
+    const float Move = Velocity.X * DeltaTime;
+    if (FMath::IsNearlyZero(Move) && HasKnownFloor)
+    {
+        // Standing still on a known floor
+        return;
+    }
+    
+    IsAgainstWall = false;
+    IsAtEdge = false;
+    
+    if (!FMath::IsNearlyZero(Move))
+    {
+        FHitResult Hit;
+        SafeMoveUpdatedComponent(FVector(Move, 0.0f, 0.0f), UpdatedComponent->GetComponentQuat(), true, Hit);
+        
+        if (Hit.IsValidBlockingHit() && !IsWalkable(Hit))
+        {
+            IsAgainstWall = true;
+            Velocity.X = 0.0f;
+        }
+    }
+    
+    if (!SnapToFloor())
+    {
+        // Walked off the floor
+        HasKnownFloor = false;
+        SetMovementMode(MOVE_Falling);
+        StartNewPhysics(0.0f, Iterations);
+        return;
+    }
+    
+    // Look for the floor just in front of the leading edge of the capsule
+    if (!FMath::IsNearlyZero(Velocity.X))
+    {
+        float Radius, HalfHeight;
+        CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(Radius, HalfHeight);
+        
+        const FVector Start = UpdatedComponent->GetComponentLocation() + FVector(FMath::Sign(Velocity.X) * Radius, 0.0f, 0.0f);
+        const FVector End = Start - FVector(0.0f, 0.0f, HalfHeight + MaxStepHeight);
+        
+        FHitResult EdgeHit;
+        FCollisionQueryParams Params(SCENE_QUERY_STAT(PlatformerWalkerEdge), false, CharacterOwner);
+        IsAtEdge = !GetWorld()->LineTraceSingleByChannel(EdgeHit, Start, End, UpdatedComponent->GetCollisionObjectType(), Params);
+    }
+}
+
+void UPlatformerWalkerMovement::PhysFalling(float DeltaTime, int32 Iterations)
+{
+    if (!UseKinematicWalking)
+    {
+        Super::PhysFalling(DeltaTime, Iterations);
+        return;
+    }
+    
+    SCOPE_CYCLE_COUNTER(STAT_PlatformerWalkerMovement);
+    
+    if (DeltaTime < MIN_TICK_TIME || !CharacterOwner || !UpdatedComponent) return;
+    
+    HasKnownFloor = false;
+    
+    // Apply gravity up to the terminal velocity
+    Velocity.Y = 0.0f;
+    Velocity.Z = FMath::Max(Velocity.Z + GetGravityZ() * DeltaTime, -GetPhysicsVolume()->TerminalVelocity);
+    
+    FHitResult Hit;
+    SafeMoveUpdatedComponent(Velocity * DeltaTime, UpdatedComponent->GetComponentQuat(), true, Hit);
+    
+    if (Hit.IsValidBlockingHit())
+    {
+        if (Velocity.Z <= 0.0f && IsWalkable(Hit))
+        {
+            // Landed, let the character movement switch back to walking and notify the character
+            HasKnownFloor = true;
+            ProcessLanded(Hit, 0.0f, Iterations);
+            return;
+        }
+        
+        // Hit a wall or a ceiling, keep falling along it
+        Velocity = FVector::VectorPlaneProject(Velocity, Hit.Normal);
+        IsAgainstWall = Hit.Normal.Z < GetWalkableFloorZ();
+    }
+}
+
+bool UPlatformerWalkerMovement::SnapToFloor()
+{
+    float Radius, HalfHeight;
+    CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(Radius, HalfHeight);
+    
+    const FVector Start = UpdatedComponent->GetComponentLocation();
+    const FVector End = Start - FVector(0.0f, 0.0f, FloorProbeDistance + MaxStepHeight);
+    
+    FHitResult Hit;
+    FCollisionQueryParams Params(SCENE_QUERY_STAT(PlatformerWalkerFloor), false, CharacterOwner);
+    FCollisionResponseParams ResponseParams;
+    InitCollisionParams(Params, ResponseParams);
+    
+    const bool FoundFloor = GetWorld()->SweepSingleByChannel(Hit, Start, End, UpdatedComponent->GetComponentQuat(), UpdatedComponent->GetCollisionObjectType(),
+                                                            FCollisionShape::MakeCapsule(Radius, HalfHeight), Params, ResponseParams);
+    
+    if (!FoundFloor || !IsWalkable(Hit))
+    {
+        return false;
+    }
+    
+    // Stay on top of the floor, keeping the same small gap the character movement keeps
+    const float FloorDistance = Start.Z - Hit.Location.Z;
+    if (FloorDistance > MAX_FLOOR_DIST)
+    {
+        UpdatedComponent->MoveComponent(FVector(0.0f, 0.0f, MIN_FLOOR_DIST - FloorDistance), UpdatedComponent->GetComponentQuat(), false);
+    }
+    
+    HasKnownFloor = true;
+    return true;
+}
@@ -3,15 +3,29 @@
 
 #include "PlayerCharacter.h"
 
+#include "CombatSubsystem.h"
+#include "CheckpointSubsystem.h"
+#include "FixedStepSubsystem.h"
+#include "InputLatencySubsystem.h"
 #include "Enemy.h"
+#include "CrustyPirate.h"
 
 #include "Kismet/GameplayStatics.h"
 
 #include "GameFramework/CharacterMovementComponent.h"
 
+DECLARE_CYCLE_STAT(TEXT("Player Attack Overlap"), STAT_PlayerAttackOverlap, STATGROUP_CrustyPirate);
+DECLARE_CYCLE_STAT(TEXT("Player TakeHit"), STAT_PlayerTakeHit, STATGROUP_CrustyPirate);
+DECLARE_CYCLE_STAT(TEXT("Player Stun"), STAT_PlayerStun, STATGROUP_CrustyPirate);
+DECLARE_CYCLE_STAT(TEXT("Collect Item"), STAT_CollectItem, STATGROUP_CrustyPirate);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pickups"), STAT_Pickups, STATGROUP_CrustyPirate);
+
 APlayerCharacter::APlayerCharacter()
 {
-    PrimaryActorTick.bCanEverTick = true;
+    LLM_SCOPE_BYTAG(CrustyPirate_Player);
+    
+    // Nothing to do every frame, the components still tick
+    PrimaryActorTick.bCanEverTick = false;
     
     SpringArm = CreateDefaultSubobject<USpringArmComponent>(TEXT("SpringArm"));
     // Note that the RootComponent is already set up for us since we inherit from APaperZDCharacter
@@ -29,6 +43,14 @@ void APlayerCharacter::BeginPlay()
 {
     Super::BeginPlay();
     
+    LLM_SCOPE_BYTAG(CrustyPirate_Player);
+    
+    // Step the movement and animation in fixed steps when they are on
+    if (UFixedStepSubsystem* FixedStep = GetWorld()->GetSubsystem<UFixedStepSubsystem>())
+    {
+        FixedStep->RegisterCharacter(this);
+    }
+    
     // Add Input Mapping Context to the player
     if (APlayerController* PlayerController = Cast<APlayerController>(Controller))
     {
@@ -41,8 +63,16 @@ void APlayerCharacter::BeginPlay()
     // Binding the attack animation end delegate (signal) to OnAttackOverrideAnimEnd()
     OnAttackOverrideEndDelegate.BindUObject(this, &APlayerCharacter::OnAttackOverrideAnimEnd);
     
-    // Binding the collision box's OnComponentBeginOverlap event to AttackBoxOverlapBegin()
-    AttackCollisionBox->OnComponentBeginOverlap.AddDynamic(this, &APlayerCharacter::AttackBoxOverlapBegin);
+    if (!UseAttackSweep)
+    {
+        // Binding the collision box's OnComponentBeginOverlap event to AttackBoxOverlapBegin()
+        AttackCollisionBox->OnComponentBeginOverlap.AddDynamic(this, &APlayerCharacter::AttackBoxOverlapBegin);
+    }
+    else
+    {
+        // The box is only used as the shape of the attack sweeps and never collides itself
+        AttackCollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    }
     
     // Disbale the collision box at first
     EnableAttackCollisionBox(false);
@@ -59,9 +89,24 @@ void APlayerCharacter::BeginPlay()
         }
     }
     
+    // Create the audio components of the pickup sound up front
+    if (ItemPickupSound)
+    {
+        for (int Index = 0; Index < PickupSoundPoolSize; Index++)
+        {
+            UAudioComponent* PickupSound = UGameplayStatics::CreateSound2D(this, ItemPickupSound, 1.0f, 1.0f, 0.0f, nullptr, false, false);
+            if (PickupSound)
+            {
+                PickupSoundPool.Add(PickupSound);
+            }
+        }
+    }
+    
     // Create the HUD Widget
     if (PlayerHUDClass)
     {
+        LLM_SCOPE_BYTAG(CrustyPirate_HUD);
+        
         // Create a widget of class PlayerHUDClass
         PlayerHUDWidget = CreateWidget<UPlayerHUD>(UGameplayStatics::GetPlayerController(GetWorld(), 0), PlayerHUDClass);
         
@@ -79,11 +124,6 @@ void APlayerCharacter::BeginPlay()
     }
 }
 
-void APlayerCharacter::Tick(float DeltaTime)
-{
-    Super::Tick(DeltaTime);
-}
-
 void APlayerCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 {
     Super::SetupPlayerInputComponent(PlayerInputComponent);
@@ -113,6 +153,11 @@ void APlayerCharacter::Move(const FInputActionValue& Value)
     
     if (IsAlive && CanMove && !IsStunned)
     {
+        if (UInputLatencySubsystem* InputLatency = GetWorld()->GetSubsystem<UInputLatencySubsystem>())
+        {
+            InputLatency->InputReceived(this, EInputLatencyAction::Move, MoveActionValue);
+        }
+        
         FVector Direction = FVector(1.0f, 0.0f, 0.0f);
         AddMovementInput(Direction, MoveActionValue);
         
@@ -149,10 +194,27 @@ void APlayerCharacter::JumpStarted(const FInputActionValue& Value)
 {
     if (IsAlive && CanMove && !IsStunned)
     {
+        // Only time the jumps that can happen (not the presses past the last double jump)
+        UInputLatencySubsystem* InputLatency = GetWorld()->GetSubsystem<UInputLatencySubsystem>();
+        if (InputLatency && CanJump())
+        {
+            InputLatency->InputReceived(this, EInputLatencyAction::Jump);
+        }
+        
         Jump();
     }
 }
 
+void APlayerCharacter::OnJumped_Implementation()
+{
+    Super::OnJumped_Implementation();
+    
+    if (UInputLatencySubsystem* InputLatency = GetWorld()->GetSubsystem<UInputLatencySubsystem>())
+    {
+        InputLatency->EffectApplied(this, EInputLatencyAction::Jump);
+    }
+}
+
 void APlayerCharacter::JumpEnded(const FInputActionValue& Value)
 {
     StopJumping();
@@ -162,9 +224,18 @@ void APlayerCharacter::Attack(const FInputActionValue& Value)
 {
     if (IsAlive && CanAttack && !IsStunned)
     {
+        // The attack has its effect once the animation player shows the AttackAnimSequence (checked at the end of the frame)
+        if (UInputLatencySubsystem* InputLatency = GetWorld()->GetSubsystem<UInputLatencySubsystem>())
+        {
+            InputLatency->InputReceived(this, EInputLatencyAction::Attack);
+            InputLatency->WaitForAnimation(this, EInputLatencyAction::Attack, AttackAnimSequence);
+        }
+        
         CanAttack = false;
         CanMove = false;
         
+        AttackSwingId = GetWorld()->GetSubsystem<UCombatSubsystem>()->BeginSwing(this);
+        
         // Enable the collision box
         //EnableAttackCollisionBox(true);
         
@@ -185,12 +256,15 @@ void APlayerCharacter::OnAttackOverrideAnimEnd(bool Completed)
 
 void APlayerCharacter::AttackBoxOverlapBegin(UPrimitiveComponent* OverlapComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+    SCOPE_CYCLE_COUNTER(STAT_PlayerAttackOverlap);
+    
     // Check if the actor in the collision box is an enemy actor
     AEnemy* Enemy = Cast<AEnemy>(OtherActor);
     
     if (Enemy)
     {
-        Enemy->TakeHit(AttackDamage, AttackStunDuration);
+        // The hit is applied by the combat subsystem at the end of the frame
+        GetWorld()->GetSubsystem<UCombatSubsystem>()->QueueHit(this, Enemy, AttackSwingId, AttackDamage, AttackStunDuration);
     }
     
     
@@ -198,6 +272,23 @@ void APlayerCharacter::AttackBoxOverlapBegin(UPrimitiveComponent* OverlapCompone
 
 void APlayerCharacter::EnableAttackCollisionBox(bool Enabled)
 {
+    if (UseAttackSweep)
+    {
+        // The collision of the box stays disabled, the combat subsystem sweeps it while the attack window is open
+        if (UCombatSubsystem* Combat = GetWorld()->GetSubsystem<UCombatSubsystem>())
+        {
+            if (Enabled)
+            {
+                Combat->OpenAttackWindow(this, AttackCollisionBox, AEnemy::StaticClass(), AttackSwingId, AttackDamage, AttackStunDuration);
+            }
+            else
+            {
+                Combat->CloseAttackWindow(this);
+            }
+        }
+        return;
+    }
+    
     if (Enabled)
     {
         // Enable the collision box
@@ -216,6 +307,8 @@ void APlayerCharacter::EnableAttackCollisionBox(bool Enabled)
 
 void APlayerCharacter::TakeHit(int DamageAmount, float StunDuration)
 {
+    SCOPE_CYCLE_COUNTER(STAT_PlayerTakeHit);
+    
     if (!IsAlive) return;
     if (!IsActive) return;
     
@@ -240,7 +333,7 @@ void APlayerCharacter::TakeHit(int DamageAmount, float StunDuration)
         
         // Restart the game
         float RestartDelay = 3.0f;
-        GetWorldTimerManager().SetTimer(RestartTimer, this, &APlayerCharacter::OnRestartTimerTimeout, 1.0f, false, RestartDelay);
+        GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->SetTimer(RestartTimer, this, &APlayerCharacter::OnRestartTimerTimeout, RestartDelay);
     }
     else
     {
@@ -266,16 +359,12 @@ void APlayerCharacter::UpdateHP(int NewHP)
 
 void APlayerCharacter::Stun(float DurationInSeconds)
 {
-    IsStunned = true;
+    SCOPE_CYCLE_COUNTER(STAT_PlayerStun);
     
-    // Allow the player to stun the enemy several times
-    bool IsTimerAlreadyActive = GetWorldTimerManager().IsTimerActive(StunTimer);
-    if (IsTimerAlreadyActive)
-    {
-        GetWorldTimerManager().ClearTimer(StunTimer);
-    }
+    IsStunned = true;
     
-    GetWorldTimerManager().SetTimer(StunTimer, this, &APlayerCharacter::OnStunTimerTimeout, 1.0f, false, DurationInSeconds);
+    // Allow the enemies to stun the player several times (setting the timer again moves it if it is already active)
+    GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->SetTimer(StunTimer, this, &APlayerCharacter::OnStunTimerTimeout, DurationInSeconds);
     
     // Make sure we stop any currently playing override animations while stunned (such as attack)
     GetAnimInstance()->StopAllAnimationOverrides();
@@ -292,8 +381,11 @@ void APlayerCharacter::OnStunTimerTimeout()
 
 void APlayerCharacter::CollectItem(CollectableType ItemType)
 {
+    SCOPE_CYCLE_COUNTER(STAT_CollectItem);
+    INC_DWORD_STAT(STAT_Pickups);
+    
     // Play sound
-    UGameplayStatics::PlaySound2D(GetWorld(), ItemPickupSound);
+    PlayPickupSound();
     
     switch (ItemType)
     {
@@ -331,6 +423,21 @@ void APlayerCharacter::CollectItem(CollectableType ItemType)
     }
 }
 
+void APlayerCharacter::PlayPickupSound()
+{
+    if (PickupSoundPool.Num() == 0)
+    {
+        UGameplayStatics::PlaySound2D(GetWorld(), ItemPickupSound);
+        return;
+    }
+    
+    // Use the components in turn, when they are all playing the oldest sound is restarted
+    UAudioComponent* PickupSound = PickupSoundPool[NextPickupSound];
+    NextPickupSound = (NextPickupSound + 1) % PickupSoundPool.Num();
+    
+    PickupSound->Play();
+}
+
 void APlayerCharacter::UnlockDoubleJump()
 {
     // Allow double jump by setting the built-in variable JumpMaxCount to 2
@@ -340,9 +447,44 @@ void APlayerCharacter::UnlockDoubleJump()
 
 void APlayerCharacter::OnRestartTimerTimeout()
 {
+    // Go back to the last checkpoint in place, the game is only restarted when no checkpoint was reached
+    UCheckpointSubsystem* Checkpoints = GetWorld()->GetSubsystem<UCheckpointSubsystem>();
+    if (Checkpoints && Checkpoints->RestoreSnapshot(this))
+    {
+        return;
+    }
+    
     MyGameInstance->RestartGame();
 }
 
+void APlayerCharacter::Respawn(const FVector& Location, int NewHP)
+{
+    UGameplayTimerSubsystem* Timers = GetWorld()->GetSubsystem<UGameplayTimerSubsystem>();
+    Timers->ClearTimer(RestartTimer);
+    Timers->ClearTimer(StunTimer);
+    
+    SetActorLocation(Location, false, nullptr, ETeleportType::ResetPhysics);
+    GetCharacterMovement()->StopMovementImmediately();
+    
+    IsAlive = true;
+    IsActive = true;
+    IsStunned = false;
+    CanMove = true;
+    CanAttack = true;
+    
+    EnableAttackCollisionBox(false);
+    
+    // The CaptainStateMachine has no jump node to idle. Its take hit state goes back to idle once the short hit
+    // animation has played, so jumping there leaves the die state with the anim instance the player already has
+    GetAnimInstance()->StopAllAnimationOverrides();
+    GetAnimInstance()->JumpToNode(FName("JumpTakeHit"), FName("CaptainStateMachine"));
+    
+    JumpMaxCount = MyGameInstance->IsDoubleJumpUnlocked ? 2 : 1;
+    
+    UpdateHP(NewHP);
+    PlayerHUDWidget->SetDiamond(MyGameInstance->CollectedDiamondCount);
+}
+
 void APlayerCharacter::Deactivate()
 {
     if (IsActive)
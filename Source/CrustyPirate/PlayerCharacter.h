@@ -18,9 +18,10 @@
 
 #include "Components/BoxComponent.h"
 
-#include "Engine/TimerHandle.h"
+#include "GameplayTimerSubsystem.h"
 
 #include "Sound/SoundBase.h"
+#include "Components/AudioComponent.h"
 
 #include "PlayerHUD.h"
 #include "CollectableItem.h"
@@ -77,6 +78,16 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     USoundBase* ItemPickupSound;
     
+    // How many pickup sounds can play at the same time. The audio components are created in BeginPlay
+    // and reused, so picking items up does not create any
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    int PickupSoundPoolSize = 4;
+    
+    UPROPERTY()
+    TArray<UAudioComponent*> PickupSoundPool;
+    
+    int NextPickupSound = 0;
+    
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
     bool IsAlive = true;
     
@@ -101,15 +112,23 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     float AttackStunDuration = 0.3f;
     
+    // Find the enemies hit by an attack by sweeping the AttackCollisionBox every frame of the attack window (see UCombatSubsystem)
+    // instead of switching its collision on and off and waiting for overlap events
+    UPROPERTY(EditAnywhere, BlueprintReadOnly)
+    bool UseAttackSweep = false;
+    
     FZDOnAnimationOverrideEndSignature OnAttackOverrideEndDelegate;
     
-    FTimerHandle StunTimer;
-    FTimerHandle RestartTimer;
+    FGameplayTimerHandle StunTimer;
+    FGameplayTimerHandle RestartTimer;
+    
+    // Id of the current attack, the combat subsystem only lets one swing hit an enemy once
+    int AttackSwingId = 0;
     
     APlayerCharacter();
     virtual void BeginPlay() override;
-    virtual void Tick(float DeltaTime) override;
     virtual void SetupPlayerInputComponent(UInputComponent* PlayerInputComponent) override;
+    virtual void OnJumped_Implementation() override;
     
     void Move(const FInputActionValue& Value);
     void JumpStarted(const FInputActionValue& Value);
@@ -134,10 +153,14 @@ public:
     void OnStunTimerTimeout();
     
     void CollectItem(CollectableType ItemType);
+    void PlayPickupSound();
     void UnlockDoubleJump();
 	
     void OnRestartTimerTimeout();
     
+    // Bring the player back to life at a checkpoint, the diamonds and double jump are read from the game instance
+    void Respawn(const FVector& Location, int NewHP);
+    
     UFUNCTION(BlueprintCallable)
     void Deactivate();
     
@@ -3,20 +3,43 @@
 
 #include "PlayerHUD.h"
 
+#include "CrustyPirate.h"
+
+DECLARE_CYCLE_STAT(TEXT("HUD Text Update"), STAT_HUDTextUpdate, STATGROUP_CrustyPirate);
+DECLARE_DWORD_COUNTER_STAT(TEXT("HUD Text Updates"), STAT_HUDTextUpdates, STATGROUP_CrustyPirate);
+
 void UPlayerHUD::SetHP(int NewHP)
 {
+    if (NewHP == DisplayedHP) return;
+    DisplayedHP = NewHP;
+    
+    SCOPE_CYCLE_COUNTER(STAT_HUDTextUpdate);
+    INC_DWORD_STAT(STAT_HUDTextUpdates);
+    
     FString str = FString::Printf(TEXT("HP: %d"), NewHP);
     HPText->SetText(FText::FromString(str));
 }
 
 void UPlayerHUD::SetDiamond(int Amount)
 {
+    if (Amount == DisplayedDiamonds) return;
+    DisplayedDiamonds = Amount;
+    
+    SCOPE_CYCLE_COUNTER(STAT_HUDTextUpdate);
+    INC_DWORD_STAT(STAT_HUDTextUpdates);
+    
     FString str = FString::Printf(TEXT("Diamonds: %d"), Amount);
     DiamondText->SetText(FText::FromString(str));
 }
 
 void UPlayerHUD::SetLevel(int Index)
 {
+    if (Index == DisplayedLevel) return;
+    DisplayedLevel = Index;
+    
+    SCOPE_CYCLE_COUNTER(STAT_HUDTextUpdate);
+    INC_DWORD_STAT(STAT_HUDTextUpdates);
+    
     FString str = FString::Printf(TEXT("Level: %d"), Index);
     LevelText->SetText(FText::FromString(str));
 }
@@ -28,8 +28,14 @@ public:
     UPROPERTY(EditAnywhere, meta = (BindWidget))
     UTextBlock* LevelText;
     
+    // The texts are only rebuilt when the value changes
     void SetHP(int NewHP);
     void SetDiamond(int Amount);
     void SetLevel(int Index);
     
+private:
+    int DisplayedHP = INDEX_NONE;
+    int DisplayedDiamonds = INDEX_NONE;
+    int DisplayedLevel = INDEX_NONE;
+    
 };
@@ -0,0 +1,233 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProgressSaveSubsystem.h"
+
+#include "PlatformFeatures.h"
+#include "SaveGameSystem.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Misc/Crc.h"
+#include "Async/Async.h"
+
+#include "CrustyPirate.h"
+#include "CrustyPirateGameInstance.h"
+#include "BenchmarkSubsystem.h"
+#include "InputReplaySubsystem.h"
+
+// "CPSV"
+static const uint32 ProgressSaveMagic = 0x56535043;
+
+// Bump when the layout of FProgress changes
+static const uint16 ProgressSaveVersion = 1;
+
+// Size of the magic, version, sequence, payload size and CRC in front of the progress
+static const int ProgressSaveHeaderSize = 18;
+
+static FAutoConsoleCommandWithWorld SaveStatsCommand(
+    TEXT("CrustyPirate.Save.Stats"),
+    TEXT("Print the last progress save and load."),
+    FConsoleCommandWithWorldDelegate::CreateStatic(&UProgressSaveSubsystem::PrintStats));
+
+bool UProgressSaveSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+    // Benchmark and input replay runs neither resume from nor overwrite the progress of the player
+    return !UBenchmarkSubsystem::IsBenchmarkRun() && !UInputReplaySubsystem::IsPlaybackRun() && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UProgressSaveSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    // The saves are tiny, reading them here has the progress ready before the first level is loaded
+    LoadProgress();
+}
+
+void UProgressSaveSubsystem::Deinitialize()
+{
+    WaitForPendingSave();
+
+    Super::Deinitialize();
+}
+
+FString UProgressSaveSubsystem::GetSlotName(uint32 Sequence)
+{
+    return (Sequence % 2) == 0 ? TEXT("Progress_A") : TEXT("Progress_B");
+}
+
+void UProgressSaveSubsystem::WriteSave(TArray<uint8>& Data, uint32 Sequence, const FProgress& Progress)
+{
+    TArray<uint8> Payload;
+    FMemoryWriter PayloadWriter(Payload);
+    FProgress Copy = Progress;
+    PayloadWriter << Copy.PlayerHP << Copy.CollectedDiamondCount << Copy.IsDoubleJumpUnlocked << Copy.CurrentLevelIndex;
+
+    uint32 Magic = ProgressSaveMagic;
+    uint16 Version = ProgressSaveVersion;
+    uint32 PayloadSize = Payload.Num();
+    uint32 Crc = FCrc::MemCrc32(Payload.GetData(), Payload.Num());
+
+    Data.Reset(ProgressSaveHeaderSize + Payload.Num());
+    FMemoryWriter Writer(Data);
+    Writer << Magic << Version << Sequence << PayloadSize << Crc;
+    Writer.Serialize(Payload.GetData(), Payload.Num());
+}
+
+bool UProgressSaveSubsystem::ReadSave(const TArray<uint8>& Data, uint32& OutSequence, FProgress& OutProgress)
+{
+    if (Data.Num() < ProgressSaveHeaderSize) return false;
+
+    FMemoryReader Reader(Data);
+
+    uint32 Magic = 0;
+    uint16 Version = 0;
+    uint32 PayloadSize = 0;
+    uint32 Crc = 0;
+    Reader << Magic << Version << OutSequence << PayloadSize << Crc;
+
+    if (Magic != ProgressSaveMagic || Version != ProgressSaveVersion) return false;
+    if (PayloadSize != (uint32)(Data.Num() - ProgressSaveHeaderSize)) return false;
+
+    // A slot that was only partly written does not match its CRC
+    if (FCrc::MemCrc32(Data.GetData() + ProgressSaveHeaderSize, PayloadSize) != Crc) return false;
+
+    Reader << OutProgress.PlayerHP << OutProgress.CollectedDiamondCount << OutProgress.IsDoubleJumpUnlocked << OutProgress.CurrentLevelIndex;
+
+    return !Reader.IsError();
+}
+
+uint32 UProgressSaveSubsystem::SaveProgress()
+{
+    UCrustyPirateGameInstance* MyGameInstance = Cast<UCrustyPirateGameInstance>(GetGameInstance());
+    ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+    if (!MyGameInstance || !SaveSystem) return 0;
+
+    FProgress Progress;
+    Progress.PlayerHP = MyGameInstance->PlayerHP;
+    Progress.CollectedDiamondCount = MyGameInstance->CollectedDiamondCount;
+    Progress.IsDoubleJumpUnlocked = MyGameInstance->IsDoubleJumpUnlocked ? 1 : 0;
+    Progress.CurrentLevelIndex = MyGameInstance->CurrentLevelIndex;
+
+    const uint32 Sequence = NextSequence++;
+
+    // Build the buffer here so the task does not touch the game instance
+    TArray<uint8> Data;
+    WriteSave(Data, Sequence, Progress);
+
+    SaveCount++;
+    LastSaveSize = Data.Num();
+
+    // Write the slot that does not hold the latest save
+    SaveTask = UE::Tasks::Launch(UE_SOURCE_LOCATION,
+        [this, SaveSystem, Sequence, SlotName = GetSlotName(Sequence), Data = MoveTemp(Data)]()
+        {
+            const bool IsSaved = SaveSystem->SaveGame(false, *SlotName, 0, Data);
+            if (!IsSaved)
+            {
+                FailedSaveCount++;
+                UE_LOG(LogCrustyPirate, Warning, TEXT("Could not write the progress save slot %s"), *SlotName);
+            }
+
+            // The subsystem may be gone by the time the game thread runs this
+            AsyncTask(ENamedThreads::GameThread, [WeakThis = TWeakObjectPtr<UProgressSaveSubsystem>(this), Sequence, IsSaved]()
+            {
+                if (UProgressSaveSubsystem* Saves = WeakThis.Get())
+                {
+                    Saves->OnProgressSaved.Broadcast(Sequence, IsSaved);
+                }
+            });
+        },
+        UE::Tasks::Prerequisites(SaveTask));
+
+    return Sequence;
+}
+
+bool UProgressSaveSubsystem::LoadProgress()
+{
+    ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+    if (!SaveSystem) return false;
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    WaitForPendingSave();
+
+    bool HasProgress = false;
+    uint32 LatestSequence = 0;
+    FProgress LatestProgress;
+
+    for (uint32 Slot = 0; Slot < 2; Slot++)
+    {
+        const FString SlotName = GetSlotName(Slot);
+
+        TArray<uint8> Data;
+        if (!SaveSystem->DoesSaveGameExist(*SlotName, 0) || !SaveSystem->LoadGame(false, *SlotName, 0, Data)) continue;
+
+        uint32 Sequence = 0;
+        FProgress Progress;
+        if (!ReadSave(Data, Sequence, Progress))
+        {
+            UE_LOG(LogCrustyPirate, Warning, TEXT("Progress save slot %s is corrupted, it is ignored"), *SlotName);
+            continue;
+        }
+
+        if (!HasProgress || Sequence > LatestSequence)
+        {
+            HasProgress = true;
+            LatestSequence = Sequence;
+            LatestProgress = Progress;
+        }
+    }
+
+    LastLoadTime = FPlatformTime::Seconds() - StartTime;
+
+    if (!HasProgress) return false;
+
+    LoadedProgress = LatestProgress;
+    NextSequence = LatestSequence + 1;
+    IsProgressLoaded = true;
+    return true;
+}
+
+bool UProgressSaveSubsystem::ApplyLoadedProgress()
+{
+    UCrustyPirateGameInstance* MyGameInstance = Cast<UCrustyPirateGameInstance>(GetGameInstance());
+    if (!MyGameInstance || !IsProgressLoaded) return false;
+
+    // A save from a build with more levels, or one whose level was renamed
+    if (!UCrustyPirateGameInstance::DoesLevelExist(LoadedProgress.CurrentLevelIndex))
+    {
+        UE_LOG(LogCrustyPirate, Warning, TEXT("Progress save is in Level_%d, which does not exist, it is ignored"), LoadedProgress.CurrentLevelIndex);
+        return false;
+    }
+
+    MyGameInstance->PlayerHP = LoadedProgress.PlayerHP;
+    MyGameInstance->CollectedDiamondCount = LoadedProgress.CollectedDiamondCount;
+    MyGameInstance->IsDoubleJumpUnlocked = LoadedProgress.IsDoubleJumpUnlocked != 0;
+    MyGameInstance->CurrentLevelIndex = LoadedProgress.CurrentLevelIndex;
+
+    IsProgressApplied = true;
+    return true;
+}
+
+void UProgressSaveSubsystem::WaitForPendingSave()
+{
+    if (SaveTask.IsValid())
+    {
+        SaveTask.Wait();
+    }
+}
+
+void UProgressSaveSubsystem::PrintStats(UWorld* World)
+{
+    const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+    const UProgressSaveSubsystem* Saves = GameInstance ? GameInstance->GetSubsystem<UProgressSaveSubsystem>() : nullptr;
+    if (!Saves) return;
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Progress save: %d saves of %d bytes (%d failed), next slot %s, %s in %.3f ms"),
+           Saves->SaveCount,
+           Saves->LastSaveSize,
+           Saves->FailedSaveCount.load(),
+           *GetSlotName(Saves->NextSequence),
+           Saves->IsProgressApplied ? TEXT("progress loaded and resumed") : Saves->IsProgressLoaded ? TEXT("progress loaded but not resumed") : TEXT("no progress loaded"),
+           Saves->LastLoadTime * 1000.0);
+}
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tasks/Task.h"
+
+#include "ProgressSaveSubsystem.generated.h"
+
+// The sequence number of the save and whether it was written
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnProgressSaved, uint32 /* Sequence */, bool /* IsSaved */);
+
+/**
+ * Saves the progress kept by UCrustyPirateGameInstance (HP, diamonds, double jump and level) to disk.
+ * The save is a small binary buffer with a magic number, a version, a sequence number and a CRC of the progress.
+ * It is built on the game thread and written by a background task, alternating between two slots so
+ * that a crash while writing one slot leaves the previous save intact in the other one.
+ * When the game instance starts, both slots are read and the valid one with the highest sequence is kept. The game
+ * instance only applies it when it resumes the game from the saved level (see ApplyLoadedProgress).
+ * OnProgressSaved is broadcast on the game thread once a background write finished or failed.
+ * "CrustyPirate.Save.Stats" prints the last save and load.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UProgressSaveSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    // Write the progress of the game instance in the background (writes are done in the order they were requested).
+    // Returns the sequence number passed to OnProgressSaved, 0 when nothing is written
+    uint32 SaveProgress();
+
+    // Read the latest valid save, without changing the game instance. Returns false when there is none
+    bool LoadProgress();
+
+    // Copy the loaded progress into the game instance. Returns false when there is none or its level does not exist
+    bool ApplyLoadedProgress();
+
+    // Block until the writes in flight are done
+    void WaitForPendingSave();
+
+    bool HasLoadedProgress() const { return IsProgressLoaded; }
+
+    FOnProgressSaved OnProgressSaved;
+
+    static void PrintStats(UWorld* World);
+
+private:
+    struct FProgress
+    {
+        int32 PlayerHP = 100;
+        int32 CollectedDiamondCount = 0;
+        uint8 IsDoubleJumpUnlocked = 0;
+        int32 CurrentLevelIndex = 1;
+    };
+
+    static FString GetSlotName(uint32 Sequence);
+
+    static void WriteSave(TArray<uint8>& Data, uint32 Sequence, const FProgress& Progress);
+
+    // Returns false when the data is not a valid save of this version
+    static bool ReadSave(const TArray<uint8>& Data, uint32& OutSequence, FProgress& OutProgress);
+
+    // The last write task, the next one waits for it so the slots are written in order
+    UE::Tasks::FTask SaveTask;
+
+    // Sequence number of the next save, it also picks the slot
+    uint32 NextSequence = 1;
+
+    bool IsProgressLoaded = false;
+    bool IsProgressApplied = false;
+
+    // The latest valid save read by LoadProgress
+    FProgress LoadedProgress;
+
+    int SaveCount = 0;
+    int LastSaveSize = 0;
+    double LastLoadTime = 0.0;
+    std::atomic<int> FailedSaveCount = 0;
+};
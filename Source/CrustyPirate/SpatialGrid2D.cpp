@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpatialGrid2D.h"
+
+void FSpatialGrid2D::Reset(float InCellSize)
+{
+    CellSize = FMath::Max(InCellSize, 1.0f);
+    Cells.Reset();
+    ItemCells.Reset();
+    ItemInGrid.Reset();
+}
+
+bool FSpatialGrid2D::Contains(int Id) const
+{
+    return ItemInGrid.IsValidIndex(Id) && ItemInGrid[Id];
+}
+
+void FSpatialGrid2D::Add(int Id, const FVector2D& Position)
+{
+    if (Contains(Id)) return;
+
+    if (Id >= ItemCells.Num())
+    {
+        ItemCells.SetNum(Id + 1);
+        ItemInGrid.Add(false, Id + 1 - ItemInGrid.Num());
+    }
+
+    const FIntPoint Cell = GetCell(Position);
+    Cells.FindOrAdd(Cell).Add(Id);
+    ItemCells[Id] = Cell;
+    ItemInGrid[Id] = true;
+}
+
+void FSpatialGrid2D::Remove(int Id)
+{
+    if (!Contains(Id)) return;
+
+    if (TArray<int>* Bucket = Cells.Find(ItemCells[Id]))
+    {
+        Bucket->RemoveSingleSwap(Id);
+        if (Bucket->Num() == 0)
+        {
+            Cells.Remove(ItemCells[Id]);
+        }
+    }
+
+    ItemInGrid[Id] = false;
+}
+
+void FSpatialGrid2D::Move(int Id, const FVector2D& Position)
+{
+    if (!Contains(Id)) return;
+
+    // Only touch the buckets when the item enters a new cell
+    const FIntPoint Cell = GetCell(Position);
+    if (Cell != ItemCells[Id])
+    {
+        Remove(Id);
+        Add(Id, Position);
+    }
+}
+
+void FSpatialGrid2D::ChangeId(int OldId, int NewId)
+{
+    if (OldId == NewId || !Contains(OldId)) return;
+
+    const FIntPoint Cell = ItemCells[OldId];
+    Remove(OldId);
+
+    if (NewId >= ItemCells.Num())
+    {
+        ItemCells.SetNum(NewId + 1);
+        ItemInGrid.Add(false, NewId + 1 - ItemInGrid.Num());
+    }
+
+    Cells.FindOrAdd(Cell).Add(NewId);
+    ItemCells[NewId] = Cell;
+    ItemInGrid[NewId] = true;
+}
+
+void FSpatialGrid2D::Query(const FVector2D& Center, float Radius, TArray<int>& OutIds) const
+{
+    const FIntPoint MinCell = GetCell(Center - FVector2D(Radius, Radius));
+    const FIntPoint MaxCell = GetCell(Center + FVector2D(Radius, Radius));
+
+    for (int CellX = MinCell.X; CellX <= MaxCell.X; CellX++)
+    {
+        for (int CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++)
+        {
+            if (const TArray<int>* Bucket = Cells.Find(FIntPoint(CellX, CellY)))
+            {
+                OutIds.Append(*Bucket);
+            }
+        }
+    }
+}
+
+FIntPoint FSpatialGrid2D::GetCell(const FVector2D& Position) const
+{
+    return FIntPoint(FMath::FloorToInt32(Position.X / CellSize), FMath::FloorToInt32(Position.Y / CellSize));
+}
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Uniform 2D grid over the X/Z plane used to find the items close to a point without physics overlaps.
+ * Items are identified by a small integer id (the enemy subsystem uses the simulation index of the enemy,
+ * ACollectableField the index of the item).
+ * Moving an item only touches the grid when it crosses into another cell, and a query only visits the
+ * cells covered by the query radius, so its cost does not depend on the total number of items.
+ */
+class CRUSTYPIRATE_API FSpatialGrid2D
+{
+public:
+    // Remove every item and change the size of the cells
+    void Reset(float InCellSize);
+
+    float GetCellSize() const { return CellSize; }
+
+    bool Contains(int Id) const;
+
+    void Add(int Id, const FVector2D& Position);
+    void Remove(int Id);
+    void Move(int Id, const FVector2D& Position);
+
+    // Give an item a new id (used when the owner of the ids compacts its arrays)
+    void ChangeId(int OldId, int NewId);
+
+    // Append the ids of all the items in the cells overlapping the given circle (candidates still need a distance check)
+    void Query(const FVector2D& Center, float Radius, TArray<int>& OutIds) const;
+
+private:
+    FIntPoint GetCell(const FVector2D& Position) const;
+
+    float CellSize = 100.0f;
+
+    TMap<FIntPoint, TArray<int>> Cells;
+
+    // The cell of every item, indexed by id
+    TArray<FIntPoint> ItemCells;
+    TBitArray<> ItemInGrid;
+};
@@ -0,0 +1,248 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TickLODSubsystem.h"
+
+#include "Kismet/GameplayStatics.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/GameViewportClient.h"
+
+#include "CrustyPirate.h"
+#include "Enemy.h"
+
+static TAutoConsoleVariable<bool> CVarTickLODEnable(
+    TEXT("CrustyPirate.TickLOD.Enable"),
+    true,
+    TEXT("Lower the tick rate of gameplay actors away from the camera view."));
+
+static TAutoConsoleVariable<float> CVarTickLODReducedDistance(
+    TEXT("CrustyPirate.TickLOD.ReducedDistance"),
+    800.0f,
+    TEXT("Actors up to this distance outside the camera view tick at a reduced rate, further ones sleep."));
+
+static TAutoConsoleVariable<float> CVarTickLODReducedInterval(
+    TEXT("CrustyPirate.TickLOD.ReducedInterval"),
+    0.1f,
+    TEXT("Tick interval (in seconds) of the actors in the reduced tier."));
+
+static TAutoConsoleVariable<float> CVarTickLODEvaluationInterval(
+    TEXT("CrustyPirate.TickLOD.EvaluationInterval"),
+    0.2f,
+    TEXT("How often (in seconds) the tiers of the actors are updated."));
+
+static TAutoConsoleVariable<float> CVarTickLODWakeTime(
+    TEXT("CrustyPirate.TickLOD.WakeTime"),
+    2.0f,
+    TEXT("How long (in seconds) a woken up actor keeps ticking every frame."));
+
+static FAutoConsoleCommandWithWorld TickLODStatsCommand(
+    TEXT("CrustyPirate.TickLOD.Stats"),
+    TEXT("Print how many actors are in each tick LOD tier."),
+    FConsoleCommandWithWorldDelegate::CreateStatic(&UTickLODSubsystem::PrintStats));
+
+void UTickLODSubsystem::RegisterActor(AActor* Actor)
+{
+    if (!Actor || ActorIndices.Contains(Actor)) return;
+
+    TArray<TWeakObjectPtr<UActorComponent>> Components;
+    for (UActorComponent* Component : Actor->GetComponents())
+    {
+        if (Component && Component->IsComponentTickEnabled())
+        {
+            Components.Add(Component);
+        }
+    }
+
+    const int Index = Actors.Add(Actor);
+    TickingComponents.Add(MoveTemp(Components));
+    Tiers.Add(ETickLODTier::Full);
+    WakeTimeLeft.Add(0.0f);
+    ActorIndices.Add(Actor, Index);
+}
+
+void UTickLODSubsystem::UnregisterActor(AActor* Actor)
+{
+    int Index;
+    if (!ActorIndices.RemoveAndCopyValue(Actor, Index)) return;
+
+    // Give the components their full tick rate back in case the actor stays around (e.g. in the enemy pool)
+    SetTier(Index, ETickLODTier::Full);
+
+    // Move the last actor into the freed slot so the arrays stay contiguous
+    Actors.RemoveAtSwap(Index);
+    TickingComponents.RemoveAtSwap(Index);
+    Tiers.RemoveAtSwap(Index);
+    WakeTimeLeft.RemoveAtSwap(Index);
+
+    if (Actors.IsValidIndex(Index))
+    {
+        ActorIndices.Add(Actors[Index], Index);
+    }
+}
+
+void UTickLODSubsystem::WakeActor(AActor* Actor)
+{
+    const int* Index = ActorIndices.Find(Actor);
+    if (!Index) return;
+
+    WakeTimeLeft[*Index] = CVarTickLODWakeTime.GetValueOnGameThread();
+    SetTier(*Index, ETickLODTier::Full);
+}
+
+ETickLODTier UTickLODSubsystem::GetActorTier(AActor* Actor) const
+{
+    const int* Index = ActorIndices.Find(Actor);
+    return Index ? Tiers[*Index] : ETickLODTier::Full;
+}
+
+float UTickLODSubsystem::GetReducedInterval()
+{
+    return CVarTickLODReducedInterval.GetValueOnGameThread();
+}
+
+int UTickLODSubsystem::GetNumActorsInTier(ETickLODTier Tier) const
+{
+    int Count = 0;
+    for (ETickLODTier ActorTier : Tiers)
+    {
+        if (ActorTier == Tier)
+        {
+            Count++;
+        }
+    }
+    return Count;
+}
+
+void UTickLODSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    for (float& TimeLeft : WakeTimeLeft)
+    {
+        TimeLeft -= DeltaTime;
+    }
+
+    TimeToNextEvaluation -= DeltaTime;
+    if (TimeToNextEvaluation > 0.0f) return;
+    TimeToNextEvaluation = CVarTickLODEvaluationInterval.GetValueOnGameThread();
+
+    FVector2D ViewCenter, ViewHalfSize;
+    if (!CVarTickLODEnable.GetValueOnGameThread() || !GetViewArea(ViewCenter, ViewHalfSize))
+    {
+        // Everything ticks every frame
+        for (int Index = 0; Index < Actors.Num(); Index++)
+        {
+            SetTier(Index, ETickLODTier::Full);
+        }
+        return;
+    }
+
+    const float ReducedDistance = CVarTickLODReducedDistance.GetValueOnGameThread();
+
+    for (int Index = 0; Index < Actors.Num(); Index++)
+    {
+        AActor* Actor = Actors[Index];
+        if (!Actor) continue;
+
+        // Enemies chasing the player are engaged and keep ticking every frame
+        const AEnemy* Enemy = Cast<AEnemy>(Actor);
+        if (WakeTimeLeft[Index] > 0.0f || (Enemy && Enemy->FollowTarget))
+        {
+            SetTier(Index, ETickLODTier::Full);
+            continue;
+        }
+
+        // Distance from the actor to the edge of the camera view (0 when on screen)
+        const FVector Location = Actor->GetActorLocation();
+        const float DistanceX = FMath::Max(FMath::Abs(Location.X - ViewCenter.X) - ViewHalfSize.X, 0.0f);
+        const float DistanceZ = FMath::Max(FMath::Abs(Location.Z - ViewCenter.Y) - ViewHalfSize.Y, 0.0f);
+        const float DistanceToView = FMath::Max(DistanceX, DistanceZ);
+
+        if (DistanceToView <= 0.0f)
+        {
+            SetTier(Index, ETickLODTier::Full);
+        }
+        else if (DistanceToView <= ReducedDistance)
+        {
+            SetTier(Index, ETickLODTier::Reduced);
+        }
+        else
+        {
+            SetTier(Index, ETickLODTier::Asleep);
+        }
+    }
+}
+
+void UTickLODSubsystem::SetTier(int Index, ETickLODTier Tier)
+{
+    if (Tiers[Index] == Tier) return;
+    Tiers[Index] = Tier;
+
+    const bool TickEnabled = Tier != ETickLODTier::Asleep;
+    const float TickInterval = Tier == ETickLODTier::Reduced ? GetReducedInterval() : 0.0f;
+
+    for (const TWeakObjectPtr<UActorComponent>& Component : TickingComponents[Index])
+    {
+        if (Component.IsValid())
+        {
+            Component->SetComponentTickInterval(TickInterval);
+            Component->SetComponentTickEnabled(TickEnabled);
+        }
+    }
+}
+
+bool UTickLODSubsystem::GetViewArea(FVector2D& OutCenter, FVector2D& OutHalfSize) const
+{
+    APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(GetWorld(), 0);
+    if (!CameraManager) return false;
+
+    const FVector CameraLocation = CameraManager->GetCameraLocation();
+    OutCenter = FVector2D(CameraLocation.X, CameraLocation.Z);
+
+    // The gameplay happens on the Y = 0 plane, the camera looks at it from the side
+    float HalfWidth;
+    if (CameraManager->IsOrthographic())
+    {
+        HalfWidth = CameraManager->GetOrthoWidth() * 0.5f;
+    }
+    else
+    {
+        HalfWidth = FMath::Abs(CameraLocation.Y) * FMath::Tan(FMath::DegreesToRadians(CameraManager->GetFOVAngle() * 0.5f));
+    }
+
+    float AspectRatio = 16.0f / 9.0f;
+    if (const UGameViewportClient* Viewport = GetWorld()->GetGameViewport())
+    {
+        FVector2D ViewportSize;
+        Viewport->GetViewportSize(ViewportSize);
+        if (ViewportSize.Y > 0.0f)
+        {
+            AspectRatio = ViewportSize.X / ViewportSize.Y;
+        }
+    }
+
+    OutHalfSize = FVector2D(HalfWidth, HalfWidth / AspectRatio);
+    return true;
+}
+
+void UTickLODSubsystem::PrintStats(UWorld* World)
+{
+    const UTickLODSubsystem* TickLOD = World ? World->GetSubsystem<UTickLODSubsystem>() : nullptr;
+    if (!TickLOD) return;
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Tick LOD: %d actors, %d full, %d reduced, %d asleep"),
+           TickLOD->Actors.Num(),
+           TickLOD->GetNumActorsInTier(ETickLODTier::Full),
+           TickLOD->GetNumActorsInTier(ETickLODTier::Reduced),
+           TickLOD->GetNumActorsInTier(ETickLODTier::Asleep));
+}
+
+TStatId UTickLODSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UTickLODSubsystem, STATGROUP_Tickables);
+}
+
+bool UTickLODSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "TickLODSubsystem.generated.h"
+
+UENUM(BlueprintType)
+enum class ETickLODTier : uint8
+{
+    // On screen or engaged with the player: ticks every frame
+    Full,
+    // Close to the view: ticks at a reduced rate
+    Reduced,
+    // Far from the view: does not tick at all
+    Asleep
+};
+
+/**
+ * Lowers the tick rate of gameplay actors depending on how far they are from the camera view.
+ * Registered actors get their ticking components switched between the tiers every EvaluationInterval.
+ * Enemies chasing the player always tick every frame, and WakeActor() puts an actor back to full rate
+ * straight away (used on overlaps and damage).
+ * "CrustyPirate.TickLOD.Stats" prints how many actors are in each tier.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UTickLODSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    void RegisterActor(AActor* Actor);
+    void UnregisterActor(AActor* Actor);
+
+    // Make the actor tick every frame again right away
+    void WakeActor(AActor* Actor);
+
+    int GetNumActorsInTier(ETickLODTier Tier) const;
+
+    // Tier of a registered actor (Full for the actors that are not registered)
+    ETickLODTier GetActorTier(AActor* Actor) const;
+
+    // Tick interval of the actors in the reduced tier (CrustyPirate.TickLOD.ReducedInterval)
+    static float GetReducedInterval();
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    static void PrintStats(UWorld* World);
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+    void SetTier(int Index, ETickLODTier Tier);
+
+    // Compute the part of the world seen by the camera (center and half size in X/Z). Returns false when there is no camera
+    bool GetViewArea(FVector2D& OutCenter, FVector2D& OutHalfSize) const;
+
+    // The registered actors. Every array below is indexed the same way
+    UPROPERTY()
+    TArray<TObjectPtr<AActor>> Actors;
+
+    // The components of each actor that were ticking when it registered
+    TArray<TArray<TWeakObjectPtr<UActorComponent>>> TickingComponents;
+
+    TArray<ETickLODTier> Tiers;
+
+    // Time left before a woken up actor can drop to a lower tier
+    TArray<float> WakeTimeLeft;
+
+    TMap<AActor*, int> ActorIndices;
+
+    float TimeToNextEvaluation = 0.0f;
+};
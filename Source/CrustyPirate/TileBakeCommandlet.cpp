@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileBakeCommandlet.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "UObject/SavePackage.h"
+#include "Misc/PackageName.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+
+#include "CrustyPirate.h"
+#include "TileBakeData.h"
+
+int32 UTileBakeCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+    FString Path = TEXT("/Game/Levels");
+    FParse::Value(*Params, TEXT("Path="), Path);
+    int ChunkSize = 32;
+    FParse::Value(*Params, TEXT("ChunkSize="), ChunkSize);
+    const bool IsDryRun = FParse::Param(*Params, TEXT("DryRun"));
+
+    IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+    AssetRegistry.SearchAllAssets(true);
+
+    TArray<FAssetData> LevelAssets;
+    FARFilter Filter;
+    Filter.PackagePaths.Add(FName(*Path));
+    Filter.ClassPaths.Add(UWorld::StaticClass()->GetClassPathName());
+    Filter.bRecursivePaths = true;
+    AssetRegistry.GetAssets(Filter, LevelAssets);
+
+    int NumFailed = 0;
+
+    for (const FAssetData& Asset : LevelAssets)
+    {
+        UWorld* World = Cast<UWorld>(Asset.GetAsset());
+        if (!World || !World->PersistentLevel) continue;
+
+        const FString LevelName = Asset.AssetName.ToString();
+        const FString PackageName = UTileBakeData::GetPackageName(LevelName);
+        UPackage* Package = CreatePackage(*PackageName);
+        UTileBakeData* BakeData = NewObject<UTileBakeData>(Package, FName(*FPackageName::GetShortName(PackageName)), RF_Public | RF_Standalone);
+        BakeData->Build(World->PersistentLevel, ChunkSize);
+
+        int NumChunks = 0;
+        for (const FTileMapBake& TileMapBake : BakeData->TileMaps)
+        {
+            NumChunks += TileMapBake.Chunks.Num();
+        }
+
+        UE_LOG(LogCrustyPirate, Display, TEXT("%s: %d tiles of %d tile maps in %d chunks, %d of %d decorations batched"),
+               *LevelName,
+               BakeData->NumBakedTiles,
+               BakeData->TileMaps.Num(),
+               NumChunks,
+               BakeData->Decorations.Num(),
+               BakeData->NumDecorations);
+
+        if (IsDryRun) continue;
+
+        FAssetRegistryModule::AssetCreated(BakeData);
+        Package->MarkPackageDirty();
+
+        const FString Filename = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetAssetPackageExtension());
+        FSavePackageArgs SaveArgs;
+        SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+        if (!UPackage::SavePackage(Package, BakeData, *Filename, SaveArgs))
+        {
+            UE_LOG(LogCrustyPirate, Error, TEXT("Could not save %s"), *Filename);
+            NumFailed++;
+        }
+    }
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Tile bake: %d levels baked%s"),
+           LevelAssets.Num(),
+           IsDryRun ? TEXT(" (dry run, nothing saved)") : TEXT(""));
+
+    return NumFailed == 0 ? 0 : 1;
+#else
+    UE_LOG(LogCrustyPirate, Error, TEXT("The tile bake needs the editor"));
+    return 1;
+#endif
+}
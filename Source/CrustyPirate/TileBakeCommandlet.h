@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "TileBakeCommandlet.generated.h"
+
+/**
+ * Bakes the tile maps and decorations of every level (see UTileBakeSubsystem) and saves them as a UTileBakeData
+ * next to the levels, the levels themselves are not changed:
+ *   UnrealEditor-Cmd CrustyPirate.uproject -run=TileBake [-Path=/Game/Levels] [-ChunkSize=32] [-DryRun]
+ * Run it again after editing a level, the game bakes a level whose bake is out of date at runtime instead.
+ * Prints the number of tiles, chunks and decorations baked for every level.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UTileBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,247 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileBakeData.h"
+
+#include "Engine/Level.h"
+#include "GameFramework/Pawn.h"
+#include "PaperTileMap.h"
+#include "PaperTileLayer.h"
+#include "PaperTileSet.h"
+#include "PaperTileMapComponent.h"
+#include "PaperFlipbookComponent.h"
+#include "PaperFlipbook.h"
+#include "PaperSprite.h"
+#include "Paper2DModule.h"
+
+#include "CrustyPirate.h"
+#include "CollectableItem.h"
+#include "LevelExit.h"
+
+// Tile layers with this in their name are changed at runtime and keep being drawn by their tile map
+static const TCHAR* DynamicLayerMarker = TEXT("Dynamic");
+
+FString UTileBakeData::GetPackageName(const FString& LevelName)
+{
+    return FString::Printf(TEXT("/Game/Levels/TileBakes/%s_TileBake"), *LevelName);
+}
+
+UPaperTileMapComponent* UTileBakeData::FindTileMapComponent(ULevel* Level, const FTileMapBake& Bake)
+{
+    AActor* Actor = FindObjectFast<AActor>(Level, Bake.ActorName);
+    return Actor ? FindObjectFast<UPaperTileMapComponent>(Actor, Bake.ComponentName) : nullptr;
+}
+
+UPaperFlipbookComponent* UTileBakeData::FindDecorationComponent(ULevel* Level, const FDecorationBake& Bake)
+{
+    AActor* Actor = FindObjectFast<AActor>(Level, Bake.ActorName);
+    return Actor ? FindObjectFast<UPaperFlipbookComponent>(Actor, Bake.ComponentName) : nullptr;
+}
+
+void UTileBakeData::Build(ULevel* Level, int InChunkSize)
+{
+    LLM_SCOPE_BYTAG(CrustyPirate_TileMaps);
+
+    ChunkSize = FMath::Max(InChunkSize, 1);
+
+    for (AActor* Actor : Level->Actors)
+    {
+        if (!IsValid(Actor)) continue;
+
+        TInlineComponentArray<UPaperTileMapComponent*> Components(Actor);
+        for (UPaperTileMapComponent* Component : Components)
+        {
+            BuildTileMap(Component);
+        }
+    }
+
+    BuildDecorations(Level);
+}
+
+void UTileBakeData::BuildTileMap(UPaperTileMapComponent* Component)
+{
+    UPaperTileMap* TileMap = Component ? Component->TileMap : nullptr;
+    if (!TileMap || !Component->IsVisible()) return;
+
+    const int Width = TileMap->MapWidth;
+    const int Height = TileMap->MapHeight;
+    const int NumChunksX = FMath::DivideAndRoundUp(Width, ChunkSize);
+    const int NumChunksY = FMath::DivideAndRoundUp(Height, ChunkSize);
+
+    FTileMapBake& Bake = TileMaps.AddDefaulted_GetRef();
+    Bake.ActorName = Component->GetOwner()->GetFName();
+    Bake.ComponentName = Component->GetFName();
+    // A tile map made editable in the level belongs to the level package, only its size is checked
+    Bake.TileMap = TileMap->IsAsset() ? TileMap : nullptr;
+    Bake.MapWidth = Width;
+    Bake.MapHeight = Height;
+    Bake.NumLayers = TileMap->TileLayers.Num();
+    Bake.Chunks.SetNum(NumChunksX * NumChunksY);
+
+    TSet<UTexture*> LayerTextures;
+
+    for (int LayerIndex = 0; LayerIndex < TileMap->TileLayers.Num(); LayerIndex++)
+    {
+        const UPaperTileLayer* Layer = TileMap->TileLayers[LayerIndex];
+        if (!Layer || !Layer->ShouldRenderInGame()) continue;
+
+        const bool IsDynamic = Layer->LayerName.ToString().Contains(DynamicLayerMarker);
+        const FColor Color = (Layer->GetLayerColor() * Component->GetTileMapColor()).ToFColor(false);
+
+        LayerTextures.Reset();
+        for (int Y = 0; Y < Height; Y++)
+        {
+            for (int X = 0; X < Width; X++)
+            {
+                const FPaperTileInfo Tile = Layer->GetCell(X, Y);
+                if (!Tile.IsValid()) continue;
+
+                UTexture2D* Texture = Tile.TileSet->GetTileSheetTexture();
+                FVector2D TileUV;
+                if (!Texture || !Tile.TileSet->GetTileUV(Tile.GetTileIndex(), TileUV)) continue;
+
+                // Paper2D draws the tiles of a layer in one batch per texture
+                LayerTextures.Add(Texture);
+                if (IsDynamic) continue;
+
+                NumBakedTiles++;
+
+                const FIntPoint TileSize = Tile.TileSet->GetTileSize();
+                const FVector2D TextureSize(Texture->GetSurfaceWidth(), Texture->GetSurfaceHeight());
+                const float SizeX = (float)TileSize.X / TileMap->TileWidth;
+                const float SizeY = (float)TileSize.Y / TileMap->TileHeight;
+
+                // Corners in the order top left, top right, bottom right, bottom left
+                const FVector Corners[4] =
+                {
+                    TileMap->GetTilePositionInLocalSpace(X, Y, LayerIndex),
+                    TileMap->GetTilePositionInLocalSpace(X + SizeX, Y, LayerIndex),
+                    TileMap->GetTilePositionInLocalSpace(X + SizeX, Y + SizeY, LayerIndex),
+                    TileMap->GetTilePositionInLocalSpace(X, Y + SizeY, LayerIndex)
+                };
+                FVector2D CornerUVs[4] =
+                {
+                    TileUV / TextureSize,
+                    FVector2D(TileUV.X + TileSize.X, TileUV.Y) / TextureSize,
+                    (TileUV + FVector2D(TileSize)) / TextureSize,
+                    FVector2D(TileUV.X, TileUV.Y + TileSize.Y) / TextureSize
+                };
+                if (Tile.HasFlag(EPaperTileFlags::FlipDiagonal))
+                {
+                    Swap(CornerUVs[1], CornerUVs[3]);
+                }
+                if (Tile.HasFlag(EPaperTileFlags::FlipHorizontal))
+                {
+                    Swap(CornerUVs[0], CornerUVs[1]);
+                    Swap(CornerUVs[2], CornerUVs[3]);
+                }
+                if (Tile.HasFlag(EPaperTileFlags::FlipVertical))
+                {
+                    Swap(CornerUVs[0], CornerUVs[3]);
+                    Swap(CornerUVs[1], CornerUVs[2]);
+                }
+
+                FTileBakeChunk& Chunk = Bake.Chunks[(Y / ChunkSize) * NumChunksX + X / ChunkSize];
+                int SectionIndex = Chunk.Textures.IndexOfByKey(Texture);
+                if (SectionIndex == INDEX_NONE)
+                {
+                    SectionIndex = Chunk.Textures.Add(Texture);
+                    Chunk.Sections.AddDefaulted();
+                }
+
+                FProcMeshSection& Section = Chunk.Sections[SectionIndex];
+                const uint32 FirstVertex = Section.ProcVertexBuffer.Num();
+                for (int Corner = 0; Corner < 4; Corner++)
+                {
+                    FProcMeshVertex& Vertex = Section.ProcVertexBuffer.AddDefaulted_GetRef();
+                    Vertex.Position = Corners[Corner];
+                    Vertex.Normal = -PaperAxisZ;
+                    Vertex.UV0 = CornerUVs[Corner];
+                    Vertex.Color = Color;
+                    Section.SectionLocalBox += Vertex.Position;
+                }
+                Section.ProcIndexBuffer.Append({ FirstVertex, FirstVertex + 1, FirstVertex + 2, FirstVertex, FirstVertex + 2, FirstVertex + 3 });
+            }
+        }
+
+        NumTileSections += LayerTextures.Num();
+        if (IsDynamic)
+        {
+            NumLiveLayers++;
+            NumLiveSections += LayerTextures.Num();
+        }
+        else
+        {
+            Bake.BakedLayers.Add(LayerIndex);
+        }
+    }
+
+    Bake.Chunks.RemoveAll([](const FTileBakeChunk& Chunk) { return Chunk.Sections.Num() == 0; });
+}
+
+void UTileBakeData::BuildDecorations(ULevel* Level)
+{
+    for (AActor* Actor : Level->Actors)
+    {
+        if (!IsValid(Actor)) continue;
+
+        // Characters and gameplay actors change their flipbooks at runtime
+        if (Actor->IsA<APawn>() || Actor->IsA<ACollectableItem>() || Actor->IsA<ALevelExit>()) continue;
+
+        TInlineComponentArray<UPaperFlipbookComponent*> Components(Actor);
+        for (UPaperFlipbookComponent* Component : Components)
+        {
+            UPaperFlipbook* Flipbook = Component->GetFlipbook();
+            if (!Flipbook || !Component->IsVisible()) continue;
+
+            NumDecorations++;
+
+            const bool IsAnimated = Flipbook->GetNumFrames() > 1 && Component->GetPlayRate() != 0.0f;
+            UPaperSprite* Sprite = Flipbook->GetSpriteAtFrame(0);
+            if (IsAnimated || !Sprite) continue;
+
+            FDecorationBake& Bake = Decorations.AddDefaulted_GetRef();
+            Bake.ActorName = Actor->GetFName();
+            Bake.ComponentName = Component->GetFName();
+            Bake.Flipbook = Flipbook;
+            Bake.Sprite = Sprite;
+        }
+    }
+}
+
+bool UTileBakeData::IsUpToDate(ULevel* Level) const
+{
+    int NumTileMaps = 0;
+    for (AActor* Actor : Level->Actors)
+    {
+        if (!IsValid(Actor)) continue;
+
+        TInlineComponentArray<UPaperTileMapComponent*> Components(Actor);
+        for (const UPaperTileMapComponent* Component : Components)
+        {
+            if (Component->TileMap && Component->IsVisible())
+            {
+                NumTileMaps++;
+            }
+        }
+    }
+    if (NumTileMaps != TileMaps.Num()) return false;
+
+    for (const FTileMapBake& Bake : TileMaps)
+    {
+        const UPaperTileMapComponent* Component = FindTileMapComponent(Level, Bake);
+        const UPaperTileMap* TileMap = Component ? Component->TileMap : nullptr;
+        if (!TileMap || !Component->IsVisible()) return false;
+
+        const bool IsSameTileMap = Bake.TileMap ? TileMap == Bake.TileMap : !TileMap->IsAsset();
+        if (!IsSameTileMap || TileMap->MapWidth != Bake.MapWidth || TileMap->MapHeight != Bake.MapHeight || TileMap->TileLayers.Num() != Bake.NumLayers) return false;
+    }
+
+    for (const FDecorationBake& Bake : Decorations)
+    {
+        const UPaperFlipbookComponent* Component = FindDecorationComponent(Level, Bake);
+        if (!Component || Component->GetFlipbook() != Bake.Flipbook || !Component->IsVisible()) return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ProceduralMeshComponent.h"
+
+#include "TileBakeData.generated.h"
+
+class ULevel;
+class UTexture;
+class UPaperTileMap;
+class UPaperTileMapComponent;
+class UPaperFlipbookComponent;
+class UPaperFlipbook;
+class UPaperSprite;
+
+// One chunk of baked tiles, with one section per tile sheet texture
+USTRUCT()
+struct FTileBakeChunk
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TArray<FProcMeshSection> Sections;
+
+    // The texture of every section
+    UPROPERTY()
+    TArray<TObjectPtr<UTexture>> Textures;
+};
+
+// The baked layers of a tile map component, found again in the level by the names of its actor and component
+USTRUCT()
+struct FTileMapBake
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    FName ActorName;
+
+    UPROPERTY()
+    FName ComponentName;
+
+    // The tile map drawn by the component when it was baked
+    UPROPERTY()
+    TObjectPtr<UPaperTileMap> TileMap;
+
+    UPROPERTY()
+    int MapWidth = 0;
+
+    UPROPERTY()
+    int MapHeight = 0;
+
+    UPROPERTY()
+    int NumLayers = 0;
+
+    UPROPERTY()
+    TArray<int> BakedLayers;
+
+    UPROPERTY()
+    TArray<FTileBakeChunk> Chunks;
+};
+
+// A decoration drawn by the grouped sprite component of the level instead of its flipbook component, where the
+// component is when the level is added to the world
+USTRUCT()
+struct FDecorationBake
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    FName ActorName;
+
+    UPROPERTY()
+    FName ComponentName;
+
+    // The flipbook of the component when it was baked
+    UPROPERTY()
+    TObjectPtr<UPaperFlipbook> Flipbook;
+
+    UPROPERTY()
+    TObjectPtr<UPaperSprite> Sprite;
+};
+
+/**
+ * The baked tile chunks and decorations of one level (see UTileBakeSubsystem). Saved next to the levels by
+ * UTileBakeCommandlet so the game only has to apply them, the subsystem builds one at runtime for a level
+ * without one.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UTileBakeData : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+    // Package of the bake data of a level, by the short name of the level package
+    static FString GetPackageName(const FString& LevelName);
+
+    // Bake the visible tile maps and static decorations of the level, the level is not changed
+    void Build(ULevel* Level, int InChunkSize);
+
+    // Whether the tile maps and decorations of the level are still the ones that were baked
+    bool IsUpToDate(ULevel* Level) const;
+
+    // The components of the level the bakes were made from, null when they are gone
+    static UPaperTileMapComponent* FindTileMapComponent(ULevel* Level, const FTileMapBake& Bake);
+    static UPaperFlipbookComponent* FindDecorationComponent(ULevel* Level, const FDecorationBake& Bake);
+
+    // Every visible tile map, including those without a baked layer
+    UPROPERTY()
+    TArray<FTileMapBake> TileMaps;
+
+    UPROPERTY()
+    TArray<FDecorationBake> Decorations;
+
+    UPROPERTY()
+    int ChunkSize = 0;
+
+    // Before baking
+    UPROPERTY()
+    int NumTileSections = 0;
+
+    UPROPERTY()
+    int NumDecorations = 0;
+
+    // Left to the tile maps
+    UPROPERTY()
+    int NumLiveLayers = 0;
+
+    UPROPERTY()
+    int NumLiveSections = 0;
+
+    UPROPERTY()
+    int NumBakedTiles = 0;
+
+private:
+    void BuildTileMap(UPaperTileMapComponent* Component);
+    void BuildDecorations(ULevel* Level);
+};
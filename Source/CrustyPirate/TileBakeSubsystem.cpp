@@ -0,0 +1,276 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileBakeSubsystem.h"
+
+#include "Engine/Level.h"
+#include "Misc/PackageName.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "ProceduralMeshComponent.h"
+#include "PaperTileMap.h"
+#include "PaperTileLayer.h"
+#include "PaperTileMapComponent.h"
+#include "PaperFlipbookComponent.h"
+#include "PaperSprite.h"
+
+#include "CrustyPirate.h"
+#include "BakedDecorations.h"
+#include "TileBakeData.h"
+
+static TAutoConsoleVariable<bool> CVarTileBakeEnabled(
+    TEXT("CrustyPirate.TileBake.Enabled"),
+    false,
+    TEXT("Draw the static tile layers and decorations of a level with chunk meshes when it starts, from its saved bake or baked at runtime."));
+
+static TAutoConsoleVariable<int32> CVarTileBakeChunkSize(
+    TEXT("CrustyPirate.TileBake.ChunkSize"),
+    32,
+    TEXT("Width and height in tiles of the tile chunks baked at runtime (the TileBake commandlet takes -ChunkSize=)."));
+
+static FAutoConsoleCommandWithWorld TileBakeReportCommand(
+    TEXT("CrustyPirate.TileBake.Report"),
+    TEXT("Print the primitive and section counts of the tile maps and decorations before and after baking."),
+    FConsoleCommandWithWorldDelegate::CreateStatic(&UTileBakeSubsystem::PrintReport));
+
+// The texture parameter of the Paper2D sprite materials
+static const FName SpriteTextureParameterName("SpriteTexture");
+
+void UTileBakeSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+
+    if (!CVarTileBakeEnabled.GetValueOnGameThread()) return;
+
+    // Streamed sublevels are added to the world after it begins play
+    LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UTileBakeSubsystem::OnLevelAddedToWorld);
+
+    for (ULevel* Level : InWorld.GetLevels())
+    {
+        if (Level && Level->bIsVisible)
+        {
+            BakeLevel(Level);
+        }
+    }
+}
+
+void UTileBakeSubsystem::Deinitialize()
+{
+    FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+
+    Super::Deinitialize();
+}
+
+void UTileBakeSubsystem::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+    if (World == GetWorld() && Level)
+    {
+        BakeLevel(Level);
+    }
+}
+
+void UTileBakeSubsystem::BakeLevel(ULevel* Level)
+{
+    const double StartTime = FPlatformTime::Seconds();
+
+    FLevelBake Bake;
+    Bake.LevelName = FPackageName::GetShortName(UWorld::RemovePIEPrefix(Level->GetOutermost()->GetName()));
+
+    UTileBakeData* BakeData = LoadBakeData(Level, Bake.LevelName);
+    Bake.IsLoaded = BakeData != nullptr;
+    if (!BakeData)
+    {
+        BakeData = NewObject<UTileBakeData>(this);
+        BakeData->Build(Level, CVarTileBakeChunkSize.GetValueOnGameThread());
+    }
+
+    for (const FTileMapBake& TileMapBake : BakeData->TileMaps)
+    {
+        ApplyTileMap(Level, TileMapBake, Bake);
+    }
+
+    ApplyDecorations(Level, *BakeData, Bake);
+
+    Bake.NumTileMaps = BakeData->TileMaps.Num();
+    Bake.NumTileSections = BakeData->NumTileSections;
+    Bake.NumDecorations = BakeData->NumDecorations;
+    Bake.NumLiveLayers = BakeData->NumLiveLayers;
+    Bake.NumLiveSections = BakeData->NumLiveSections;
+    Bake.NumBakedTiles = BakeData->NumBakedTiles;
+    Bake.BakeTime = FPlatformTime::Seconds() - StartTime;
+
+    const int Index = LevelBakes.IndexOfByPredicate([&Bake](const FLevelBake& Other) { return Other.LevelName == Bake.LevelName; });
+    if (Index != INDEX_NONE)
+    {
+        LevelBakes[Index] = Bake;
+    }
+    else
+    {
+        LevelBakes.Add(Bake);
+    }
+}
+
+UTileBakeData* UTileBakeSubsystem::LoadBakeData(ULevel* Level, const FString& LevelName)
+{
+    const FString PackageName = UTileBakeData::GetPackageName(LevelName);
+    if (!FPackageName::DoesPackageExist(PackageName)) return nullptr;
+
+    UTileBakeData* BakeData = LoadObject<UTileBakeData>(nullptr, *FString::Printf(TEXT("%s.%s"), *PackageName, *FPackageName::GetShortName(PackageName)));
+    if (BakeData && !BakeData->IsUpToDate(Level))
+    {
+        UE_LOG(LogCrustyPirate, Warning, TEXT("The tile bake of %s does not match the level anymore, it is baked again at runtime (run the TileBake commandlet)"), *LevelName);
+        return nullptr;
+    }
+    return BakeData;
+}
+
+void UTileBakeSubsystem::ApplyTileMap(ULevel* Level, const FTileMapBake& TileMapBake, FLevelBake& Bake)
+{
+    LLM_SCOPE_BYTAG(CrustyPirate_TileMaps);
+
+    UPaperTileMapComponent* Component = UTileBakeData::FindTileMapComponent(Level, TileMapBake);
+    if (!Component || !Component->TileMap) return;
+
+    if (TileMapBake.BakedLayers.Num() == 0)
+    {
+        Bake.NumLiveTileMaps++;
+        return;
+    }
+
+    // The chunks follow the tile map component, so the tile positions are already in their space
+    AActor* Owner = Component->GetOwner();
+    UMaterialInterface* BaseMaterial = Component->GetMaterial(0);
+    for (const FTileBakeChunk& Chunk : TileMapBake.Chunks)
+    {
+        UProceduralMeshComponent* ChunkMesh = NewObject<UProceduralMeshComponent>(Owner, NAME_None, RF_Transient);
+        ChunkMesh->SetupAttachment(Component);
+        ChunkMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+        ChunkMesh->SetGenerateOverlapEvents(false);
+        ChunkMesh->SetCastShadow(false);
+        ChunkMesh->RegisterComponent();
+
+        for (int SectionIndex = 0; SectionIndex < Chunk.Sections.Num(); SectionIndex++)
+        {
+            ChunkMesh->SetProcMeshSection(SectionIndex, Chunk.Sections[SectionIndex]);
+            ChunkMesh->SetMaterial(SectionIndex, GetTileMaterial(BaseMaterial, Chunk.Textures[SectionIndex]));
+        }
+
+        Bake.NumChunks++;
+        Bake.NumChunkSections += Chunk.Sections.Num();
+    }
+
+    if (TileMapBake.BakedLayers.Num() == TileMapBake.NumLayers)
+    {
+        // Nothing left to draw, the component is only kept for its collision
+        Component->SetVisibility(false);
+        return;
+    }
+
+    // Clear the baked layers of a copy of the tile map owned by the component (the asset is left as it is)
+    Bake.NumLiveTileMaps++;
+    Component->MakeTileMapEditable();
+    for (int LayerIndex : TileMapBake.BakedLayers)
+    {
+        UPaperTileLayer* Layer = Component->TileMap->TileLayers[LayerIndex];
+        for (int Y = 0; Y < TileMapBake.MapHeight; Y++)
+        {
+            for (int X = 0; X < TileMapBake.MapWidth; X++)
+            {
+                Layer->SetCell(X, Y, FPaperTileInfo());
+            }
+        }
+    }
+    Component->MarkRenderStateDirty();
+}
+
+void UTileBakeSubsystem::ApplyDecorations(ULevel* Level, const UTileBakeData& BakeData, FLevelBake& Bake)
+{
+    LLM_SCOPE_BYTAG(CrustyPirate_TileMaps);
+
+    TSet<UTexture*> DecorationTextures;
+    ABakedDecorations* BakedDecorations = nullptr;
+
+    for (const FDecorationBake& DecorationBake : BakeData.Decorations)
+    {
+        UPaperFlipbookComponent* Component = UTileBakeData::FindDecorationComponent(Level, DecorationBake);
+        if (!Component || !DecorationBake.Sprite) continue;
+
+        if (!BakedDecorations)
+        {
+            FActorSpawnParameters SpawnParameters;
+            SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+            SpawnParameters.OverrideLevel = Level;
+            BakedDecorations = GetWorld()->SpawnActor<ABakedDecorations>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParameters);
+            if (!BakedDecorations) return;
+        }
+
+        // Placed where the component is now, the level may have been added to the world with an offset
+        BakedDecorations->Decorations->AddInstance(Component->GetComponentTransform(), DecorationBake.Sprite, true, Component->GetSpriteColor());
+        DecorationTextures.Add(DecorationBake.Sprite->GetBakedTexture());
+        Bake.NumBakedDecorations++;
+
+        Component->SetVisibility(false);
+        Component->SetComponentTickEnabled(false);
+    }
+
+    Bake.NumDecorationTextures = DecorationTextures.Num();
+}
+
+UMaterialInterface* UTileBakeSubsystem::GetTileMaterial(UMaterialInterface* BaseMaterial, UTexture* Texture)
+{
+    if (UMaterialInstanceDynamic** Found = TileMaterialLookup.Find(TPair<UMaterialInterface*, UTexture*>(BaseMaterial, Texture)))
+    {
+        return *Found;
+    }
+
+    UMaterialInstanceDynamic* Material = UMaterialInstanceDynamic::Create(BaseMaterial, this);
+    if (!Material) return BaseMaterial;
+
+    Material->SetTextureParameterValue(SpriteTextureParameterName, Texture);
+    TileMaterials.Add(Material);
+    TileMaterialLookup.Add(TPair<UMaterialInterface*, UTexture*>(BaseMaterial, Texture), Material);
+    return Material;
+}
+
+void UTileBakeSubsystem::PrintReport(UWorld* World)
+{
+    const UTileBakeSubsystem* TileBake = World ? World->GetSubsystem<UTileBakeSubsystem>() : nullptr;
+    if (!TileBake) return;
+
+    if (TileBake->LevelBakes.Num() == 0)
+    {
+        UE_LOG(LogCrustyPirate, Display, TEXT("Tile bake: %s was not baked (set CrustyPirate.TileBake.Enabled to 1 before loading it)"), *World->GetMapName());
+        return;
+    }
+
+    double TotalBakeTime = 0.0;
+    for (const FLevelBake& Bake : TileBake->LevelBakes)
+    {
+        const int NumPrimitivesBefore = Bake.NumTileMaps + Bake.NumDecorations;
+        const int NumSectionsBefore = Bake.NumTileSections + Bake.NumDecorations;
+        const int NumPrimitivesAfter = Bake.NumLiveTileMaps + Bake.NumChunks + (Bake.NumDecorations - Bake.NumBakedDecorations) + (Bake.NumBakedDecorations > 0 ? 1 : 0);
+        const int NumSectionsAfter = Bake.NumLiveSections + Bake.NumChunkSections + (Bake.NumDecorations - Bake.NumBakedDecorations) + Bake.NumDecorationTextures;
+
+        UE_LOG(LogCrustyPirate, Display, TEXT("Tile bake of %s %s in %.1f ms: %d primitives / %d sections before, %d primitives / %d sections after (%d tiles in %d chunks, %d live layers, %d of %d decorations batched)"),
+               *Bake.LevelName,
+               Bake.IsLoaded ? TEXT("loaded and applied") : TEXT("built at runtime"),
+               Bake.BakeTime * 1000.0,
+               NumPrimitivesBefore,
+               NumSectionsBefore,
+               NumPrimitivesAfter,
+               NumSectionsAfter,
+               Bake.NumBakedTiles,
+               Bake.NumChunks,
+               Bake.NumLiveLayers,
+               Bake.NumBakedDecorations,
+               Bake.NumDecorations);
+
+        TotalBakeTime += Bake.BakeTime;
+    }
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Tile bake: %d levels baked in %.1f ms"), TileBake->LevelBakes.Num(), TotalBakeTime * 1000.0);
+}
+
+bool UTileBakeSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
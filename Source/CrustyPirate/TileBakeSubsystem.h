@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "TileBakeSubsystem.generated.h"
+
+class ULevel;
+class UMaterialInterface;
+class UMaterialInstanceDynamic;
+class UTexture;
+class ABakedDecorations;
+class UTileBakeData;
+struct FTileMapBake;
+
+/**
+ * Draws the parts of the level that never change with baked meshes when it starts (enabled with
+ * "CrustyPirate.TileBake.Enabled"), and those of every sublevel when it is added to the world.
+ * The tile layers of every tile map are turned into procedural mesh chunks of ChunkSize x ChunkSize tiles with
+ * one section per tile sheet texture, and the tile map component only keeps drawing the layers whose name contains
+ * "Dynamic" (it is hidden when there are none, its collision stays). Flipbooks of actors that are not pawns or
+ * gameplay actors and only have one frame (or do not play) are drawn by one grouped sprite component per level instead.
+ * The bake is made ahead of time by UTileBakeCommandlet and saved as a UTileBakeData next to the levels, so a load
+ * only creates the chunk components from it. A level without one, or whose tile maps and decorations changed since,
+ * is baked at runtime the same way (with a warning for the out of date ones).
+ * "CrustyPirate.TileBake.Report" prints the time spent, whether the bake was loaded and the primitive and section
+ * counts before and after baking of every baked level.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UTileBakeSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+    virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+    virtual void Deinitialize() override;
+
+    static void PrintReport(UWorld* World);
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+    struct FLevelBake
+    {
+        FString LevelName;
+        double BakeTime = 0.0;
+        bool IsLoaded = false;
+
+        // Before baking
+        int NumTileMaps = 0;
+        int NumTileSections = 0;
+        int NumDecorations = 0;
+
+        // After baking
+        int NumChunks = 0;
+        int NumChunkSections = 0;
+        int NumLiveTileMaps = 0;
+        int NumLiveLayers = 0;
+        int NumLiveSections = 0;
+        int NumBakedTiles = 0;
+        int NumBakedDecorations = 0;
+        int NumDecorationTextures = 0;
+    };
+
+    void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+
+    void BakeLevel(ULevel* Level);
+
+    // The saved bake of the level, null when there is none or it is out of date
+    UTileBakeData* LoadBakeData(ULevel* Level, const FString& LevelName);
+
+    void ApplyTileMap(ULevel* Level, const FTileMapBake& TileMapBake, FLevelBake& Bake);
+
+    // The batched decorations are drawn by an actor spawned in the level, so they are unloaded along with it
+    void ApplyDecorations(ULevel* Level, const UTileBakeData& BakeData, FLevelBake& Bake);
+
+    // A material instance of the tile map material drawing the texture (shared by all the chunks)
+    UMaterialInterface* GetTileMaterial(UMaterialInterface* BaseMaterial, UTexture* Texture);
+
+    UPROPERTY()
+    TArray<TObjectPtr<UMaterialInstanceDynamic>> TileMaterials;
+
+    TMap<TPair<UMaterialInterface*, UTexture*>, UMaterialInstanceDynamic*> TileMaterialLookup;
+
+    FDelegateHandle LevelAddedHandle;
+
+    // The last bake of every level, a sublevel loaded again replaces its entry
+    TArray<FLevelBake> LevelBakes;
+};
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileCollisionBakeCommandlet.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "UObject/SavePackage.h"
+#include "Misc/PackageName.h"
+#include "PaperTileMap.h"
+
+#include "CrustyPirate.h"
+#include "TileCollisionMerge.h"
+
+int32 UTileCollisionBakeCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+    FString Path = TEXT("/Game/Assets/Tileset");
+    FParse::Value(*Params, TEXT("Path="), Path);
+    const bool IsDryRun = FParse::Param(*Params, TEXT("DryRun"));
+
+    IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+    AssetRegistry.SearchAllAssets(true);
+
+    TArray<FAssetData> TileMapAssets;
+    FARFilter Filter;
+    Filter.PackagePaths.Add(FName(*Path));
+    Filter.ClassPaths.Add(UPaperTileMap::StaticClass()->GetClassPathName());
+    Filter.bRecursivePaths = true;
+    AssetRegistry.GetAssets(Filter, TileMapAssets);
+
+    int NumFailed = 0;
+    int TotalBefore = 0;
+    int TotalAfter = 0;
+
+    for (const FAssetData& Asset : TileMapAssets)
+    {
+        UPaperTileMap* TileMap = Cast<UPaperTileMap>(Asset.GetAsset());
+        if (!TileMap) continue;
+
+        const FTileCollisionMerge::FResult Result = FTileCollisionMerge::MergeTileMapCollision(TileMap);
+        TotalBefore += Result.NumShapesBefore;
+        TotalAfter += Result.NumShapesAfter;
+
+        UE_LOG(LogCrustyPirate, Display, TEXT("%s: %d collision shapes merged into %d (%.0f%% fewer)"),
+               *TileMap->GetName(),
+               Result.NumShapesBefore,
+               Result.NumShapesAfter,
+               Result.NumShapesBefore > 0 ? 100.0f * (Result.NumShapesBefore - Result.NumShapesAfter) / Result.NumShapesBefore : 0.0f);
+
+        if (IsDryRun || Result.NumShapesAfter == Result.NumShapesBefore) continue;
+
+        UPackage* Package = TileMap->GetPackage();
+        Package->MarkPackageDirty();
+
+        const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+        FSavePackageArgs SaveArgs;
+        SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+        if (!UPackage::SavePackage(Package, TileMap, *Filename, SaveArgs))
+        {
+            UE_LOG(LogCrustyPirate, Error, TEXT("Could not save %s"), *Filename);
+            NumFailed++;
+        }
+    }
+
+    UE_LOG(LogCrustyPirate, Display, TEXT("Tile collision bake: %d tile maps, %d collision shapes merged into %d%s"),
+           TileMapAssets.Num(),
+           TotalBefore,
+           TotalAfter,
+           IsDryRun ? TEXT(" (dry run, nothing saved)") : TEXT(""));
+
+    return NumFailed == 0 ? 0 : 1;
+#else
+    UE_LOG(LogCrustyPirate, Error, TEXT("The tile collision bake needs the editor"));
+    return 1;
+#endif
+}
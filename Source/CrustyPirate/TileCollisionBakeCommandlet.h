@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "TileCollisionBakeCommandlet.generated.h"
+
+/**
+ * Merges the collision of the tile maps (see FTileCollisionMerge) and saves them:
+ *   UnrealEditor-Cmd CrustyPirate.uproject -run=TileCollisionBake [-Path=/Game/Assets/Tileset] [-DryRun]
+ * The cook merges the tile maps it saves by itself. Editing a tile map rebuilds its per tile collision, so run
+ * the commandlet again to have the editor and PIE use the merged collision.
+ * Prints the number of collision shapes of every tile map before and after the merge.
+ */
+UCLASS()
+class CRUSTYPIRATE_API UTileCollisionBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,280 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileCollisionMerge.h"
+
+#include "PaperTileMap.h"
+#include "PaperTileLayer.h"
+#include "PaperTileSet.h"
+#include "PaperTileMapComponent.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "EngineUtils.h"
+#include "Misc/DelayedAutoRegister.h"
+#if WITH_EDITOR
+#include "UObject/ObjectSaveContext.h"
+#endif
+
+#include "CrustyPirate.h"
+
+static FAutoConsoleCommandWithWorld TileCollisionValidateCommand(
+    TEXT("CrustyPirate.TileCollision.Validate"),
+    TEXT("Check the collision of every tile map in the world against its tiles and print the shape counts."),
+    FConsoleCommandWithWorldDelegate::CreateStatic(&FTileCollisionMerge::ValidateWorld));
+
+#if WITH_EDITOR
+// The cook merges the collision of every tile map it saves, so a build never ships the per tile boxes of a
+// tile map edited after the last run of the commandlet
+static void MergeTileMapCollisionOnCook(UObject* Object, FObjectPreSaveContext SaveContext)
+{
+    UPaperTileMap* TileMap = Cast<UPaperTileMap>(Object);
+    if (!TileMap || !SaveContext.IsCooking()) return;
+
+    const FTileCollisionMerge::FResult Result = FTileCollisionMerge::MergeTileMapCollision(TileMap);
+    if (Result.NumShapesAfter != Result.NumShapesBefore)
+    {
+        UE_LOG(LogCrustyPirate, Display, TEXT("Cooking %s: %d collision shapes merged into %d (run the TileCollisionBake commandlet to save them in the asset)"),
+               *TileMap->GetPathName(),
+               Result.NumShapesBefore,
+               Result.NumShapesAfter);
+    }
+}
+
+static FDelayedAutoRegisterHelper TileCollisionCookHook(EDelayedRegisterRunPhase::EndOfEngineInit, []()
+{
+    FCoreUObjectDelegates::OnObjectPreSave.AddStatic(&MergeTileMapCollisionOnCook);
+});
+#endif
+
+void FTileCollisionMerge::MergeCells(const TBitArray<>& IsSolid, int Width, int Height, TArray<FIntRect>& OutRects)
+{
+    TBitArray<> IsCovered(false, Width * Height);
+
+    for (int Y = 0; Y < Height; Y++)
+    {
+        for (int X = 0; X < Width; X++)
+        {
+            const int Index = Y * Width + X;
+            if (!IsSolid[Index] || IsCovered[Index]) continue;
+
+            // Grow along the row as far as possible
+            int RectWidth = 1;
+            while (X + RectWidth < Width && IsSolid[Index + RectWidth] && !IsCovered[Index + RectWidth])
+            {
+                RectWidth++;
+            }
+
+            // Then add the rows below while the whole span is solid
+            int RectHeight = 1;
+            while (Y + RectHeight < Height)
+            {
+                const int RowStart = (Y + RectHeight) * Width + X;
+                bool IsRowSolid = true;
+                for (int Offset = 0; Offset < RectWidth && IsRowSolid; Offset++)
+                {
+                    IsRowSolid = IsSolid[RowStart + Offset] && !IsCovered[RowStart + Offset];
+                }
+                if (!IsRowSolid) break;
+
+                RectHeight++;
+            }
+
+            for (int RectY = Y; RectY < Y + RectHeight; RectY++)
+            {
+                for (int RectX = X; RectX < X + RectWidth; RectX++)
+                {
+                    IsCovered[RectY * Width + RectX] = true;
+                }
+            }
+
+            OutRects.Add(FIntRect(X, Y, X + RectWidth, Y + RectHeight));
+        }
+    }
+}
+
+FTileCollisionMerge::FResult FTileCollisionMerge::MergeTileMapCollision(UPaperTileMap* TileMap)
+{
+    FResult Result;
+
+    UBodySetup* BodySetup = TileMap ? TileMap->BodySetup : nullptr;
+    if (!BodySetup) return Result;
+
+    FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+    Result.NumShapesBefore = AggGeom.GetElementCount();
+    Result.NumShapesAfter = Result.NumShapesBefore;
+
+    const int Width = TileMap->MapWidth;
+    const int Height = TileMap->MapHeight;
+    if (Width <= 0 || Height <= 0) return Result;
+
+    // Where the tiles are in the space of the body setup
+    const FVector Origin = TileMap->GetTileCenterInLocalSpace(0.0f, 0.0f, 0);
+    const float StepX = TileMap->GetTileCenterInLocalSpace(1.0f, 0.0f, 0).X - Origin.X;
+    const float StepZ = TileMap->GetTileCenterInLocalSpace(0.0f, 1.0f, 0).Z - Origin.Z;
+    const float TileWidth = FMath::Abs(StepX);
+    const float TileHeight = FMath::Abs(StepZ);
+    if (TileWidth < UE_KINDA_SMALL_NUMBER || TileHeight < UE_KINDA_SMALL_NUMBER) return Result;
+
+    // The tile boxes of every layer have their own depth (center and size along Y)
+    struct FLayerCells
+    {
+        float CenterY;
+        float SizeY;
+        TBitArray<> IsSolid;
+    };
+    TArray<FLayerCells> Layers;
+
+    TArray<FKBoxElem> KeptBoxes;
+    for (const FKBoxElem& Box : AggGeom.BoxElems)
+    {
+        const float CellX = (Box.Center.X - Origin.X) / StepX;
+        const float CellY = (Box.Center.Z - Origin.Z) / StepZ;
+        const int X = FMath::RoundToInt(CellX);
+        const int Y = FMath::RoundToInt(CellY);
+
+        const bool IsTileBox = Box.Rotation.IsNearlyZero()
+            && FMath::IsNearlyEqual((float)Box.X, TileWidth, 0.01f)
+            && FMath::IsNearlyEqual((float)Box.Z, TileHeight, 0.01f)
+            && FMath::IsNearlyEqual(CellX, (float)X, 0.01f)
+            && FMath::IsNearlyEqual(CellY, (float)Y, 0.01f)
+            && X >= 0 && X < Width && Y >= 0 && Y < Height;
+        if (!IsTileBox)
+        {
+            KeptBoxes.Add(Box);
+            continue;
+        }
+
+        FLayerCells* Layer = Layers.FindByPredicate([&Box](const FLayerCells& Other)
+        {
+            return FMath::IsNearlyEqual(Other.CenterY, (float)Box.Center.Y, 0.01f) && FMath::IsNearlyEqual(Other.SizeY, (float)Box.Y, 0.01f);
+        });
+        if (!Layer)
+        {
+            Layer = &Layers.AddDefaulted_GetRef();
+            Layer->CenterY = Box.Center.Y;
+            Layer->SizeY = Box.Y;
+            Layer->IsSolid.Init(false, Width * Height);
+        }
+
+        Layer->IsSolid[Y * Width + X] = true;
+    }
+
+    if (Layers.Num() == 0) return Result;
+
+    TArray<FIntRect> Rects;
+    for (const FLayerCells& Layer : Layers)
+    {
+        Rects.Reset();
+        MergeCells(Layer.IsSolid, Width, Height, Rects);
+
+        for (const FIntRect& Rect : Rects)
+        {
+            FKBoxElem& Box = KeptBoxes.AddDefaulted_GetRef();
+            Box.Center = FVector(
+                Origin.X + (Rect.Min.X + Rect.Max.X - 1) * 0.5f * StepX,
+                Layer.CenterY,
+                Origin.Z + (Rect.Min.Y + Rect.Max.Y - 1) * 0.5f * StepZ);
+            Box.X = Rect.Width() * TileWidth;
+            Box.Y = Layer.SizeY;
+            Box.Z = Rect.Height() * TileHeight;
+        }
+    }
+
+    AggGeom.BoxElems = MoveTemp(KeptBoxes);
+    BodySetup->InvalidatePhysicsData();
+    BodySetup->CreatePhysicsMeshes();
+
+    Result.NumShapesAfter = AggGeom.GetElementCount();
+    return Result;
+}
+
+int FTileCollisionMerge::ValidateTileMapComponent(const UPaperTileMapComponent* Component, int& OutNumTilesChecked)
+{
+    OutNumTilesChecked = 0;
+
+    const UPaperTileMap* TileMap = Component ? Component->TileMap : nullptr;
+    if (!TileMap || !Component->IsCollisionEnabled()) return 0;
+
+    const int Width = TileMap->MapWidth;
+    const int Height = TileMap->MapHeight;
+
+    // What the tiles of all the colliding layers say about every cell: 0 empty, 1 whole tile solid, 2 partly solid
+    TArray<uint8> CellStates;
+    CellStates.SetNumZeroed(Width * Height);
+
+    for (const UPaperTileLayer* Layer : TileMap->TileLayers)
+    {
+        if (!Layer || !Layer->ShouldLayerCollide()) continue;
+
+        for (int Y = 0; Y < Height; Y++)
+        {
+            for (int X = 0; X < Width; X++)
+            {
+                const FPaperTileInfo Tile = Layer->GetCell(X, Y);
+                if (!Tile.IsValid()) continue;
+
+                const FPaperTileMetadata* Metadata = Tile.TileSet->GetTileMetadata(Tile.GetTileIndex());
+                if (!Metadata || !Metadata->HasCollision()) continue;
+
+                const FIntPoint TileSize = Tile.TileSet->GetTileSize();
+                const FSpriteGeometryCollection& Collision = Metadata->CollisionData;
+                const bool IsWholeTile = Collision.Shapes.Num() == 1
+                    && Collision.Shapes[0].ShapeType == ESpriteShapeType::Box
+                    && Collision.Shapes[0].BoxSize.Equals(FVector2D(TileSize), 0.01f)
+                    && Collision.Shapes[0].BoxPosition.Equals(FVector2D(TileSize) * 0.5f, 0.01f);
+
+                uint8& State = CellStates[Y * Width + X];
+                State = FMath::Max<uint8>(State, IsWholeTile ? 1 : 2);
+            }
+        }
+    }
+
+    const FTransform& ComponentTransform = Component->GetComponentTransform();
+    const FVector TileExtent(TileMap->TileWidth * 0.25f, 10000.0f, TileMap->TileHeight * 0.25f);
+    const FCollisionShape Probe = FCollisionShape::MakeBox(TileExtent * ComponentTransform.GetScale3D().GetAbs());
+
+    int NumMismatches = 0;
+    for (int Y = 0; Y < Height; Y++)
+    {
+        for (int X = 0; X < Width; X++)
+        {
+            const uint8 State = CellStates[Y * Width + X];
+            if (State == 2) continue;
+
+            const FVector Location = ComponentTransform.TransformPosition(TileMap->GetTileCenterInLocalSpace(X, Y, 0));
+            const bool IsSolid = Component->OverlapComponent(Location, ComponentTransform.GetRotation(), Probe);
+
+            OutNumTilesChecked++;
+            if (IsSolid != (State == 1))
+            {
+                NumMismatches++;
+            }
+        }
+    }
+
+    return NumMismatches;
+}
+
+void FTileCollisionMerge::ValidateWorld(UWorld* World)
+{
+    if (!World) return;
+
+    for (TActorIterator<AActor> It(World); It; ++It)
+    {
+        TInlineComponentArray<UPaperTileMapComponent*> Components(*It);
+        for (const UPaperTileMapComponent* Component : Components)
+        {
+            if (!Component->TileMap) continue;
+
+            int NumTilesChecked = 0;
+            const int NumMismatches = ValidateTileMapComponent(Component, NumTilesChecked);
+            const UBodySetup* BodySetup = Component->TileMap->BodySetup;
+
+            UE_LOG(LogCrustyPirate, Display, TEXT("Tile collision of %s (%s): %d shapes, %d tiles checked, %d do not match"),
+                   *Component->TileMap->GetName(),
+                   *It->GetName(),
+                   BodySetup ? BodySetup->AggGeom.GetElementCount() : 0,
+                   NumTilesChecked,
+                   NumMismatches);
+        }
+    }
+}
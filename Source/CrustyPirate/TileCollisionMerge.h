@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UPaperTileMap;
+class UPaperTileMapComponent;
+
+/**
+ * Merges the collision of tile maps. Paper2D builds one box per solid tile. The boxes covering a whole tile
+ * are put back on the tile grid and replaced by as few boxes as possible (greedy: every box is grown along X,
+ * then along Z). Partial tiles (slopes, thin platforms) and convex shapes are kept as they are.
+ * The cook runs the merge on every tile map it saves, UTileCollisionBakeCommandlet runs it on the tile map assets
+ * and saves them so the editor uses the merged collision too, and "CrustyPirate.TileCollision.Validate" checks
+ * the collision of the tile maps in the world against their tiles.
+ */
+class CRUSTYPIRATE_API FTileCollisionMerge
+{
+public:
+    struct FResult
+    {
+        int NumShapesBefore = 0;
+        int NumShapesAfter = 0;
+    };
+
+    // Cover the solid cells (row major, Width * Height) with rectangles, Max is exclusive
+    static void MergeCells(const TBitArray<>& IsSolid, int Width, int Height, TArray<FIntRect>& OutRects);
+
+    // Replace the tile sized boxes of the body setup of the tile map by merged boxes
+    static FResult MergeTileMapCollision(UPaperTileMap* TileMap);
+
+    // Test the middle of every tile of the component against its collision. Returns the number of tiles whose
+    // collision does not match (tiles with partial collision are not checked)
+    static int ValidateTileMapComponent(const UPaperTileMapComponent* Component, int& OutNumTilesChecked);
+
+    static void ValidateWorld(UWorld* World);
+};
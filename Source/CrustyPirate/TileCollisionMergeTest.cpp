@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#include "TileCollisionMerge.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTileCollisionMergeCellsTest, "CrustyPirate.TileCollision.MergeCells",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Rows from the top (Y = 0) down, 'X' is a solid cell
+static TBitArray<> MakeCells(const TArray<const TCHAR*>& Rows, int& OutWidth, int& OutHeight)
+{
+    OutHeight = Rows.Num();
+    OutWidth = OutHeight > 0 ? FCString::Strlen(Rows[0]) : 0;
+
+    TBitArray<> IsSolid(false, OutWidth * OutHeight);
+    for (int Y = 0; Y < OutHeight; Y++)
+    {
+        for (int X = 0; X < OutWidth; X++)
+        {
+            IsSolid[Y * OutWidth + X] = Rows[Y][X] == TEXT('X');
+        }
+    }
+    return IsSolid;
+}
+
+// Merge the cells and check that the rectangles cover every solid cell exactly once and no empty one
+static void TestMerge(FAutomationTestBase& Test, const TCHAR* Name, const TArray<const TCHAR*>& Rows, int ExpectedNumRects)
+{
+    int Width, Height;
+    const TBitArray<> IsSolid = MakeCells(Rows, Width, Height);
+
+    TArray<FIntRect> Rects;
+    FTileCollisionMerge::MergeCells(IsSolid, Width, Height, Rects);
+    Test.TestEqual(FString::Printf(TEXT("%s: rectangles"), Name), Rects.Num(), ExpectedNumRects);
+
+    TArray<int> Coverage;
+    Coverage.SetNumZeroed(Width * Height);
+    for (const FIntRect& Rect : Rects)
+    {
+        const bool IsInside = Rect.Min.X >= 0 && Rect.Min.Y >= 0 && Rect.Max.X <= Width && Rect.Max.Y <= Height && Rect.Width() > 0 && Rect.Height() > 0;
+        if (!Test.TestTrue(FString::Printf(TEXT("%s: rectangle %s inside the grid"), Name, *Rect.ToString()), IsInside)) continue;
+
+        for (int Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+        {
+            for (int X = Rect.Min.X; X < Rect.Max.X; X++)
+            {
+                Coverage[Y * Width + X]++;
+            }
+        }
+    }
+
+    for (int Index = 0; Index < Width * Height; Index++)
+    {
+        const int Expected = IsSolid[Index] ? 1 : 0;
+        if (Coverage[Index] != Expected)
+        {
+            Test.AddError(FString::Printf(TEXT("%s: cell (%d, %d) covered %d times instead of %d"), Name, Index % Width, Index / Width, Coverage[Index], Expected));
+        }
+    }
+}
+
+bool FTileCollisionMergeCellsTest::RunTest(const FString& Parameters)
+{
+    TestMerge(*this, TEXT("Single cell"), {
+        TEXT("..."),
+        TEXT(".X."),
+        TEXT("...") }, 1);
+
+    TestMerge(*this, TEXT("Empty"), {
+        TEXT("...."),
+        TEXT("....") }, 0);
+
+    TestMerge(*this, TEXT("Full"), {
+        TEXT("XXXX"),
+        TEXT("XXXX"),
+        TEXT("XXXX") }, 1);
+
+    // The column is grown down first, the foot of the L is what is left of the bottom row
+    TestMerge(*this, TEXT("L-shape"), {
+        TEXT("X.."),
+        TEXT("X.."),
+        TEXT("XXX") }, 2);
+
+    // The top row, the columns left and right of the hole and the cells below it
+    TestMerge(*this, TEXT("Hole"), {
+        TEXT("XXXX"),
+        TEXT("X.XX"),
+        TEXT("XXXX"),
+        TEXT("XXXX") }, 4);
+
+    TestMerge(*this, TEXT("Holes"), {
+        TEXT("XXXXX"),
+        TEXT("X.X.X"),
+        TEXT("XXXXX"),
+        TEXT("X.X.X"),
+        TEXT("XXXXX") }, 8);
+
+    return true;
+}
+
+#endif